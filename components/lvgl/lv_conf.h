@@ -6,6 +6,8 @@
 
 #define LV_USE_DRAW_SW        1
 #define LV_COLOR_DEPTH        16
+/* ST7789 takes RGB565 big-endian; rendering swapped lets the flush send the buffer as it is */
+#define LV_COLOR_16_SWAP      1
 #define LV_TICK_CUSTOM        0
 #define LV_USE_LOG            0
 
@@ -0,0 +1,682 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "i2s.h"
+#include "audio_gain.h"
+#include "audio_biquad.h"
+#include "audio_format.h"
+#include "audio_eq.h"
+#include "audio_src.h"
+#include "audio_dither.h"
+#include "audio_loudness.h"
+#include "audio_dynamics.h"
+#include "audio_crossfeed.h"
+#include "audio_matrix.h"
+#include "audio_spectrum.h"
+#include "audio_meter.h"
+#include "audio_scope.h"
+#include "audio_wsola.h"
+#include "audio_graph.h"
+#include "audio_golden.h"
+#include "audio_bench.h"
+
+#define BENCH_SAMPLES (I2S_TX_BUFFER_LEN / 2)
+#define BENCH_ROUNDS 16
+// 音频线程一块一个扇区
+// the audio thread works one sector per block
+#define BENCH_BLOCK_FRAMES 588
+
+static const char *TAG = "audio_bench";
+
+static int16_t benchBuf[BENCH_SAMPLES];
+static int16_t refBuf[BENCH_SAMPLES];
+static int32_t benchBufS32[BENCH_SAMPLES];
+
+// 伪随机满幅测试信号, 每次生成结果一样
+// pseudo random full scale test signal, identical on every run
+static void fillTestSignal(int16_t *buf, uint32_t count)
+{
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        buf[i] = (int16_t)(seed >> 16);
+    }
+}
+
+static void bench_gain()
+{
+    const int32_t gain = 20349; // -4.1dB
+    uint32_t cycles = 0;
+
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        fillTestSignal(benchBuf, BENCH_SAMPLES);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        audio_gain_applyQ15(benchBuf, BENCH_SAMPLES, gain);
+        cycles += esp_cpu_get_cycle_count() - t0;
+    }
+
+    uint32_t refCycles = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        fillTestSignal(refBuf, BENCH_SAMPLES);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        audio_gain_applyQ15_ref(refBuf, BENCH_SAMPLES, gain);
+        refCycles += esp_cpu_get_cycle_count() - t0;
+    }
+
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    audio_gain_applyQ15(benchBuf, BENCH_SAMPLES, AUDIO_GAIN_UNITY_Q15);
+    uint32_t unityCycles = esp_cpu_get_cycle_count() - t0;
+
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+    audio_gain_applyQ15(benchBuf, BENCH_SAMPLES, gain);
+
+    ESP_LOGI(TAG, "gain q15: %lu cycles/buffer, ref %lu cycles/buffer, unity %lu cycles/buffer, %s",
+             cycles / BENCH_ROUNDS, refCycles / BENCH_ROUNDS, unityCycles,
+             memcmp(benchBuf, refBuf, sizeof(benchBuf)) == 0 ? "bit-identical" : "MISMATCH");
+}
+
+// 整个缓冲区都在渐变 vs 恒定增益
+// a ramp across the whole buffer vs a constant gain
+static void bench_gainRamp()
+{
+    audio_gain_t g;
+    uint32_t rampCycles = 0;
+    uint32_t constCycles = 0;
+
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        fillTestSignal(benchBuf, BENCH_SAMPLES);
+        audio_gain_init(&g, 3841, BENCH_SAMPLES / 2);
+        audio_gain_setTarget(&g, 25823);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        audio_gain_processQ15(&g, benchBuf, BENCH_SAMPLES / 2);
+        rampCycles += esp_cpu_get_cycle_count() - t0;
+
+        fillTestSignal(benchBuf, BENCH_SAMPLES);
+        audio_gain_init(&g, 25823, BENCH_SAMPLES / 2);
+        t0 = esp_cpu_get_cycle_count();
+        audio_gain_processQ15(&g, benchBuf, BENCH_SAMPLES / 2);
+        constCycles += esp_cpu_get_cycle_count() - t0;
+    }
+
+    ESP_LOGI(TAG, "gain ramp: %lu cycles/buffer, constant %lu cycles/buffer",
+             rampCycles / BENCH_ROUNDS, constCycles / BENCH_ROUNDS);
+}
+
+// 去加重, 含 16/32 位转换
+// de-emphasis, including the 16/32-bit conversion
+static void bench_deemphasis()
+{
+    audio_biquad_coef_t coef;
+    audio_biquad_t bq;
+    audio_biquad_designDeemphasis(&coef);
+    audio_biquad_init(&bq, &coef);
+
+    uint32_t cycles = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        fillTestSignal(benchBuf, BENCH_SAMPLES);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+        audio_biquad_processStereo(&bq, benchBufS32, BENCH_SAMPLES / 2);
+        audio_format_s32ToS16(benchBufS32, benchBuf, BENCH_SAMPLES);
+        cycles += esp_cpu_get_cycle_count() - t0;
+    }
+
+    ESP_LOGI(TAG, "de-emphasis: %lu cycles/buffer", cycles / BENCH_ROUNDS);
+}
+
+// 均衡器 1~5 段, 每段 +3dB, 不含交叉淡化那一块
+// EQ with 1 to 5 bands at +3dB each, not counting the crossfade block
+static void bench_eq()
+{
+    audio_eq_band_t saved[AUDIO_EQ_BANDS];
+    audio_eq_band_t bands[AUDIO_EQ_BANDS];
+    audio_eq_getBands(saved);
+
+    for (int n = 1; n <= AUDIO_EQ_BANDS; n++)
+    {
+        memcpy(bands, saved, sizeof(bands));
+        for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+            bands[i].gain = (i < n) ? 30 : 0;
+        audio_eq_setBands(bands);
+
+        fillTestSignal(benchBuf, BENCH_SAMPLES);
+        audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+        audio_eq_process(benchBufS32, BENCH_SAMPLES / 2);
+
+        uint32_t cycles = 0;
+        for (int r = 0; r < BENCH_ROUNDS; r++)
+        {
+            audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            audio_eq_process(benchBufS32, BENCH_SAMPLES / 2);
+            cycles += esp_cpu_get_cycle_count() - t0;
+        }
+
+        // 每秒 44100 帧, 占一个核的百分比
+        // 44100 frames per second, as a share of one core
+        uint32_t perBuffer = cycles / BENCH_ROUNDS;
+        ESP_LOGI(TAG, "eq %d band(s): %lu cycles/buffer, %lu cycles/frame, %lu.%02lu%% of a core",
+                 n, perBuffer, perBuffer / (BENCH_SAMPLES / 2),
+                 (uint32_t)((uint64_t)perBuffer * 44100 * 100 / (BENCH_SAMPLES / 2) / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000)),
+                 (uint32_t)((uint64_t)perBuffer * 44100 * 10000 / (BENCH_SAMPLES / 2) / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000) % 100));
+    }
+
+    audio_eq_setBands(saved);
+}
+
+// 重采样 44.1k -> 48k/96k, 各质量档位
+// resampling 44.1k -> 48k/96k at every quality tier
+static void bench_src()
+{
+    static const uint32_t rates[] = {48000, 96000};
+    static int32_t outS32[AUDIO_SRC_MAX_OUT(BENCH_SAMPLES / 2, 44100, 96000) * 2];
+
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+    audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+
+    for (int r = 0; r < 2; r++)
+    {
+        for (int q = AUDIO_SRC_LOW; q <= AUDIO_SRC_HIGH; q++)
+        {
+            audio_src_t src;
+            if (audio_src_init(&src, 44100, rates[r], q, BENCH_SAMPLES / 2) != ESP_OK)
+            {
+                ESP_LOGE(TAG, "src alloc fail");
+                return;
+            }
+
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            uint32_t outFrames = audio_src_process(&src, benchBufS32, BENCH_SAMPLES / 2, outS32, sizeof(outS32) / 8);
+            uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+            audio_src_deinit(&src);
+
+            ESP_LOGI(TAG, "src %ld quality %d: %lu cycles/buffer, %lu cycles/output frame",
+                     rates[r], q, cycles, cycles / outFrames);
+        }
+    }
+}
+
+// 不变调变速, 每个质量在最慢和最快两种速度下每个输出帧的周期数; 输入按块送进去, 和发送线程一样
+// pitch-keeping varispeed: cycles per output frame for each quality at the slowest and fastest
+// speed; input goes in block by block, as on the transmit task
+static void bench_varispeed()
+{
+    static const uint32_t speeds[] = {AUDIO_WSOLA_SPEED_MIN, AUDIO_WSOLA_SPEED_MAX};
+    static int32_t outS32[AUDIO_WSOLA_MAX_OUT(BENCH_BLOCK_FRAMES) * 2];
+
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+    audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+
+    audio_wsola_t wsola;
+    if (audio_wsola_init(&wsola, AUDIO_WSOLA_LOW, BENCH_BLOCK_FRAMES) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "wsola alloc fail");
+        return;
+    }
+
+    for (int q = AUDIO_WSOLA_LOW; q <= AUDIO_WSOLA_HIGH; q++)
+    {
+        for (int s = 0; s < 2; s++)
+        {
+            audio_wsola_setQuality(&wsola, q);
+            audio_wsola_setSpeed(&wsola, speeds[s]);
+
+            uint32_t outFrames = 0;
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            for (int r = 0; r < 4; r++)
+                for (int b = 0; b < BENCH_SAMPLES / 2; b += BENCH_BLOCK_FRAMES)
+                    outFrames += audio_wsola_process(&wsola, benchBufS32 + b * 2, BENCH_BLOCK_FRAMES, outS32, AUDIO_WSOLA_MAX_OUT(BENCH_BLOCK_FRAMES));
+            uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+
+            uint32_t perFrame = cycles / outFrames;
+            ESP_LOGI(TAG, "varispeed quality %d x%lu.%lu: %lu cycles/output frame, %lu.%02lu%% of one core", q,
+                     speeds[s] / AUDIO_WSOLA_SPEED_UNITY, speeds[s] % AUDIO_WSOLA_SPEED_UNITY * 10 / AUDIO_WSOLA_SPEED_UNITY, perFrame,
+                     perFrame * 44100 / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 10000),
+                     perFrame * 44100 / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 100) % 100);
+        }
+    }
+    audio_wsola_deinit(&wsola);
+}
+
+// 32 位输出: 16->32 位转换, 音量渐变, 抖动到 24 位, 与原来的浮点音量循环对比
+// 32-bit output: 16->32-bit conversion, volume ramp and dither to 24 bits, against the old
+// float volume loop
+static void bench_output32()
+{
+    const float scale = 0.6210f; // -4.1dB
+    uint32_t floatCycles = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        fillTestSignal(benchBuf, BENCH_SAMPLES);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (int i = 0; i < BENCH_SAMPLES; i++)
+            benchBuf[i] = (int16_t)((float)benchBuf[i] * scale);
+        floatCycles += esp_cpu_get_cycle_count() - t0;
+    }
+
+    audio_gain_t g;
+    audio_dither_t d;
+    for (int mode = AUDIO_DITHER_OFF; mode <= AUDIO_DITHER_SHAPED; mode++)
+    {
+        audio_dither_init(&d, mode, 24);
+        uint32_t cycles = 0;
+        for (int r = 0; r < BENCH_ROUNDS; r++)
+        {
+            fillTestSignal(benchBuf, BENCH_SAMPLES);
+            audio_gain_init(&g, 20349, 882);
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+            audio_gain_processS32(&g, benchBufS32, BENCH_SAMPLES / 2);
+            audio_dither_process(&d, benchBufS32, BENCH_SAMPLES / 2);
+            cycles += esp_cpu_get_cycle_count() - t0;
+        }
+
+        // 只有音量时发送线程走的一遍合成
+        // the single pass the transmit task takes when only the volume is on
+        uint32_t passCycles = 0;
+        for (int r = 0; r < BENCH_ROUNDS; r++)
+        {
+            fillTestSignal(benchBuf, BENCH_SAMPLES);
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            audio_dither_processS16(&d, 20349, benchBuf, benchBufS32, BENCH_SAMPLES / 2);
+            passCycles += esp_cpu_get_cycle_count() - t0;
+        }
+
+        ESP_LOGI(TAG, "output 32-bit, dither %d: %lu cycles/buffer, single pass %lu cycles/buffer, float volume loop %lu cycles/buffer",
+                 mode, cycles / BENCH_ROUNDS, passCycles / BENCH_ROUNDS, floatCycles / BENCH_ROUNDS);
+    }
+}
+
+// 逐位直通路径: 放进 32 位字和电平表, 加上校验时多出的还原和 CRC
+// bit-perfect path: into 32-bit words plus the meter, and what the check adds on top: turning
+// the words back and the CRC
+static void bench_bitPerfect()
+{
+    static int16_t back[BENCH_SAMPLES];
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)benchBuf, sizeof(benchBuf));
+
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        audio_format_s16ToWord(benchBuf, benchBufS32, BENCH_SAMPLES);
+        audio_meter_process(benchBufS32, BENCH_SAMPLES / 2, 44100, 0);
+    }
+    uint32_t path = (esp_cpu_get_cycle_count() - t0) / BENCH_ROUNDS;
+
+    bool ok = true;
+    t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        ok &= audio_format_wordToS16(benchBufS32, back, BENCH_SAMPLES);
+        ok &= (esp_rom_crc32_le(0, (const uint8_t *)back, sizeof(back)) == crc);
+    }
+    uint32_t check = (esp_cpu_get_cycle_count() - t0) / BENCH_ROUNDS;
+
+    ESP_LOGI(TAG, "bit-perfect: path %lu cycles/buffer, check %lu cycles/buffer, %s",
+             path, check, ok ? "matches" : "MISMATCH");
+}
+
+// 响度扫描: K 加权, 门限直方图和真峰值, 按 CD 实时倍数报告
+// loudness scan: K-weighting, gating histogram and true peak, reported as a multiple of CD realtime
+static void bench_loudness()
+{
+    static audio_loudness_t l;
+    audio_loudness_init(&l, 44100);
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+        audio_loudness_process(&l, benchBuf, BENCH_SAMPLES / 2);
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+
+    uint32_t frames = BENCH_ROUNDS * BENCH_SAMPLES / 2;
+    uint32_t perFrame = cycles / frames;
+    ESP_LOGI(TAG, "loudness: %lu cycles/frame, %lux realtime",
+             perFrame, (uint32_t)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000 / 44100 / (perFrame ? perFrame : 1));
+}
+
+// 压缩器, 限幅器, 两者串联; 信号先推高 12dB, 让两者都在工作
+// compressor, limiter and both in series; the signal is pushed up 12dB so both are working
+static void bench_dynamics()
+{
+    static const char *names[] = {"compressor", "limiter", "compressor + limiter"};
+    static audio_dynamics_t d;
+
+    for (int m = 0; m < 3; m++)
+    {
+        audio_dynamics_config_t cfg = {m != 1, m != 0, -20, 40, 200, 6, 0};
+        audio_dynamics_init(&d, 44100, &cfg);
+        uint32_t cycles = 0;
+        for (int r = 0; r < BENCH_ROUNDS; r++)
+        {
+            fillTestSignal(benchBuf, BENCH_SAMPLES);
+            audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+            for (int i = 0; i < BENCH_SAMPLES; i++)
+                benchBufS32[i] <<= 2;
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            audio_dynamics_process(&d, benchBufS32, BENCH_SAMPLES / 2);
+            cycles += esp_cpu_get_cycle_count() - t0;
+        }
+
+        ESP_LOGI(TAG, "%s: %lu cycles/buffer, %lu cycles/frame, reduction %u/%u (0.1dB)", names[m],
+                 cycles / BENCH_ROUNDS, cycles / BENCH_ROUNDS / (BENCH_SAMPLES / 2), d.compReduction, d.limitReduction);
+    }
+}
+
+// 交叉馈送, 按一个核的百分比报告
+// crossfeed, reported as a share of one core
+static void bench_crossfeed()
+{
+    audio_crossfeed_t c;
+    audio_crossfeed_init(&c, 44100, AUDIO_CROSSFEED_MEDIUM);
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+    audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+        audio_crossfeed_process(&c, benchBufS32, BENCH_SAMPLES / 2);
+    uint32_t cycles = (esp_cpu_get_cycle_count() - t0) / BENCH_ROUNDS;
+
+    uint32_t perFrame = cycles / (BENCH_SAMPLES / 2);
+    ESP_LOGI(TAG, "crossfeed: %lu cycles/buffer, %lu cycles/frame, %lu.%02lu%% of one core", cycles, perFrame,
+             perFrame * 44100 / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 10000),
+             perFrame * 44100 / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 100) % 100);
+}
+
+// 声道矩阵: 只有平衡和全部打开的开销应该一样, 都和一级 32 位增益差不多
+// channel matrix: balance alone and everything on should cost the same, about one 32-bit gain stage
+static void bench_matrix()
+{
+    static const audio_matrix_config_t cfgs[] = {
+        {20, AUDIO_MATRIX_WIDTH_UNITY, 0, 0, 0, {0}},
+        {-30, 150, 0, 1, 2, {0}},
+    };
+    static const char *names[] = {"balance", "all"};
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+
+    for (int c = 0; c < 2; c++)
+    {
+        audio_matrix_t m;
+        audio_matrix_init(&m, &cfgs[c], 0);
+        audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (int r = 0; r < BENCH_ROUNDS; r++)
+            audio_matrix_process(&m, benchBufS32, BENCH_SAMPLES / 2);
+        uint32_t cycles = (esp_cpu_get_cycle_count() - t0) / BENCH_ROUNDS;
+        ESP_LOGI(TAG, "matrix (%s): %lu cycles/buffer, %lu cycles/frame", names[c], cycles, cycles / (BENCH_SAMPLES / 2));
+    }
+
+    audio_gain_t g;
+    audio_gain_init(&g, 20349, 0);
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+        audio_gain_processS32(&g, benchBufS32, BENCH_SAMPLES / 2);
+    uint32_t cycles = (esp_cpu_get_cycle_count() - t0) / BENCH_ROUNDS;
+    ESP_LOGI(TAG, "gain S32 for comparison: %lu cycles/buffer, %lu cycles/frame", cycles, cycles / (BENCH_SAMPLES / 2));
+}
+
+// 频谱分析一帧: 1024 点 FFT, 频带汇总和峰值保持, 按 30 帧每秒算 core 0 的占用
+// one spectrum frame: 1024-point FFT, band sums and peak hold; core 0 share at 30 frames per second
+static void bench_spectrum()
+{
+    audio_spectrum_init();
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+
+    uint32_t cycles = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        audio_spectrum_capture(benchBuf, BENCH_SAMPLES / 2);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        audio_spectrum_analyze();
+        cycles += esp_cpu_get_cycle_count() - t0;
+    }
+    cycles /= BENCH_ROUNDS;
+
+    ESP_LOGI(TAG, "spectrum: %lu cycles/frame, %lu.%02lu%% of one core at 30 fps", cycles,
+             cycles * 30 / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 10000),
+             cycles * 30 / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 100) % 100);
+}
+
+// 电平表, 每块一次
+// level meter, once per block
+static void bench_meter()
+{
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+    audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_SAMPLES);
+
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+        audio_meter_process(benchBufS32, BENCH_SAMPLES / 2, 44100, AUDIO_FORMAT_HEADROOM_BITS);
+    uint32_t cycles = (esp_cpu_get_cycle_count() - t0) / BENCH_ROUNDS;
+
+    ESP_LOGI(TAG, "meter: %lu cycles/buffer, %lu cycles/sample", cycles, cycles / BENCH_SAMPLES);
+}
+
+// 示波器一个缓冲区的数据, 音频线程和界面线程加在一起: 原来每 20 帧求平均后逐点进队列, 界面逐点取出并整体左移;
+// 现在按块抽成最小/最大值, 界面每屏拷一次
+// oscilloscope data for one buffer, audio and GUI thread together: previously every 20 frames were
+// averaged and queued point by point, and the GUI took each point and shifted the whole trace;
+// now blocks are decimated to min/max and the GUI copies once per screen
+static void bench_scope()
+{
+    fillTestSignal(benchBuf, BENCH_SAMPLES);
+
+    QueueHandle_t queue = xQueueCreate(500, sizeof(int16_t) * 2);
+    static int16_t trace[2][AUDIO_SCOPE_COLUMNS * 2];
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        int32_t sum[2] = {0, 0};
+        int16_t point[2];
+        for (int i = 0, n = 0; i < BENCH_SAMPLES; i += 2)
+        {
+            sum[0] += benchBuf[i];
+            sum[1] += benchBuf[i + 1];
+            if (++n == AUDIO_SCOPE_FRAMES_PER_COLUMN)
+            {
+                point[0] = sum[0] / n;
+                point[1] = sum[1] / n;
+                xQueueSend(queue, point, 0);
+                sum[0] = sum[1] = 0;
+                n = 0;
+            }
+        }
+        while (xQueueReceive(queue, point, 0) == pdTRUE)
+        {
+            for (int i = 0; i < AUDIO_SCOPE_COLUMNS - 1; i++)
+            {
+                trace[0][i] = trace[0][i + 1];
+                trace[1][i] = trace[1][i + 1];
+            }
+            trace[0][AUDIO_SCOPE_COLUMNS - 1] = point[0];
+            trace[1][AUDIO_SCOPE_COLUMNS - 1] = point[1];
+        }
+    }
+    uint32_t queued = (esp_cpu_get_cycle_count() - t0) / BENCH_ROUNDS;
+    vQueueDelete(queue);
+
+    t0 = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (int b = 0; b < BENCH_SAMPLES / 2; b += BENCH_BLOCK_FRAMES)
+            audio_scope_capture(benchBuf + b * 2, BENCH_BLOCK_FRAMES);
+        const audio_scope_frame_t *frame = audio_scope_read();
+        for (int ch = 0; frame && ch < 2; ch++)
+        {
+            for (int i = 0; i < AUDIO_SCOPE_COLUMNS; i++)
+            {
+                trace[ch][i * 2] = frame->max[ch][i];
+                trace[ch][i * 2 + 1] = frame->min[ch][i];
+            }
+        }
+    }
+    uint32_t snapshot = (esp_cpu_get_cycle_count() - t0) / BENCH_ROUNDS;
+
+    ESP_LOGI(TAG, "scope: queue %lu cycles/buffer, snapshot %lu cycles/buffer", queued, snapshot);
+}
+
+// 处理图: 去加重, 交叉馈送, 重采样到 48000, 音量, 压缩/限幅, 抖动; 同一串直接调用和经过处理图各跑一遍,
+// 差值就是处理图本身的开销, 再打印各环节的统计
+// processing graph: de-emphasis, crossfeed, resampling to 48000, volume, compressor/limiter and
+// dither, run once as direct calls and once through the graph; the difference is the graph's own
+// overhead. The per-stage statistics are logged afterwards
+static audio_biquad_t graphDeemph;
+static audio_crossfeed_t graphCrossfeed;
+static audio_src_t graphSrc;
+static audio_gain_t graphGain;
+static audio_dynamics_t graphDynamics;
+static audio_dither_t graphDither;
+static int32_t graphSrcOut[AUDIO_SRC_MAX_OUT(BENCH_BLOCK_FRAMES, 44100, 48000) * 2];
+
+static void graphSetup()
+{
+    audio_biquad_coef_t coef;
+    audio_biquad_designDeemphasis(&coef);
+    audio_biquad_init(&graphDeemph, &coef);
+    audio_crossfeed_init(&graphCrossfeed, 44100, AUDIO_CROSSFEED_MEDIUM);
+    audio_gain_init(&graphGain, 20349, 882);
+    audio_dynamics_config_t cfg = {1, 1, -20, 40, 200, 6, 0};
+    audio_dynamics_init(&graphDynamics, 48000, &cfg);
+    audio_dither_init(&graphDither, AUDIO_DITHER_TPDF, 24);
+}
+
+static uint32_t graphStageDeemph(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_biquad_processStereo(&graphDeemph, samples, frames);
+    return frames;
+}
+
+static uint32_t graphStageCrossfeed(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_crossfeed_process(&graphCrossfeed, samples, frames);
+    return frames;
+}
+
+static uint32_t graphStageSrc(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    *out = graphSrcOut;
+    return audio_src_process(&graphSrc, samples, frames, graphSrcOut, AUDIO_SRC_MAX_OUT(BENCH_BLOCK_FRAMES, 44100, 48000));
+}
+
+static uint32_t graphStageGain(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_gain_processS32(&graphGain, samples, frames);
+    return frames;
+}
+
+static uint32_t graphStageDynamics(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_dynamics_process(&graphDynamics, samples, frames);
+    return frames;
+}
+
+static uint32_t graphStageDither(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_dither_process(&graphDither, samples, frames);
+    return frames;
+}
+
+static esp_err_t graphSink(void *ctx, int32_t *samples, uint32_t frames)
+{
+    *(uint32_t *)ctx += frames;
+    return ESP_OK;
+}
+
+static void bench_graph()
+{
+    if (audio_src_init(&graphSrc, 44100, 48000, AUDIO_SRC_MEDIUM, BENCH_BLOCK_FRAMES) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "graph: resampler alloc fail");
+        return;
+    }
+
+    graphSetup();
+    uint32_t direct = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        fillTestSignal(benchBuf, BENCH_BLOCK_FRAMES * 2);
+        audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_BLOCK_FRAMES * 2);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        audio_biquad_processStereo(&graphDeemph, benchBufS32, BENCH_BLOCK_FRAMES);
+        audio_crossfeed_process(&graphCrossfeed, benchBufS32, BENCH_BLOCK_FRAMES);
+        uint32_t n = audio_src_process(&graphSrc, benchBufS32, BENCH_BLOCK_FRAMES, graphSrcOut, AUDIO_SRC_MAX_OUT(BENCH_BLOCK_FRAMES, 44100, 48000));
+        audio_gain_processS32(&graphGain, graphSrcOut, n);
+        audio_dynamics_process(&graphDynamics, graphSrcOut, n);
+        audio_dither_process(&graphDither, graphSrcOut, n);
+        direct += esp_cpu_get_cycle_count() - t0;
+    }
+
+    static audio_graph_t g;
+    uint32_t outFrames = 0;
+    audio_graph_init(&g, 48000, I2S_GRAPH_BUDGET_PERCENT, graphSink, &outFrames);
+    audio_graph_add(&g, "deemph", graphStageDeemph, NULL, false, 0);
+    audio_graph_add(&g, "crossfeed", graphStageCrossfeed, NULL, false, 0);
+    audio_graph_add(&g, "src", graphStageSrc, NULL, false, BENCH_BLOCK_FRAMES);
+    audio_graph_add(&g, "volume", graphStageGain, NULL, false, 0);
+    audio_graph_add(&g, "dynamics", graphStageDynamics, NULL, false, 0);
+    audio_graph_add(&g, "dither", graphStageDither, NULL, true, 0);
+    for (int i = 0; i < g.count; i++)
+        audio_graph_setBypass(&g, i, false);
+
+    audio_src_reset(&graphSrc);
+    graphSetup();
+    uint32_t graph = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        fillTestSignal(benchBuf, BENCH_BLOCK_FRAMES * 2);
+        audio_format_s16ToS32(benchBuf, benchBufS32, BENCH_BLOCK_FRAMES * 2);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        audio_graph_process(&g, benchBufS32, BENCH_BLOCK_FRAMES);
+        graph += esp_cpu_get_cycle_count() - t0;
+    }
+    audio_src_deinit(&graphSrc);
+
+    ESP_LOGI(TAG, "graph: direct %lu cycles/block, graph %lu cycles/block, %lu frames out",
+             direct / BENCH_ROUNDS, graph / BENCH_ROUNDS, outFrames);
+    audio_graph_log(&g, TAG);
+}
+
+// 金样和滤波器设计检查, 与主机上 host/ 里跑的是同一份代码和同一张表
+// golden outputs and filter design checks: the same code and table the host/ build runs
+static void bench_golden()
+{
+    static audio_golden_result_t results[AUDIO_GOLDEN_MAX_RESULTS];
+    audio_golden_log(results, audio_golden_run(results), TAG);
+}
+
+void audio_bench_run()
+{
+    ESP_LOGI(TAG, "buffer: %d samples", BENCH_SAMPLES);
+    bench_gain();
+    bench_gainRamp();
+    bench_deemphasis();
+    bench_eq();
+    bench_src();
+    bench_varispeed();
+    bench_output32();
+    bench_bitPerfect();
+    bench_loudness();
+    bench_dynamics();
+    bench_crossfeed();
+    bench_matrix();
+    bench_spectrum();
+    bench_meter();
+    bench_scope();
+    bench_graph();
+    bench_golden();
+}
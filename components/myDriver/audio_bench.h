@@ -0,0 +1,11 @@
+#ifndef __AUDIO_BENCH_H_
+#define __AUDIO_BENCH_H_
+
+// 置 1 后开机时跑一遍音频处理基准测试并打印结果, 最后把各环节的输出和记下的金样对比
+// set to 1 to run the audio processing benchmark once at boot and log the result, finishing with
+// each stage's output checked against the stored golden outputs
+#define AUDIO_BENCH_ENABLE 0
+
+void audio_bench_run();
+
+#endif
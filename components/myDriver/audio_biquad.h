@@ -0,0 +1,48 @@
+#ifndef __AUDIO_BIQUAD_H_
+#define __AUDIO_BIQUAD_H_
+
+#include <stdint.h>
+
+// 系数 Q28, 范围 [-8, 8), 搁架滤波器 +12dB 时 b0 接近 4
+// coefficients in Q28, range [-8, 8); a +12dB shelf has b0 close to 4
+#define AUDIO_BIQUAD_COEF_SHIFT 28
+
+typedef struct
+{
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;
+    int32_t a2;
+} audio_biquad_coef_t;
+
+// 直接 I 型, 左右声道各一套状态
+// direct form I, one set of state per channel
+typedef struct
+{
+    audio_biquad_coef_t coef;
+    int32_t x1[2];
+    int32_t x2[2];
+    int32_t y1[2];
+    int32_t y2[2];
+} audio_biquad_t;
+
+void audio_biquad_init(audio_biquad_t *bq, const audio_biquad_coef_t *coef);
+void audio_biquad_reset(audio_biquad_t *bq);
+void audio_biquad_processStereo(audio_biquad_t *bq, int32_t *samples, uint32_t frames);
+
+// 浮点系数 (a0 归一化前) 转 Q28, 不在音频线程里调用
+// float coefficients (before normalising by a0) to Q28; not for the audio thread
+void audio_biquad_makeCoef(audio_biquad_coef_t *coef, double b0, double b1, double b2, double a0, double a1, double a2);
+
+// CD 50/15us 去加重, 44.1kHz
+// CD 50/15us de-emphasis at 44.1kHz
+void audio_biquad_designDeemphasis(audio_biquad_coef_t *coef);
+
+// RBJ 峰值/低搁架/高搁架, q 对搁架是斜率 S
+// RBJ peaking / low shelf / high shelf; for shelves q is the slope S
+void audio_biquad_designPeaking(audio_biquad_coef_t *coef, double fs, double f0, double gainDb, double q);
+void audio_biquad_designLowShelf(audio_biquad_coef_t *coef, double fs, double f0, double gainDb, double q);
+void audio_biquad_designHighShelf(audio_biquad_coef_t *coef, double fs, double f0, double gainDb, double q);
+
+#endif
@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_clock.h"
+
+// 相位误差超过这么多就不是抖动了 (DMA 放空过, 或者发送线程被拖住), 跳过 DMA 重新填满的过程从头来
+// a phase error this large is no longer jitter (DMA ran dry, or the transmit task was held up),
+// so it starts over, skipping DMA filling up again
+#define AUDIO_CLOCK_SLIP_US 20000.0
+
+void audio_clock_init(audio_clock_t *c, uint32_t nominal, double bandwidth)
+{
+    memset(c, 0, sizeof(audio_clock_t));
+    c->nominal = nominal;
+    c->bandwidth = bandwidth;
+    c->period = 1e6 / nominal;
+    c->granule = 1;
+}
+
+void audio_clock_reset(audio_clock_t *c, uint32_t skipFrames, uint32_t dmaFrames)
+{
+    c->skip = skipFrames;
+    c->granule = dmaFrames;
+    c->written = 0;
+    c->edge = 0;
+    c->state = AUDIO_CLOCK_SKIP;
+    c->locked = false;
+}
+
+void audio_clock_update(audio_clock_t *c, int64_t us, uint32_t frames)
+{
+    c->written += frames;
+    uint64_t edge = (c->written + c->granule - 1) / c->granule * c->granule;
+    uint32_t n = (uint32_t)(edge - c->edge);
+    c->edge = edge;
+
+    switch (c->state)
+    {
+    case AUDIO_CLOCK_SKIP:
+        if (c->written < c->skip)
+            return;
+        c->state = AUDIO_CLOCK_COARSE;
+        c->start = us;
+        c->frames = 0;
+        return;
+
+    case AUDIO_CLOCK_COARSE:
+        c->frames += n;
+        if (us - c->start < AUDIO_CLOCK_COARSE_US)
+            return;
+        c->period = (double)(us - c->start) / c->frames;
+        c->t0 = (double)us;
+        c->start = us;
+        c->state = AUDIO_CLOCK_TRACK;
+        return;
+
+    default:
+        break;
+    }
+
+    // 没跨过描述符边界的写入不用等, 时间戳不说明什么
+    // a write that crossed no descriptor boundary did not wait, so its timestamp tells nothing
+    if (n == 0)
+        return;
+
+    // 两个系数按这次的间隔算, 每次跨过的描述符数不固定也能保持同样的带宽
+    // both gains follow this update's interval, so the bandwidth holds however many descriptors a write spans
+    double predicted = c->t0 + n * c->period;
+    double e = (double)us - predicted;
+    if (fabs(e) > AUDIO_CLOCK_SLIP_US)
+    {
+        audio_clock_reset(c, c->skip, c->granule);
+        return;
+    }
+
+    double w = 2.0 * M_PI * c->bandwidth * n * c->period * 1e-6;
+    c->t0 = predicted + M_SQRT2 * w * e;
+    c->period += w * w * e / n;
+    c->error = e;
+    if (!c->locked && us - c->start >= AUDIO_CLOCK_LOCK_US)
+        c->locked = true;
+}
+
+double audio_clock_rate(const audio_clock_t *c)
+{
+    return c->locked ? 1e6 / c->period : (double)c->nominal;
+}
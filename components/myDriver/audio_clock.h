@@ -0,0 +1,61 @@
+#ifndef __AUDIO_CLOCK_H_
+#define __AUDIO_CLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 外部帧时钟跟踪: 二阶延迟锁定环 (DLL) 过滤 "写入返回的时刻" 这串时间戳, 得到外部时钟相对本机时钟的实际频率.
+// DMA 满着的时候, 写入要等 DMA 放完一个描述符才能拿到装最后一帧的那个, 所以返回的时刻正好是外部时钟走到某个描述符边界的时刻;
+// 环路跟踪的是描述符边界的位置而不是写了多少帧, 否则每块帧数一变, 量化误差就成了环路带宽里的慢漂移
+// external frame clock tracking: a second-order delay-locked loop filters the series of "the write
+// returned at" timestamps into the actual rate of the external clock against the local one. With
+// DMA full, a write has to wait for DMA to play out a descriptor before it gets the one its last
+// frame goes into, so it returns just as the external clock crosses a descriptor boundary; the
+// loop tracks the boundary position rather than the frames written, since otherwise any change in
+// frames per block turns the quantization into slow wander inside the loop bandwidth
+
+// 粗测时长: 先用这段时间的平均频率给环路定初值, 外部时钟和名义值差得再远也能马上接上
+// coarse measurement: the average rate over this long seeds the loop, so it starts close however
+// far the external clock is from nominal
+#define AUDIO_CLOCK_COARSE_US 1000000
+// 环路跟踪这么久算锁定, 大约是 4 个时间常数
+// the loop counts as locked after tracking this long, about 4 time constants
+#define AUDIO_CLOCK_LOCK_US 8000000
+
+typedef enum
+{
+    AUDIO_CLOCK_SKIP = 0, // 跳过 DMA 还没写满时的写入 skipping writes while DMA is still filling
+    AUDIO_CLOCK_COARSE,
+    AUDIO_CLOCK_TRACK,
+} audio_clock_state_t;
+
+typedef struct
+{
+    double t0;        // 环路对上一次写完时刻的估计, us loop's estimate of when the last write finished, us
+    double period;    // 每帧 us per frame
+    double bandwidth; // 环路带宽 loop bandwidth, Hz
+    double error;     // 上一次的相位误差 last phase error, us
+    int64_t start;    // 粗测或跟踪开始的时间 when the coarse measurement or tracking began
+    uint64_t written; // 重置以来写入的帧数 frames written since the reset
+    uint64_t edge;    // 上一次的描述符边界 the last descriptor boundary, frames
+    uint32_t frames;  // 粗测累计的帧数 frames counted by the coarse measurement
+    uint32_t skip;    // DMA 从空到满要跳过的帧数 frames to skip while DMA fills from empty
+    uint32_t granule; // 每个描述符的帧数 frames per DMA descriptor
+    uint32_t nominal; // Hz
+    uint8_t state;
+    bool locked;
+} audio_clock_t;
+
+void audio_clock_init(audio_clock_t *c, uint32_t nominal, double bandwidth);
+// 通道重新启用后调用, DMA 从空开始; skipFrames 一般是 DMA 的容量加一块
+// call once the channel is enabled again and DMA starts empty; skipFrames is usually the DMA
+// capacity plus a block
+void audio_clock_reset(audio_clock_t *c, uint32_t skipFrames, uint32_t dmaFrames);
+// 写完 frames 帧时调用, us 是写入返回的时刻
+// call once frames have been written, us being when the write returned
+void audio_clock_update(audio_clock_t *c, int64_t us, uint32_t frames);
+// 外部时钟的频率, Hz; 锁定之前是名义值
+// rate of the external clock, Hz; the nominal rate until locked
+double audio_clock_rate(const audio_clock_t *c);
+
+#endif
@@ -0,0 +1,93 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_crossfeed.h"
+
+// 截止频率 Hz 和馈送量 0.1dB, 按 audio_crossfeed_level_t 排列
+// cut frequency in Hz and feed in 0.1dB, in audio_crossfeed_level_t order
+static const uint16_t levelFc[AUDIO_CROSSFEED_LEVELS] = {0, 700, 700, 650};
+static const uint16_t levelFeed[AUDIO_CROSSFEED_LEVELS] = {0, 45, 60, 95};
+
+static inline int32_t sat32(int64_t x)
+{
+    if (x > INT32_MAX)
+        return INT32_MAX;
+    if (x < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)x;
+}
+
+static int32_t toQ30(double x)
+{
+    return (int32_t)lround(x * (double)(1 << 30));
+}
+
+// 系数按 bs2b 的推导: 低通增益 -5/6 馈送量 - 3dB, 高频提升的转折频率让两路相加后中频平坦
+// coefficients follow bs2b: the low-pass gain is -5/6 of the feed - 3dB, and the high boost
+// corner is placed so the two paths sum flat through the mids
+void audio_crossfeed_init(audio_crossfeed_t *c, uint32_t sampleRate, uint8_t level)
+{
+    memset(c, 0, sizeof(*c));
+    if (level >= AUDIO_CROSSFEED_LEVELS)
+        level = AUDIO_CROSSFEED_OFF;
+    c->level = level;
+    if (level == AUDIO_CROSSFEED_OFF)
+        return;
+
+    double feed = levelFeed[level] / 10.0;
+    double fcLo = levelFc[level];
+    double gbLo = feed * -5.0 / 6.0 - 3.0;
+    double gbHi = feed / 6.0 - 3.0;
+    double gLo = pow(10.0, gbLo / 20.0);
+    double gHi = 1.0 - pow(10.0, gbHi / 20.0);
+    double fcHi = fcLo * pow(2.0, (gbLo - 20.0 * log10(gHi)) / 12.0);
+
+    double x = exp(-2.0 * M_PI * fcLo / sampleRate);
+    c->loB1 = toQ30(x);
+    c->loA0 = toQ30(gLo * (1.0 - x));
+
+    x = exp(-2.0 * M_PI * fcHi / sampleRate);
+    c->hiB1 = toQ30(x);
+    c->hiA0 = toQ30(1.0 - gHi * (1.0 - x));
+    c->hiA1 = toQ30(-x);
+}
+
+// 每帧 10 次乘加, 两个声道的 4 个滤波器在同一个循环里算, 状态放在局部变量里
+// 10 multiply-adds per frame; the four filters of both channels run in one loop with the state
+// kept in locals
+void audio_crossfeed_process(audio_crossfeed_t *c, int32_t *samples, uint32_t frames)
+{
+    if (c->level == AUDIO_CROSSFEED_OFF)
+        return;
+
+    const int64_t loA0 = c->loA0, loB1 = c->loB1;
+    const int64_t hiA0 = c->hiA0, hiA1 = c->hiA1, hiB1 = c->hiB1;
+    int32_t loL = c->lo[0], loR = c->lo[1];
+    int32_t hiL = c->hi[0], hiR = c->hi[1];
+    int32_t prevL = c->prev[0], prevR = c->prev[1];
+    int32_t *p = samples;
+
+    for (uint32_t i = 0; i < frames; i++, p += 2)
+    {
+        int32_t l = p[0];
+        int32_t r = p[1];
+
+        loL = (int32_t)((loA0 * l + loB1 * loL) >> 30);
+        loR = (int32_t)((loA0 * r + loB1 * loR) >> 30);
+        hiL = (int32_t)((hiA0 * l + hiA1 * prevL + hiB1 * hiL) >> 30);
+        hiR = (int32_t)((hiA0 * r + hiA1 * prevR + hiB1 * hiR) >> 30);
+        prevL = l;
+        prevR = r;
+
+        p[0] = sat32((int64_t)hiL + loR);
+        p[1] = sat32((int64_t)hiR + loL);
+    }
+
+    c->lo[0] = loL;
+    c->lo[1] = loR;
+    c->hi[0] = hiL;
+    c->hi[1] = hiR;
+    c->prev[0] = prevL;
+    c->prev[1] = prevR;
+}
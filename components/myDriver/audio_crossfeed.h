@@ -0,0 +1,36 @@
+#ifndef __AUDIO_CROSSFEED_H_
+#define __AUDIO_CROSSFEED_H_
+
+#include <stdint.h>
+
+// 耳机交叉馈送 (Bauer / bs2b): 对侧声道经低通混入, 本侧声道经高频提升, 硬声像的早期立体声录音
+// 用耳机听不那么累
+// headphone crossfeed (Bauer / bs2b): the opposite channel is mixed in through a low-pass and the
+// same channel goes through a high boost, so hard-panned early stereo is less tiring on headphones
+typedef enum
+{
+    AUDIO_CROSSFEED_OFF,
+    AUDIO_CROSSFEED_LOW,    // 700Hz, 4.5dB (bs2b 默认 default)
+    AUDIO_CROSSFEED_MEDIUM, // 700Hz, 6.0dB (Chu Moy)
+    AUDIO_CROSSFEED_HIGH,   // 650Hz, 9.5dB (Jan Meier)
+    AUDIO_CROSSFEED_LEVELS,
+} audio_crossfeed_level_t;
+
+typedef struct
+{
+    uint8_t level;
+    // 一阶滤波器系数, Q30 first-order filter coefficients, Q30
+    int32_t loA0, loB1;
+    int32_t hiA0, hiA1, hiB1;
+    // 每声道的状态 per-channel state
+    int32_t lo[2];
+    int32_t hi[2];
+    int32_t prev[2];
+} audio_crossfeed_t;
+
+void audio_crossfeed_init(audio_crossfeed_t *c, uint32_t sampleRate, uint8_t level);
+// 立体声交错, 内部 32 位格式, 原地处理
+// interleaved stereo in the internal 32-bit format, in place
+void audio_crossfeed_process(audio_crossfeed_t *c, int32_t *samples, uint32_t frames);
+
+#endif
@@ -0,0 +1,235 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_format.h"
+#include "audio_dither.h"
+
+// 内部满幅 1<<29, 左移 2 位到 32 位 I2S 字
+// internal full scale is 1<<29, shifted left by 2 into the 32-bit I2S word
+#define FULL_SCALE (1 << (31 - AUDIO_FORMAT_HEADROOM_BITS))
+
+// 三阶误差反馈 (Wannamaker F 加权近似), Q12, 噪声传递函数 1 - 1.623z^-1 + 0.982z^-2 - 0.109z^-3,
+// 3kHz 附近压低约 12dB, 噪声挪到 15kHz 以上
+// 3rd order error feedback (Wannamaker's F-weighted fit), Q12; the noise transfer function
+// 1 - 1.623z^-1 + 0.982z^-2 - 0.109z^-3 is about 12dB down around 3kHz and moves the noise above 15kHz
+#define SHAPE_H1 6648
+#define SHAPE_H2 (-4022)
+#define SHAPE_H3 446
+
+void audio_dither_init(audio_dither_t *d, uint8_t mode, uint8_t bits)
+{
+    if (bits < 16)
+        bits = 16;
+    if (bits > 32)
+        bits = 32;
+
+    d->mode = mode;
+    d->bits = bits;
+    // 内部格式只有 30 位有效, 字长再长不需要量化
+    // the internal format only carries 30 bits, longer words need no quantization
+    d->qShift = (bits >= 32 - AUDIO_FORMAT_HEADROOM_BITS) ? 0 : (32 - AUDIO_FORMAT_HEADROOM_BITS - bits);
+    d->seed = 0x2545f491;
+    audio_dither_reset(d);
+}
+
+void audio_dither_reset(audio_dither_t *d)
+{
+    memset(d->err, 0, sizeof(d->err));
+    memset(d->prev, 0, sizeof(d->prev));
+}
+
+// xorshift32, 每一位质量都够, 可以拆开用
+// xorshift32: every bit is usable, so a draw can be split
+static inline uint32_t nextRandom(uint32_t *seed)
+{
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+static inline int32_t clampFullScale(int32_t x)
+{
+    if (x > FULL_SCALE - 1)
+        return FULL_SCALE - 1;
+    if (x < -FULL_SCALE)
+        return -FULL_SCALE;
+    return x;
+}
+
+// 16 位采样乘 Q15 音量直接得到内部格式: ((x << 14) * gain + (1 << 14)) >> 15 就是 (x * gain + 1) >> 1,
+// 和先转内部格式再走 audio_gain 的 Q31 乘法逐位相同, 但只要一次 32 位乘法
+// a 16-bit sample times the Q15 volume straight into the internal format:
+// ((x << 14) * gain + (1 << 14)) >> 15 is (x * gain + 1) >> 1, bit-identical to converting
+// first and going through audio_gain's Q31 multiply, but with a single 32-bit multiply
+static inline int32_t scaleS16(int16_t x, int32_t gain)
+{
+    return (x * gain + 1) >> 1;
+}
+
+// 四舍五入到 lsb 的整数倍并饱和
+// round to a multiple of lsb and saturate
+static inline int32_t quantize(int32_t t, int32_t lsb)
+{
+    int32_t q = (t + (lsb >> 1)) & ~(lsb - 1);
+    if (q > FULL_SCALE - lsb)
+        return FULL_SCALE - lsb;
+    if (q < -FULL_SCALE)
+        return -FULL_SCALE;
+    return q;
+}
+
+// 高通 TPDF: 每帧一个随机数拆成左右两个 16 位均匀分布, 每声道用这一个减上一个, 幅度分布仍是三角形,
+// 噪声略偏高频; 每个采样只要半次随机数, 也没有两次随机数之间的依赖链
+// high-pass TPDF: one draw per frame is split into 16-bit uniform values for left and right, and
+// each channel subtracts its previous one. The amplitude is still triangular and the noise leans
+// slightly towards high frequencies; each sample costs half a draw and there is no chain of
+// dependent draws per sample
+static inline int32_t tpdf(int32_t u, int32_t *prev)
+{
+    int32_t t = u - *prev;
+    *prev = u;
+    return t;
+}
+
+// 误差反馈, 削波时误差会很大, 限幅防止反馈环发散
+// error feedback; clipping makes the error huge, so it is clamped to keep the loop from running away
+static inline int32_t shapeSample(int32_t x, int32_t *e, int32_t dither, int32_t lsb)
+{
+    int32_t v = x - ((SHAPE_H1 * e[0] + SHAPE_H2 * e[1] + SHAPE_H3 * e[2]) >> 12);
+    int32_t q = quantize(v + dither, lsb);
+    int32_t err = q - v;
+    if (err > 2 * lsb)
+        err = 2 * lsb;
+    if (err < -2 * lsb)
+        err = -2 * lsb;
+    e[2] = e[1];
+    e[1] = e[0];
+    e[0] = err;
+    return q;
+}
+
+// 立体声交错, 原地把内部格式换成 I2S 字, 三种方式各走一个循环, 循环里没有分支判断方式
+// interleaved stereo, converts the internal format to I2S words in place; each mode has its own
+// loop so nothing inside the loop branches on the mode
+void audio_dither_process(audio_dither_t *d, int32_t *samples, uint32_t frames)
+{
+    int32_t *p = samples;
+
+    if (d->qShift == 0)
+    {
+        for (uint32_t i = 0; i < frames; i++, p += 2)
+        {
+            p[0] = clampFullScale(p[0]) << AUDIO_FORMAT_HEADROOM_BITS;
+            p[1] = clampFullScale(p[1]) << AUDIO_FORMAT_HEADROOM_BITS;
+        }
+        return;
+    }
+
+    // 状态放在局部变量里, 不然每次写 p[] 之后编译器都得重新从 d 里读一遍
+    // the state lives in locals, or the compiler has to reload it from d after every store to p[]
+    const int32_t lsb = 1 << d->qShift;
+    const int randShift = 16 - d->qShift;
+    uint32_t seed = d->seed;
+    int32_t prevL = d->prev[0], prevR = d->prev[1];
+
+    switch (d->mode)
+    {
+    case AUDIO_DITHER_TPDF:
+        for (uint32_t i = 0; i < frames; i++, p += 2)
+        {
+            uint32_t r = nextRandom(&seed);
+            int32_t dl = tpdf((r & 0xffff) >> randShift, &prevL);
+            int32_t dr = tpdf((r >> 16) >> randShift, &prevR);
+            p[0] = quantize(clampFullScale(p[0]) + dl, lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+            p[1] = quantize(clampFullScale(p[1]) + dr, lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+        }
+        break;
+
+    case AUDIO_DITHER_SHAPED:
+        for (uint32_t i = 0; i < frames; i++, p += 2)
+        {
+            uint32_t r = nextRandom(&seed);
+            int32_t dl = tpdf((r & 0xffff) >> randShift, &prevL);
+            int32_t dr = tpdf((r >> 16) >> randShift, &prevR);
+            p[0] = shapeSample(clampFullScale(p[0]), d->err[0], dl, lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+            p[1] = shapeSample(clampFullScale(p[1]), d->err[1], dr, lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+        }
+        break;
+
+    default:
+        for (uint32_t i = 0; i < frames; i++, p += 2)
+        {
+            p[0] = quantize(clampFullScale(p[0]), lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+            p[1] = quantize(clampFullScale(p[1]), lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+        }
+        break;
+    }
+
+    d->seed = seed;
+    d->prev[0] = prevL;
+    d->prev[1] = prevR;
+}
+
+// 三步合成一遍, 每种方式仍各走一个循环; 16 位输入不必先展开成一块 32 位的缓冲
+// the three steps in one pass, still one loop per mode; the 16-bit input never has to be widened
+// into a 32-bit buffer first
+void audio_dither_processS16(audio_dither_t *d, int32_t gain, const int16_t *in, int32_t *out, uint32_t frames)
+{
+    if (d->qShift == 0)
+    {
+        for (uint32_t i = 0; i < frames; i++, in += 2, out += 2)
+        {
+            out[0] = clampFullScale(scaleS16(in[0], gain)) << AUDIO_FORMAT_HEADROOM_BITS;
+            out[1] = clampFullScale(scaleS16(in[1], gain)) << AUDIO_FORMAT_HEADROOM_BITS;
+        }
+        return;
+    }
+
+    const int32_t lsb = 1 << d->qShift;
+    const int randShift = 16 - d->qShift;
+    uint32_t seed = d->seed;
+    int32_t prevL = d->prev[0], prevR = d->prev[1];
+
+    switch (d->mode)
+    {
+    case AUDIO_DITHER_TPDF:
+        for (uint32_t i = 0; i < frames; i++, in += 2, out += 2)
+        {
+            uint32_t r = nextRandom(&seed);
+            int32_t dl = tpdf((r & 0xffff) >> randShift, &prevL);
+            int32_t dr = tpdf((r >> 16) >> randShift, &prevR);
+            out[0] = quantize(clampFullScale(scaleS16(in[0], gain)) + dl, lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+            out[1] = quantize(clampFullScale(scaleS16(in[1], gain)) + dr, lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+        }
+        break;
+
+    case AUDIO_DITHER_SHAPED:
+        for (uint32_t i = 0; i < frames; i++, in += 2, out += 2)
+        {
+            uint32_t r = nextRandom(&seed);
+            int32_t dl = tpdf((r & 0xffff) >> randShift, &prevL);
+            int32_t dr = tpdf((r >> 16) >> randShift, &prevR);
+            out[0] = shapeSample(clampFullScale(scaleS16(in[0], gain)), d->err[0], dl, lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+            out[1] = shapeSample(clampFullScale(scaleS16(in[1], gain)), d->err[1], dr, lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+        }
+        break;
+
+    default:
+        // 不加抖动时 quantize() 自己的饱和就够了, 结果和先 clampFullScale() 一样; 乘积最多 2^30, 不会溢出
+        // without dither quantize()'s own saturation is enough and gives the same result as
+        // clampFullScale() first; the product is at most 2^30, so nothing overflows
+        for (uint32_t i = 0; i < frames; i++, in += 2, out += 2)
+        {
+            out[0] = quantize(scaleS16(in[0], gain), lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+            out[1] = quantize(scaleS16(in[1], gain), lsb) << AUDIO_FORMAT_HEADROOM_BITS;
+        }
+        break;
+    }
+
+    d->seed = seed;
+    d->prev[0] = prevL;
+    d->prev[1] = prevR;
+}
@@ -0,0 +1,40 @@
+#ifndef __AUDIO_DITHER_H_
+#define __AUDIO_DITHER_H_
+
+#include <stdint.h>
+
+// 内部 32 位格式 (满幅 1<<29) 量化到 DAC 字长, 输出左对齐的 32 位 I2S 字
+// quantizes the internal 32-bit format (full scale 1<<29) to the DAC word length and outputs
+// left-justified 32-bit I2S words
+typedef enum
+{
+    AUDIO_DITHER_OFF,    // 只四舍五入 plain rounding
+    AUDIO_DITHER_TPDF,   // 高通三角分布, ±1 LSB high-pass triangular, ±1 LSB
+    AUDIO_DITHER_SHAPED, // TPDF + 三阶误差反馈, 噪声推到高频 TPDF + 3rd order error feedback, noise pushed up high
+} audio_dither_mode_t;
+
+typedef struct
+{
+    uint8_t mode;
+    uint8_t bits;    // DAC 字长 DAC word length, 16 ~ 32
+    uint8_t qShift;  // 内部格式里一个 LSB 的位数 bits of one LSB in the internal format
+    uint32_t seed;
+    int32_t prev[2];   // 每声道上一个均匀分布随机数 previous uniform value per channel
+    int32_t err[2][3]; // 每声道最近三个量化误差 last three quantization errors per channel
+} audio_dither_t;
+
+void audio_dither_init(audio_dither_t *d, uint8_t mode, uint8_t bits);
+void audio_dither_reset(audio_dither_t *d);
+void audio_dither_process(audio_dither_t *d, int32_t *samples, uint32_t frames);
+
+// 只有音量要处理时的捷径: 16 位采样乘 Q15 音量再抖动, 一遍输出 I2S 字, 结果和 audio_format_s16ToS32(),
+// audio_gain_processS32(), audio_dither_process() 依次做逐位相同. 只用 32 位乘法, 所以音量不能超过
+// AUDIO_DITHER_S16_GAIN_MAX (+6dB), 也不能在渐变中
+// the short cut for when the volume is all there is to do: 16-bit samples times the Q15 volume,
+// dithered, out as I2S words in a single pass, bit-identical to audio_format_s16ToS32(),
+// audio_gain_processS32() and audio_dither_process() in turn. It only uses 32-bit multiplies, so
+// the volume must not exceed AUDIO_DITHER_S16_GAIN_MAX (+6dB) nor be ramping
+#define AUDIO_DITHER_S16_GAIN_MAX 65535
+void audio_dither_processS16(audio_dither_t *d, int32_t gain, const int16_t *in, int32_t *out, uint32_t frames);
+
+#endif
@@ -0,0 +1,346 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_format.h"
+#include "audio_dynamics.h"
+
+#define FULL_SCALE (1 << (31 - AUDIO_FORMAT_HEADROOM_BITS))
+#define GAIN_SHIFT 24
+#define LIMIT_GAIN_SHIFT 16
+
+static inline int32_t sat32(int64_t x)
+{
+    if (x > INT32_MAX)
+        return INT32_MAX;
+    if (x < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)x;
+}
+
+static inline uint32_t absS32(int32_t x)
+{
+    return (x < 0) ? -(uint32_t)x : (uint32_t)x;
+}
+
+// 一阶跟随的系数, 时间常数 ms, Q30
+// one-pole follower coefficient for a time constant in ms, Q30
+static int32_t timeCoef(uint32_t ms, uint32_t sampleRate)
+{
+    float samples = (float)ms * (float)sampleRate / 1000.0f;
+    if (samples < 1.0f)
+        samples = 1.0f;
+    return (int32_t)((1.0f - expf(-1.0f / samples)) * (float)(1 << 30) + 0.5f);
+}
+
+static void clampConfig(audio_dynamics_config_t *c)
+{
+    if (c->threshold > 0)
+        c->threshold = 0;
+    if (c->threshold < -40)
+        c->threshold = -40;
+    if (c->ratio < 10)
+        c->ratio = 10;
+    if (c->ratio > 200)
+        c->ratio = 200;
+    if (c->release < 20)
+        c->release = 20;
+    if (c->release > 2000)
+        c->release = 2000;
+    if (c->makeup < 0)
+        c->makeup = 0;
+    if (c->makeup > 24)
+        c->makeup = 24;
+}
+
+static void resetCompressor(audio_dynamics_t *d)
+{
+    d->env = 0;
+    d->gain = 1 << GAIN_SHIFT;
+}
+
+static void resetLimiter(audio_dynamics_t *d)
+{
+    memset(d->boxHist, 0, sizeof(d->boxHist));
+    d->maxHead = 0;
+    d->maxCount = 0;
+    d->frameIndex = 0;
+    d->boxSum = 0;
+    d->boxPos = 0;
+    d->limitEnv = 0;
+}
+
+void audio_dynamics_init(audio_dynamics_t *d, uint32_t sampleRate, const audio_dynamics_config_t *cfg)
+{
+    memset(d, 0, sizeof(*d));
+    if (sampleRate > AUDIO_DYNAMICS_MAX_RATE)
+        sampleRate = AUDIO_DYNAMICS_MAX_RATE;
+    d->sampleRate = sampleRate;
+
+    d->lookahead = sampleRate / 1000 * AUDIO_DYNAMICS_LOOKAHEAD_US / 1000;
+    if (d->lookahead < 2)
+        d->lookahead = 2;
+    d->delayLen = d->lookahead - 1;
+    // 向上取整, 平均值只会偏大, 限幅不会漏
+    // rounded up so the average only errs high and the limiter never lets a peak through
+    d->boxRecip = ((1u << 24) + d->lookahead - 1) / d->lookahead;
+    d->ceiling = (uint32_t)(FULL_SCALE * powf(10.0f, AUDIO_DYNAMICS_CEILING_DB10 / 200.0f));
+    d->attackCoef = timeCoef(AUDIO_DYNAMICS_ATTACK_MS, sampleRate);
+    d->limitReleaseCoef = timeCoef(AUDIO_DYNAMICS_LIMIT_RELEASE_MS, sampleRate);
+
+    resetCompressor(d);
+    resetLimiter(d);
+    audio_dynamics_setConfig(d, cfg);
+}
+
+void audio_dynamics_setConfig(audio_dynamics_t *d, const audio_dynamics_config_t *cfg)
+{
+    audio_dynamics_config_t c = *cfg;
+    clampConfig(&c);
+
+    if (c.compressor && !d->cfg.compressor)
+        resetCompressor(d);
+    if (c.limiter && !d->cfg.limiter)
+        d->limitPrime = true;
+    if ((c.compressor || c.limiter) && !audio_dynamics_isActive(d))
+        d->delayFill = true;
+
+    d->cfg = c;
+    d->releaseCoef = timeCoef(c.release, d->sampleRate);
+    d->threshold = c.threshold;
+    d->slope = 1.0f - 10.0f / c.ratio;
+}
+
+void audio_dynamics_reset(audio_dynamics_t *d)
+{
+    resetCompressor(d);
+    resetLimiter(d);
+    d->delayFill = true;
+    d->limitPrime = d->cfg.limiter;
+}
+
+bool audio_dynamics_isActive(const audio_dynamics_t *d)
+{
+    return d->cfg.compressor || d->cfg.limiter;
+}
+
+// 软拐点增益计算, 返回衰减量 dB
+// soft-knee gain computer, returns the reduction in dB
+static float computeReduction(const audio_dynamics_t *d, int32_t env)
+{
+    if (env <= 0)
+        return 0.0f;
+
+    float level = 6.0206f * (log2f((float)env) - (31 - AUDIO_FORMAT_HEADROOM_BITS));
+    float over = level - d->threshold;
+    if (2.0f * over <= -AUDIO_DYNAMICS_KNEE_DB)
+        return 0.0f;
+    if (2.0f * over >= AUDIO_DYNAMICS_KNEE_DB)
+        return d->slope * over;
+    float k = over + AUDIO_DYNAMICS_KNEE_DB / 2.0f;
+    return d->slope * k * k / (2.0f * AUDIO_DYNAMICS_KNEE_DB);
+}
+
+// 包络逐帧跟随 (定点), 增益每 AUDIO_DYNAMICS_CONTROL_FRAMES 帧用 log2f/exp2f 算一次, 中间线性插值
+// the envelope follows every frame (fixed point); the gain comes from log2f/exp2f every
+// AUDIO_DYNAMICS_CONTROL_FRAMES frames and is interpolated linearly in between
+static void processCompressor(audio_dynamics_t *d, int32_t *samples, uint32_t frames)
+{
+    int32_t env = d->env;
+    int32_t gain = d->gain;
+    float maxReduction = 0.0f;
+
+    for (uint32_t i = 0; i < frames; i += AUDIO_DYNAMICS_CONTROL_FRAMES)
+    {
+        uint32_t n = (frames - i < AUDIO_DYNAMICS_CONTROL_FRAMES) ? frames - i : AUDIO_DYNAMICS_CONTROL_FRAMES;
+        int32_t *p = samples + i * 2;
+
+        for (uint32_t k = 0; k < n; k++)
+        {
+            uint32_t l = absS32(p[k * 2]);
+            uint32_t r = absS32(p[k * 2 + 1]);
+            uint32_t peak = (l > r) ? l : r;
+            if (peak > INT32_MAX)
+                peak = INT32_MAX;
+            int32_t coef = ((int32_t)peak > env) ? d->attackCoef : d->releaseCoef;
+            env += (int32_t)(((int64_t)((int32_t)peak - env) * coef) >> 30);
+        }
+
+        float reduction = computeReduction(d, env);
+        if (reduction > maxReduction)
+            maxReduction = reduction;
+        int32_t target = (int32_t)(exp2f((d->cfg.makeup - reduction) * 0.16610f) * (float)(1 << GAIN_SHIFT));
+        int32_t step = (target - gain) / (int32_t)n;
+
+        for (uint32_t k = 0; k < n; k++)
+        {
+            gain += step;
+            p[0] = sat32(((int64_t)p[0] * gain) >> GAIN_SHIFT);
+            p[1] = sat32(((int64_t)p[1] * gain) >> GAIN_SHIFT);
+            p += 2;
+        }
+        gain = target; // 消除整除误差 drop the division residue
+    }
+
+    d->env = env;
+    d->gain = gain;
+    d->compReduction = (uint16_t)(maxReduction * 10.0f + 0.5f);
+}
+
+// 限幅器的检测部分: 窗口最大值 -> 滑动平均 -> 释放, 更新 limitEnv
+// the limiter's detector: window maximum -> moving average -> release, updates limitEnv
+static void limitDetect(audio_dynamics_t *d, uint32_t peak)
+{
+    const uint32_t len = d->lookahead;
+
+    // 单调队列: 过期的从头出, 不大于新值的从尾出
+    // monotonic queue: expired entries leave from the head, entries not above the new
+    // value leave from the tail
+    if (d->maxCount && d->frameIndex - d->maxAt[d->maxHead] >= len)
+    {
+        d->maxHead = (d->maxHead + 1 == len) ? 0 : d->maxHead + 1;
+        d->maxCount--;
+    }
+    while (d->maxCount)
+    {
+        uint32_t tail = d->maxHead + d->maxCount - 1;
+        if (tail >= len)
+            tail -= len;
+        if (d->maxVal[tail] > peak)
+            break;
+        d->maxCount--;
+    }
+    uint32_t in = d->maxHead + d->maxCount;
+    if (in >= len)
+        in -= len;
+    d->maxVal[in] = peak;
+    d->maxAt[in] = d->frameIndex++;
+    d->maxCount++;
+
+    // 滑动平均, 去掉低 8 位并向上取整, 和不会溢出
+    // moving average with the low 8 bits dropped (rounded up) so the sum cannot overflow
+    uint32_t v = (d->maxVal[d->maxHead] + 255) >> 8;
+    d->boxSum += v - d->boxHist[d->boxPos];
+    d->boxHist[d->boxPos] = v;
+    d->boxPos = (d->boxPos + 1 == len) ? 0 : d->boxPos + 1;
+    uint32_t avg = (uint32_t)((((uint64_t)d->boxSum * d->boxRecip) >> 24) + 1) << 8;
+
+    if (avg >= d->limitEnv)
+        d->limitEnv = avg;
+    else
+        d->limitEnv -= (uint32_t)(((uint64_t)(d->limitEnv - avg) * d->limitReleaseCoef) >> 30);
+}
+
+// 限幅器刚打开: 把延迟线里还没输出的帧按先后过一遍检测, 检测状态就和一直开着一样, 这些帧出来时也不会超过上限
+// the limiter was just turned on: the frames still in the delay line go through the detector
+// oldest first, leaving it as if it had been running all along, so they too come out under the
+// ceiling
+static void primeLimiter(audio_dynamics_t *d)
+{
+    resetLimiter(d);
+    uint32_t pos = d->delayPos;
+    for (uint32_t i = 0; i < d->delayLen; i++)
+    {
+        const int32_t *dl = d->delay + pos * 2;
+        uint32_t l = absS32(dl[0]);
+        uint32_t r = absS32(dl[1]);
+        limitDetect(d, (l > r) ? l : r);
+        pos = (pos + 1 == d->delayLen) ? 0 : pos + 1;
+    }
+}
+
+// 限幅器关着时延迟线照样走, 开关限幅器不改变延迟
+// with the limiter off the delay line still runs, so toggling the limiter keeps the latency
+static void processDelay(audio_dynamics_t *d, int32_t *samples, uint32_t frames)
+{
+    int32_t *p = samples;
+    for (uint32_t i = 0; i < frames; i++, p += 2)
+    {
+        int32_t *dl = d->delay + d->delayPos * 2;
+        int32_t outL = dl[0];
+        int32_t outR = dl[1];
+        dl[0] = p[0];
+        dl[1] = p[1];
+        d->delayPos = (d->delayPos + 1 == d->delayLen) ? 0 : d->delayPos + 1;
+        p[0] = outL;
+        p[1] = outR;
+    }
+}
+
+// 窗口最大值 -> 滑动平均 -> 释放, 得到的包络在延迟后的采样处总不小于它的绝对值, 所以输出不会超过上限
+// window maximum -> moving average -> release; at the delayed sample the envelope is never below
+// its magnitude, so the output never exceeds the ceiling
+static void processLimiter(audio_dynamics_t *d, int32_t *samples, uint32_t frames)
+{
+    const uint32_t ceiling = d->ceiling;
+    uint32_t minGain = 1 << LIMIT_GAIN_SHIFT;
+    int32_t *p = samples;
+
+    for (uint32_t i = 0; i < frames; i++, p += 2)
+    {
+        uint32_t l = absS32(p[0]);
+        uint32_t r = absS32(p[1]);
+        uint32_t peak = (l > r) ? l : r;
+
+        limitDetect(d, peak);
+
+        // 延迟线
+        // delay line
+        int32_t *dl = d->delay + d->delayPos * 2;
+        int32_t outL = dl[0];
+        int32_t outR = dl[1];
+        dl[0] = p[0];
+        dl[1] = p[1];
+        d->delayPos = (d->delayPos + 1 == d->delayLen) ? 0 : d->delayPos + 1;
+
+        if (d->limitEnv > ceiling)
+        {
+            // 包络右移 14 位再除, 32 位除法就够, 除数 +1 让增益只会偏小
+            // the envelope is shifted down by 14 so a 32-bit division is enough; +1 on the
+            // divisor keeps the gain from erring high
+            uint32_t g = (ceiling << 2) / ((d->limitEnv >> 14) + 1);
+            if (g < minGain)
+                minGain = g;
+            outL = (int32_t)(((int64_t)outL * g) >> LIMIT_GAIN_SHIFT);
+            outR = (int32_t)(((int64_t)outR * g) >> LIMIT_GAIN_SHIFT);
+        }
+        p[0] = outL;
+        p[1] = outR;
+    }
+
+    d->limitReduction = (minGain < (1 << LIMIT_GAIN_SHIFT))
+                            ? (uint16_t)(-200.0f * log10f((float)minGain / (1 << LIMIT_GAIN_SHIFT)) + 0.5f)
+                            : 0;
+}
+
+void audio_dynamics_process(audio_dynamics_t *d, int32_t *samples, uint32_t frames)
+{
+    d->compReduction = 0;
+    d->limitReduction = 0;
+    if (d->cfg.compressor)
+        processCompressor(d, samples, frames);
+
+    // 整级刚接入时延迟线里是旧数据, 用第一帧填满: 输出在这一帧上停留一个预读时长, 不会跳到旧数据或静音
+    // when the whole stage has just come in, the delay line holds stale data; it is filled with
+    // the first frame, so the output dwells on that frame for one look-ahead instead of jumping to
+    // stale data or silence
+    if (d->delayFill && frames)
+    {
+        for (uint32_t i = 0; i < d->delayLen; i++)
+        {
+            d->delay[i * 2] = samples[0];
+            d->delay[i * 2 + 1] = samples[1];
+        }
+        d->delayFill = false;
+    }
+    if (d->limitPrime)
+    {
+        primeLimiter(d);
+        d->limitPrime = false;
+    }
+
+    if (d->cfg.limiter)
+        processLimiter(d, samples, frames);
+    else
+        processDelay(d, samples, frames);
+}
@@ -0,0 +1,98 @@
+#ifndef __AUDIO_DYNAMICS_H_
+#define __AUDIO_DYNAMICS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 夜间模式: 立体声联动压缩器 + 预读砖墙限幅器, 在内部 32 位格式 (满幅 1<<29) 上处理, 接在音量之后
+// night mode: stereo-linked compressor + look-ahead brick-wall limiter on the internal 32-bit
+// format (full scale 1<<29), placed after the volume
+
+// 压缩器启动时间和软拐点宽度
+// compressor attack time and soft knee width
+#define AUDIO_DYNAMICS_ATTACK_MS 5
+#define AUDIO_DYNAMICS_KNEE_DB 6.0f
+// 压缩器增益每多少帧算一次, 中间线性插值
+// the compressor gain is computed every this many frames and interpolated in between
+#define AUDIO_DYNAMICS_CONTROL_FRAMES 16
+
+// 限幅器: 预读时长, 输出上限 (0.1dBFS), 释放时间
+// limiter: look-ahead time, output ceiling (0.1dBFS), release time
+#define AUDIO_DYNAMICS_LOOKAHEAD_US 1500
+#define AUDIO_DYNAMICS_CEILING_DB10 (-3)
+#define AUDIO_DYNAMICS_LIMIT_RELEASE_MS 60
+#define AUDIO_DYNAMICS_MAX_RATE 96000
+#define AUDIO_DYNAMICS_MAX_LOOKAHEAD (AUDIO_DYNAMICS_MAX_RATE / 1000 * AUDIO_DYNAMICS_LOOKAHEAD_US / 1000 + 1)
+
+// 存进 NVS 的格式, 改动需保持兼容
+// this is the layout stored in NVS, keep it compatible
+typedef struct
+{
+    uint8_t compressor; // 压缩器开关 compressor on/off
+    uint8_t limiter;    // 限幅器开关 limiter on/off
+    int8_t threshold;   // dBFS, -40 ~ 0
+    uint8_t ratio;      // 压缩比 * 10, 10 ~ 200 ratio * 10, 10 ~ 200
+    uint16_t release;   // ms, 20 ~ 2000
+    int8_t makeup;      // 补偿增益 dB, 0 ~ 24 makeup gain in dB, 0 ~ 24
+    uint8_t reserved;
+} audio_dynamics_config_t;
+
+typedef struct
+{
+    audio_dynamics_config_t cfg;
+    uint32_t sampleRate;
+
+    // 压缩器 compressor
+    int32_t env;         // 立体声联动峰值包络 stereo-linked peak envelope
+    int32_t attackCoef;  // Q30
+    int32_t releaseCoef; // Q30
+    float threshold;
+    float slope;         // 1 - 1/ratio
+    int32_t gain;        // 当前增益 current gain, Q24
+
+    // 限幅器 limiter
+    uint32_t delayLen; // 预读帧数 - 1 look-ahead frames - 1
+    uint32_t delayPos;
+    int32_t delay[AUDIO_DYNAMICS_MAX_LOOKAHEAD * 2];
+    bool delayFill;  // 下一次 process() 先用第一帧填满延迟线 the next process() fills the delay line with its first frame
+    bool limitPrime; // 下一次 process() 先用延迟线里的帧预热检测 the next process() primes the detector from the delay line
+    // 滑动窗口最大值用单调队列, 窗口长度 = 预读帧数
+    // sliding-window maximum as a monotonic queue, window = look-ahead frames
+    uint32_t maxVal[AUDIO_DYNAMICS_MAX_LOOKAHEAD];
+    uint32_t maxAt[AUDIO_DYNAMICS_MAX_LOOKAHEAD];
+    uint32_t maxHead;
+    uint32_t maxCount;
+    uint32_t frameIndex;
+    // 窗口最大值再做一次同长度的滑动平均, 增益在预读时间内平滑地降到位
+    // the window maximum is moving-averaged over the same length, so the gain slides down
+    // smoothly within the look-ahead time
+    uint32_t boxHist[AUDIO_DYNAMICS_MAX_LOOKAHEAD];
+    uint32_t boxSum;
+    uint32_t boxPos;
+    uint32_t boxRecip;   // ceil(2^24 / 窗口长度) ceil(2^24 / window)
+    uint32_t lookahead;  // 窗口长度 window length
+    uint32_t limitEnv;
+    int32_t limitReleaseCoef; // Q30
+    uint32_t ceiling;
+
+    // 最近一次 process() 里最大的增益衰减, 0.1dB
+    // largest gain reduction in the last process() call, 0.1dB
+    uint16_t compReduction;
+    uint16_t limitReduction;
+} audio_dynamics_t;
+
+void audio_dynamics_init(audio_dynamics_t *d, uint32_t sampleRate, const audio_dynamics_config_t *cfg);
+// 换参数保留包络和延迟线, 不会爆音; 只要压缩器或限幅器开着, 延迟线就一直在走, 开关限幅器不改变延迟.
+// 整级从关到开时延迟线用第一帧填满, 从开到关时延迟线里的帧被丢掉, 两者都是一个预读时长的跳变
+// changing parameters keeps the envelopes and delay line, so it does not click; while the
+// compressor or the limiter is on the delay line keeps running, so toggling the limiter does not
+// change the latency. Turning the whole stage on fills the delay line with the first frame and
+// turning it off drops the frames in it, each a one look-ahead jump
+void audio_dynamics_setConfig(audio_dynamics_t *d, const audio_dynamics_config_t *cfg);
+void audio_dynamics_reset(audio_dynamics_t *d);
+bool audio_dynamics_isActive(const audio_dynamics_t *d);
+// 立体声交错, 原地处理; 输出比输入晚 (预读帧数 - 1) 帧
+// interleaved stereo, in place; the output lags the input by (look-ahead frames - 1) frames
+void audio_dynamics_process(audio_dynamics_t *d, int32_t *samples, uint32_t frames);
+
+#endif
@@ -0,0 +1,173 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "audio_biquad.h"
+#include "audio_eq.h"
+#include "audio_seqlock.h"
+
+typedef struct
+{
+    audio_biquad_coef_t coef[AUDIO_EQ_BANDS];
+    bool enabled[AUDIO_EQ_BANDS];
+} eqCoefSet_t;
+
+static uint32_t eq_sampleRate = 44100;
+static audio_eq_band_t eq_bands[AUDIO_EQ_BANDS] = {
+    {AUDIO_EQ_LOW_SHELF, 0, 80, 0, 70},
+    {AUDIO_EQ_PEAKING, 0, 250, 0, 100},
+    {AUDIO_EQ_PEAKING, 0, 1000, 0, 100},
+    {AUDIO_EQ_PEAKING, 0, 4000, 0, 100},
+    {AUDIO_EQ_HIGH_SHELF, 0, 12000, 0, 70},
+};
+
+// 控制线程在序号锁下写入, 音频线程看到序号变化后拷走
+// the control side writes it under the sequence lock, the audio side copies it once it sees
+// the sequence change
+static eqCoefSet_t eq_published;
+static uint32_t eq_seq = 0;
+
+// 以下只在音频线程使用
+// audio thread only below
+static uint32_t eq_seenSeq = 0;
+static audio_biquad_t eq_stages[AUDIO_EQ_BANDS];
+static bool eq_enabled[AUDIO_EQ_BANDS];
+static int32_t eq_fadeBuf[AUDIO_EQ_FADE_FRAMES * 2];
+
+static void designSet(eqCoefSet_t *set)
+{
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+    {
+        const audio_eq_band_t *b = &eq_bands[i];
+        double gainDb = b->gain / 10.0;
+        double q = b->q / 100.0;
+
+        set->enabled[i] = (b->gain != 0 && b->freq > 0 && b->freq < eq_sampleRate / 2 && b->q > 0);
+        if (!set->enabled[i])
+            continue;
+
+        if (b->type == AUDIO_EQ_LOW_SHELF)
+            audio_biquad_designLowShelf(&set->coef[i], eq_sampleRate, b->freq, gainDb, q);
+        else if (b->type == AUDIO_EQ_HIGH_SHELF)
+            audio_biquad_designHighShelf(&set->coef[i], eq_sampleRate, b->freq, gainDb, q);
+        else
+            audio_biquad_designPeaking(&set->coef[i], eq_sampleRate, b->freq, gainDb, q);
+    }
+}
+
+static void publish()
+{
+    eqCoefSet_t set;
+    designSet(&set);
+    audio_seqlock_write(&eq_seq, &eq_published, &set, sizeof(set));
+}
+
+static void clampBand(audio_eq_band_t *b)
+{
+    if (b->gain > AUDIO_EQ_GAIN_MAX_DB10)
+        b->gain = AUDIO_EQ_GAIN_MAX_DB10;
+    if (b->gain < -AUDIO_EQ_GAIN_MAX_DB10)
+        b->gain = -AUDIO_EQ_GAIN_MAX_DB10;
+    if (b->type > AUDIO_EQ_HIGH_SHELF)
+        b->type = AUDIO_EQ_PEAKING;
+}
+
+void audio_eq_init(uint32_t sampleRate)
+{
+    eq_sampleRate = sampleRate;
+    publish();
+}
+
+void audio_eq_setBands(const audio_eq_band_t *bands)
+{
+    memcpy(eq_bands, bands, sizeof(eq_bands));
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+        clampBand(&eq_bands[i]);
+    publish();
+}
+
+void audio_eq_setBand(int index, const audio_eq_band_t *band)
+{
+    if (index < 0 || index >= AUDIO_EQ_BANDS)
+        return;
+    eq_bands[index] = *band;
+    clampBand(&eq_bands[index]);
+    publish();
+}
+
+void audio_eq_getBands(audio_eq_band_t *bands)
+{
+    memcpy(bands, eq_bands, sizeof(eq_bands));
+}
+
+static bool anyEnabled(const bool *enabled)
+{
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+        if (enabled[i])
+            return true;
+    return false;
+}
+
+bool audio_eq_isActive()
+{
+    return anyEnabled(eq_enabled) || audio_seqlock_pending(&eq_seq, eq_seenSeq);
+}
+
+static void runCascade(audio_biquad_t *stages, const bool *enabled, int32_t *samples, uint32_t frames)
+{
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+        if (enabled[i])
+            audio_biquad_processStereo(&stages[i], samples, frames);
+}
+
+// 新旧滤波器从同一状态出发各算一遍, 在这一块里线性交叉淡化, 参数变化不会产生爆音
+// the old and new cascades both run from the same state and are crossfaded linearly over
+// this block, so a parameter change never clicks
+static uint32_t switchCoef(const eqCoefSet_t *next, int32_t *samples, uint32_t frames)
+{
+    uint32_t n = (frames < AUDIO_EQ_FADE_FRAMES) ? frames : AUDIO_EQ_FADE_FRAMES;
+    memcpy(eq_fadeBuf, samples, n * 2 * sizeof(int32_t));
+
+    // 旧
+    // old
+    runCascade(eq_stages, eq_enabled, samples, n);
+
+    // 新: 沿用旧状态, 新打开的段从零开始
+    // new: keeps the old state, newly enabled stages start from zero
+    audio_biquad_t newStages[AUDIO_EQ_BANDS];
+    memcpy(newStages, eq_stages, sizeof(newStages));
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+    {
+        newStages[i].coef = next->coef[i];
+        if (next->enabled[i] && !eq_enabled[i])
+            audio_biquad_reset(&newStages[i]);
+    }
+    runCascade(newStages, next->enabled, eq_fadeBuf, n);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        int32_t t = (int32_t)((i << 15) / n);
+        for (int c = 0; c < 2; c++)
+        {
+            int64_t o = samples[i * 2 + c];
+            int64_t d = eq_fadeBuf[i * 2 + c] - o;
+            samples[i * 2 + c] = (int32_t)(o + ((d * t) >> 15));
+        }
+    }
+
+    memcpy(eq_stages, newStages, sizeof(eq_stages));
+    memcpy(eq_enabled, next->enabled, sizeof(eq_enabled));
+    return n;
+}
+
+void audio_eq_process(int32_t *samples, uint32_t frames)
+{
+    // 正好撞上写入就这一块先用旧的系数, 下一块再取
+    // running into a write keeps the old coefficients for this block and takes them on the next
+    eqCoefSet_t next;
+    uint32_t done = 0;
+    if (audio_seqlock_read(&eq_seq, &eq_seenSeq, &next, &eq_published, sizeof(next)))
+        done = switchCoef(&next, samples, frames);
+
+    runCascade(eq_stages, eq_enabled, samples + done * 2, frames - done);
+}
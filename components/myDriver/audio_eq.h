@@ -0,0 +1,44 @@
+#ifndef __AUDIO_EQ_H_
+#define __AUDIO_EQ_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AUDIO_EQ_BANDS 5
+// 参数改变时新旧滤波器交叉淡化的帧数
+// frames over which the old and new filters are crossfaded when a parameter changes
+#define AUDIO_EQ_FADE_FRAMES 588
+#define AUDIO_EQ_GAIN_MAX_DB10 120
+
+typedef enum
+{
+    AUDIO_EQ_PEAKING = 0,
+    AUDIO_EQ_LOW_SHELF,
+    AUDIO_EQ_HIGH_SHELF,
+} audio_eq_type_t;
+
+// 存进 NVS 的格式, 改动需保持兼容
+// this is the layout stored in NVS, keep it compatible
+typedef struct
+{
+    uint8_t type;   // audio_eq_type_t
+    uint8_t reserved;
+    uint16_t freq;  // Hz
+    int16_t gain;   // 0.1dB, ±AUDIO_EQ_GAIN_MAX_DB10
+    uint16_t q;     // Q * 100, 搁架为斜率 S * 100 (slope S * 100 for shelves)
+} audio_eq_band_t;
+
+void audio_eq_init(uint32_t sampleRate);
+
+// 控制线程调用, 在调用线程里算系数
+// called from control threads, coefficients are computed on the caller's thread
+void audio_eq_setBands(const audio_eq_band_t *bands);
+void audio_eq_setBand(int index, const audio_eq_band_t *band);
+void audio_eq_getBands(audio_eq_band_t *bands);
+
+// 音频线程调用
+// called from the audio thread
+bool audio_eq_isActive();
+void audio_eq_process(int32_t *samples, uint32_t frames);
+
+#endif
@@ -0,0 +1,118 @@
+#include <stdint.h>
+#include <math.h>
+
+#include "audio_fft.h"
+
+#if defined(__has_include)
+#if __has_include("dsps_fft2r.h")
+#include "dsps_fft2r.h"
+#define AUDIO_FFT_ESP_DSP 1
+#endif
+#endif
+
+#ifndef AUDIO_FFT_ESP_DSP
+
+// 旋转因子 e^(-j 2pi k / AUDIO_FFT_MAX_N), 较短的变换跳着取
+// twiddles e^(-j 2pi k / AUDIO_FFT_MAX_N); shorter transforms take every n-th one
+static float fft_twiddle[AUDIO_FFT_MAX_N];
+
+void audio_fft_init()
+{
+    for (int k = 0; k < AUDIO_FFT_MAX_N / 2; k++)
+    {
+        double a = -2.0 * M_PI * k / AUDIO_FFT_MAX_N;
+        fft_twiddle[k * 2] = (float)cos(a);
+        fft_twiddle[k * 2 + 1] = (float)sin(a);
+    }
+}
+
+static void bitReverse(float *data, uint32_t n)
+{
+    for (uint32_t i = 1, j = 0; i < n; i++)
+    {
+        uint32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+        {
+            float re = data[i * 2], im = data[i * 2 + 1];
+            data[i * 2] = data[j * 2];
+            data[i * 2 + 1] = data[j * 2 + 1];
+            data[j * 2] = re;
+            data[j * 2 + 1] = im;
+        }
+    }
+}
+
+// 按时间抽取, 第一级旋转因子为 1 单独做, 省掉一级乘法
+// decimation in time; the first stage has unit twiddles and is done on its own, saving a stage
+// of multiplies
+void audio_fft_complex(float *data, uint32_t n)
+{
+    bitReverse(data, n);
+
+    for (uint32_t i = 0; i < n; i += 2)
+    {
+        float *a = data + i * 2;
+        float re = a[2], im = a[3];
+        a[2] = a[0] - re;
+        a[3] = a[1] - im;
+        a[0] += re;
+        a[1] += im;
+    }
+
+    for (uint32_t half = 2; half < n; half <<= 1)
+    {
+        uint32_t step = AUDIO_FFT_MAX_N / (half * 2);
+        for (uint32_t k = 0; k < half; k++)
+        {
+            float wr = fft_twiddle[k * step * 2];
+            float wi = fft_twiddle[k * step * 2 + 1];
+            for (uint32_t i = k; i < n; i += half * 2)
+            {
+                float *a = data + i * 2;
+                float *b = a + half * 2;
+                float re = b[0] * wr - b[1] * wi;
+                float im = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - re;
+                b[1] = a[1] - im;
+                a[0] += re;
+                a[1] += im;
+            }
+        }
+    }
+}
+
+#else
+
+void audio_fft_init()
+{
+    dsps_fft2r_init_fc32(NULL, AUDIO_FFT_MAX_N);
+}
+
+void audio_fft_complex(float *data, uint32_t n)
+{
+    dsps_fft2r_fc32(data, n);
+    dsps_bit_rev_fc32(data, n);
+}
+
+#endif
+
+// Xl[k] = (Z[k] + conj(Z[n-k])) / 2, Xr[k] = (Z[k] - conj(Z[n-k])) / 2j, 只要功率, 两边的 1/4 合在一起
+// Xl[k] = (Z[k] + conj(Z[n-k])) / 2, Xr[k] = (Z[k] - conj(Z[n-k])) / 2j; only the power is
+// needed, so both 1/4 factors are folded together
+void audio_fft_splitStereo(const float *z, float *powL, float *powR, uint32_t n)
+{
+    for (uint32_t k = 0; k <= n / 2; k++)
+    {
+        uint32_t m = (n - k) & (n - 1);
+        float ar = z[k * 2], ai = z[k * 2 + 1];
+        float br = z[m * 2], bi = z[m * 2 + 1];
+
+        float lr = ar + br, li = ai - bi;
+        float rr = ai + bi, ri = br - ar;
+        powL[k] = (lr * lr + li * li) * 0.25f;
+        powR[k] = (rr * rr + ri * ri) * 0.25f;
+    }
+}
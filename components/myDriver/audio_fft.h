@@ -0,0 +1,21 @@
+#ifndef __AUDIO_FFT_H_
+#define __AUDIO_FFT_H_
+
+#include <stdint.h>
+
+// 浮点复数 FFT, 基 2, 原地, 实部虚部交错; 工程里有 esp-dsp 时用它的汇编版本
+// floating-point complex FFT, radix 2, in place, real and imaginary interleaved; uses the esp-dsp
+// assembly kernels when esp-dsp is part of the build
+#define AUDIO_FFT_MAX_N 1024
+
+void audio_fft_init();
+// n 为 2 的幂且不超过 AUDIO_FFT_MAX_N
+// n must be a power of two no larger than AUDIO_FFT_MAX_N
+void audio_fft_complex(float *data, uint32_t n);
+// 左声道放实部, 右声道放虚部做一次复数 FFT, 这里把结果拆成两个实信号的功率谱, 各 n/2 + 1 个点
+// with the left channel in the real part and the right in the imaginary part, one complex FFT
+// covers both; this splits the result into the power spectra of the two real signals, n/2 + 1
+// points each
+void audio_fft_splitStereo(const float *z, float *powL, float *powR, uint32_t n);
+
+#endif
@@ -0,0 +1,41 @@
+#include <stdint.h>
+
+#include "audio_format.h"
+
+void audio_format_s16ToS32(const int16_t *in, int32_t *out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        out[i] = (int32_t)in[i] << AUDIO_FORMAT_S16_SHIFT;
+}
+
+// 四舍五入, 饱和
+// round and saturate
+void audio_format_s32ToS16(const int32_t *in, int16_t *out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int32_t x = (int32_t)(((int64_t)in[i] + (1 << (AUDIO_FORMAT_S16_SHIFT - 1))) >> AUDIO_FORMAT_S16_SHIFT);
+        if (x > INT16_MAX)
+            x = INT16_MAX;
+        if (x < INT16_MIN)
+            x = INT16_MIN;
+        out[i] = (int16_t)x;
+    }
+}
+
+void audio_format_s16ToWord(const int16_t *in, int32_t *out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        out[i] = (int32_t)in[i] << 16;
+}
+
+bool audio_format_wordToS16(const int32_t *in, int16_t *out, uint32_t count)
+{
+    uint32_t low = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        out[i] = (int16_t)(in[i] >> 16);
+        low |= (uint32_t)in[i] & 0xffff;
+    }
+    return low == 0;
+}
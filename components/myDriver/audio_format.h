@@ -0,0 +1,25 @@
+#ifndef __AUDIO_FORMAT_H_
+#define __AUDIO_FORMAT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 16 位采样左移 14 位放进 32 位: 满幅 = 1<<29, 上面留 12dB 给均衡器提升,
+// 下面 14 位给滤波器留精度
+// 16-bit samples are shifted left by 14 into 32 bits: full scale = 1<<29, leaving 12dB on top
+// for EQ boosts and 14 bits below for filter precision
+#define AUDIO_FORMAT_HEADROOM_BITS 2
+#define AUDIO_FORMAT_S16_SHIFT (16 - AUDIO_FORMAT_HEADROOM_BITS)
+
+void audio_format_s16ToS32(const int16_t *in, int32_t *out, uint32_t count);
+void audio_format_s32ToS16(const int32_t *in, int16_t *out, uint32_t count);
+// 16 位采样直接放到 32 位 I2S 字的高 16 位, 不经过内部格式, 逐位一致
+// 16-bit samples go straight into the top half of a 32-bit I2S word, bypassing the internal
+// format, bit for bit
+void audio_format_s16ToWord(const int16_t *in, int32_t *out, uint32_t count);
+// 上面的逆过程, 取回高 16 位; 有哪个字的低 16 位不是 0 (不是原样的 16 位采样) 就返回 false
+// the reverse of the above, taking the top halves back out; returns false if any word has a
+// non-zero bottom half, i.e. is not an untouched 16-bit sample
+bool audio_format_wordToS16(const int32_t *in, int16_t *out, uint32_t count);
+
+#endif
@@ -0,0 +1,202 @@
+#include <stdint.h>
+
+#include "audio_gain.h"
+
+static inline int16_t sat16(int32_t x)
+{
+    if (x > INT16_MAX)
+        return INT16_MAX;
+    if (x < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)x;
+}
+
+static inline int32_t sat32(int64_t x)
+{
+    if (x > INT32_MAX)
+        return INT32_MAX;
+    if (x < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)x;
+}
+
+// 四舍五入后右移15位, 再饱和
+// round, shift right by 15, then saturate
+static inline int16_t mulQ15(int16_t x, int32_t gain)
+{
+    return sat16((x * gain + (1 << 14)) >> 15);
+}
+
+static inline int32_t mulQ31(int32_t x, int64_t gain)
+{
+    return sat32(((int64_t)x * gain + (1LL << 30)) >> 31);
+}
+
+// 32 位采样乘 Q15 增益, 和 mulQ31(x, gain << 16) 结果相同, 但增益到 4 倍 (1<<17) 时乘积也远在 int64 以内
+// a 32-bit sample times a Q15 gain: the same result as mulQ31(x, gain << 16), but at 4x (1<<17)
+// the product is still far inside int64
+static inline int32_t mulQ15S32(int32_t x, int32_t gain)
+{
+    return sat32(((int64_t)x * gain + (1 << 14)) >> 15);
+}
+
+static void applyQ15S32(int32_t *samples, uint32_t count, int32_t gain)
+{
+    if (gain == AUDIO_GAIN_UNITY_Q15)
+        return;
+
+    int32_t *p = samples;
+    uint32_t n = count / 4;
+    while (n--)
+    {
+        p[0] = mulQ15S32(p[0], gain);
+        p[1] = mulQ15S32(p[1], gain);
+        p[2] = mulQ15S32(p[2], gain);
+        p[3] = mulQ15S32(p[3], gain);
+        p += 4;
+    }
+    for (uint32_t i = 0; i < count % 4; i++)
+        p[i] = mulQ15S32(p[i], gain);
+}
+
+void audio_gain_applyQ15_ref(int16_t *samples, uint32_t count, int32_t gain)
+{
+    for (uint32_t i = 0; i < count; i++)
+        samples[i] = mulQ15(samples[i], gain);
+}
+
+void audio_gain_applyQ31_ref(int32_t *samples, uint32_t count, int64_t gain)
+{
+    for (uint32_t i = 0; i < count; i++)
+        samples[i] = mulQ31(samples[i], gain);
+}
+
+// 每次处理 4 个采样 (两个立体声帧), 循环开销减为四分之一,
+// 四个乘法之间没有依赖, 可以把流水线排满
+// four samples (two stereo frames) per iteration: a quarter of the loop overhead,
+// and the four independent multiplies keep the pipeline full
+void audio_gain_applyQ15(int16_t *samples, uint32_t count, int32_t gain)
+{
+    if (gain == AUDIO_GAIN_UNITY_Q15)
+        return;
+
+    int16_t *p = samples;
+    uint32_t n = count / 4;
+    while (n--)
+    {
+        p[0] = mulQ15(p[0], gain);
+        p[1] = mulQ15(p[1], gain);
+        p[2] = mulQ15(p[2], gain);
+        p[3] = mulQ15(p[3], gain);
+        p += 4;
+    }
+
+    audio_gain_applyQ15_ref(p, count % 4, gain);
+}
+
+void audio_gain_applyQ31(int32_t *samples, uint32_t count, int64_t gain)
+{
+    if (gain == AUDIO_GAIN_UNITY_Q31)
+        return;
+
+    int32_t *p = samples;
+    uint32_t n = count / 4;
+    while (n--)
+    {
+        p[0] = mulQ31(p[0], gain);
+        p[1] = mulQ31(p[1], gain);
+        p[2] = mulQ31(p[2], gain);
+        p[3] = mulQ31(p[3], gain);
+        p += 4;
+    }
+
+    audio_gain_applyQ31_ref(p, count % 4, gain);
+}
+
+void audio_gain_init(audio_gain_t *g, int32_t gain, uint32_t rampFrames)
+{
+    g->target = gain;
+    g->acc = gain << AUDIO_GAIN_RAMP_SHIFT;
+    g->step = 0;
+    g->remain = 0;
+    g->rampFrames = rampFrames;
+}
+
+void audio_gain_setTarget(audio_gain_t *g, int32_t target)
+{
+    if (target == g->target)
+        return;
+
+    g->target = target;
+    if (g->rampFrames == 0)
+    {
+        g->acc = target << AUDIO_GAIN_RAMP_SHIFT;
+        g->remain = 0;
+        return;
+    }
+
+    // 从当前位置 (可能还在上一次渐变中) 重新开始渐变
+    // restart the ramp from wherever we are, possibly in the middle of the previous one
+    g->step = ((target << AUDIO_GAIN_RAMP_SHIFT) - g->acc) / (int32_t)g->rampFrames;
+    g->remain = g->rampFrames;
+}
+
+// 立体声交错数据, 渐变段每帧只多一次加法和一次移位, 之后的恒定段走 applyQ15
+// interleaved stereo; the ramp costs one add and one shift per frame over a constant gain,
+// and the constant part after the ramp goes through applyQ15
+void audio_gain_processQ15(audio_gain_t *g, int16_t *samples, uint32_t frames)
+{
+    uint32_t n = (g->remain < frames) ? g->remain : frames;
+    int32_t acc = g->acc;
+    const int32_t step = g->step;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        acc += step;
+        int32_t gain = acc >> AUDIO_GAIN_RAMP_SHIFT;
+        samples[0] = mulQ15(samples[0], gain);
+        samples[1] = mulQ15(samples[1], gain);
+        samples += 2;
+    }
+
+    g->remain -= n;
+    if (g->remain == 0)
+        acc = g->target << AUDIO_GAIN_RAMP_SHIFT; // 消除整除误差 drop the division residue
+    g->acc = acc;
+
+    audio_gain_applyQ15(samples, (frames - n) * 2, g->target);
+}
+
+// 内部 32 位格式, 增益仍是 Q15, 直接乘 Q15 增益再舍入右移 15 位, 低于 0dB 时低位不再被截掉.
+// 不经过 Q31 (增益左移 16 位): 音轨增益让音量超过 0dB 时, 满幅采样乘 4 倍的 Q31 增益会超出 int64
+// internal 32-bit format; the gain is still Q15, multiplied in directly and rounded down by 15
+// bits, so the low bits are no longer cut off below 0dB. It does not go through Q31 (the gain
+// shifted left by 16): with a track gain taking the volume above 0dB, a full-scale sample times a
+// 4x Q31 gain would overflow int64
+void audio_gain_processS32(audio_gain_t *g, int32_t *samples, uint32_t frames)
+{
+    uint32_t n = (g->remain < frames) ? g->remain : frames;
+    int32_t acc = g->acc;
+    const int32_t step = g->step;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        acc += step;
+        int32_t gain = acc >> AUDIO_GAIN_RAMP_SHIFT;
+        samples[0] = mulQ15S32(samples[0], gain);
+        samples[1] = mulQ15S32(samples[1], gain);
+        samples += 2;
+    }
+
+    g->remain -= n;
+    if (g->remain == 0)
+        acc = g->target << AUDIO_GAIN_RAMP_SHIFT; // 消除整除误差 drop the division residue
+    g->acc = acc;
+
+    applyQ15S32(samples, (frames - n) * 2, g->target);
+}
+
+bool audio_gain_isUnity(const audio_gain_t *g)
+{
+    return g->remain == 0 && g->target == AUDIO_GAIN_UNITY_Q15;
+}
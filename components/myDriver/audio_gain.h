@@ -0,0 +1,45 @@
+#ifndef __AUDIO_GAIN_H_
+#define __AUDIO_GAIN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Q15 增益, 32768 = 0dB
+// Q15 gain, 32768 = 0dB
+#define AUDIO_GAIN_UNITY_Q15 32768
+// Q31 增益用 int64 传递, 1<<31 = 0dB
+// Q31 gain is passed as int64, 1<<31 = 0dB
+#define AUDIO_GAIN_UNITY_Q31 (1LL << 31)
+
+// 渐变增益, 音量改变时在 rampFrames 帧内线性过渡, 避免拉链噪声
+// ramped gain: a volume change slides linearly over rampFrames frames to avoid zipper noise
+typedef struct
+{
+    int32_t target;      // 目标增益 target gain, Q15
+    int32_t acc;         // 当前增益 current gain, Q15 << AUDIO_GAIN_RAMP_SHIFT
+    int32_t step;        // 每帧增量 increment per frame
+    uint32_t remain;     // 渐变剩余帧数 frames left in the ramp
+    uint32_t rampFrames; // 渐变长度 ramp length
+} audio_gain_t;
+
+#define AUDIO_GAIN_RAMP_SHIFT 12
+
+void audio_gain_init(audio_gain_t *g, int32_t gain, uint32_t rampFrames);
+void audio_gain_setTarget(audio_gain_t *g, int32_t target);
+void audio_gain_processQ15(audio_gain_t *g, int16_t *samples, uint32_t frames);
+void audio_gain_processS32(audio_gain_t *g, int32_t *samples, uint32_t frames);
+// 0dB 且不在渐变中, 这时可以跳过整个增益级
+// at 0dB and not ramping, the whole gain stage can be skipped
+bool audio_gain_isUnity(const audio_gain_t *g);
+
+void audio_gain_applyQ15(int16_t *samples, uint32_t count, int32_t gain);
+// 增益不能超过 2 倍 (1<<32), 否则满幅采样的乘积超出 int64
+// the gain must not exceed 2x (1<<32), or a full-scale sample's product overflows int64
+void audio_gain_applyQ31(int32_t *samples, uint32_t count, int64_t gain);
+
+// 逐点参考实现, 与上面结果逐位一致, 用于校验和基准测试
+// one-sample-at-a-time reference, bit-identical to the above, used by verification and benchmark
+void audio_gain_applyQ15_ref(int16_t *samples, uint32_t count, int32_t gain);
+void audio_gain_applyQ31_ref(int32_t *samples, uint32_t count, int64_t gain);
+
+#endif
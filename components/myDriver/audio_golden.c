@@ -0,0 +1,424 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_gain.h"
+#include "audio_biquad.h"
+#include "audio_format.h"
+#include "audio_eq.h"
+#include "audio_src.h"
+#include "audio_dither.h"
+#include "audio_crossfeed.h"
+#include "audio_matrix.h"
+#include "audio_meter.h"
+#include "audio_golden.h"
+
+// 和 audio_graph 一样: 板子上用 CPU 周期计数器和 ROM 里的 CRC32, 主机上用纳秒 (1GHz) 和同样多项式的查表
+// as in audio_graph: the CPU cycle counter and the ROM CRC32 on the board; on a host nanoseconds
+// (at 1GHz) and a table CRC with the same polynomial
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_rom_crc.h"
+#include "sdkconfig.h"
+#define GOLDEN_CPU_MHZ CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define goldenCycles() esp_cpu_get_cycle_count()
+#define goldenCrc(buf, len) esp_rom_crc32_le(0, (const uint8_t *)(buf), (len))
+#else
+#include <stdio.h>
+#include <time.h>
+#define GOLDEN_CPU_MHZ 1000
+#define ESP_LOGI(tag, fmt, ...) printf("%s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...) printf("%s: " fmt "\n", tag, ##__VA_ARGS__)
+static uint32_t goldenCycles()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+// CRC-32 (IEEE 802.3, 反射), 与 esp_rom_crc32_le(0, ...) 和 zlib crc32 相同
+// CRC-32 (IEEE 802.3, reflected), the same as esp_rom_crc32_le(0, ...) and zlib's crc32
+static uint32_t goldenCrc(const void *buf, uint32_t len)
+{
+    static uint32_t table[256];
+    if (table[1] == 0)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? (c >> 1) ^ 0xedb88320 : c >> 1;
+            table[i] = c;
+        }
+    }
+    const uint8_t *p = (const uint8_t *)buf;
+    uint32_t crc = 0xffffffff;
+    while (len--)
+        crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+#endif
+
+#define GOLDEN_SAMPLES (AUDIO_GOLDEN_FRAMES * 2)
+// 音频线程一块一个扇区
+// the audio thread works one sector per block
+#define GOLDEN_BLOCK_FRAMES 588
+
+// 改动了某个环节的算法后, 在主机上跑 host/ 里的 audio_golden_host --generate, 确认新输出是对的,
+// 再把打印出来的表贴回这里, 板子上的基准测试会对同一张表
+// after changing a stage's algorithm, run audio_golden_host --generate from host/, confirm the
+// new output is right and paste the table it prints back here; the benchmark on the board checks
+// against the same table
+static const struct
+{
+    const char *name;
+    uint32_t crc;
+} goldenTable[] = {
+    {"gain ramp", 0x89c4f9cc},
+    {"de-emphasis", 0xb98aa070},
+    {"eq 5 bands", 0x74210f6d},
+    {"src 48k high", 0xba24d5ad},
+    {"dither tpdf", 0x38e4cd48},
+    {"dither shaped", 0xd5352662},
+    {"crossfeed", 0xc2908795},
+    {"matrix", 0x165802d8},
+};
+
+// 以下系数是 glibc 上设计出来的结果, 内核金样直接用它们; 设计检查拿当前 libm 的结果和它们比较
+// the coefficients below are what the designs give on glibc; the kernel goldens use them as they
+// are, and the design checks compare the running libm's result against them
+
+// 50/15us 去加重 50/15us de-emphasis
+static const audio_biquad_coef_t goldenDeemph = {123573081, -23537736, 0, -168400111, 0};
+
+// 均衡器默认的 5 段, 每段 +3dB, 44.1kHz
+// the EQ's five default bands at +3dB each, 44.1kHz
+static const struct
+{
+    uint8_t type;
+    uint16_t freq;
+    uint16_t q; // * 100
+    audio_biquad_coef_t coef;
+} goldenEq[AUDIO_EQ_BANDS] = {
+    {AUDIO_EQ_LOW_SHELF, 80, 70, {268882636, -532123099, 263281547, -532129098, 263722727}},
+    {AUDIO_EQ_PEAKING, 250, 100, {270070030, -528610921, 258876395, -528610921, 260510969}},
+    {AUDIO_EQ_PEAKING, 1000, 100, {274677781, -501474631, 231930068, -501474631, 238172393}},
+    {AUDIO_EQ_PEAKING, 4000, 100, {288921847, -368398253, 148630150, -368398253, 169116540}},
+    {AUDIO_EQ_HIGH_SHELF, 12000, 70, {314917468, 18072924, 26297761, 65260460, 25592236}},
+};
+
+// 交叉馈送 MEDIUM, 44.1kHz: loA0, loB1, hiA0, hiA1, hiB1
+// crossfeed MEDIUM at 44.1kHz: loA0, loB1, hiA0, hiA1, hiB1
+static const int32_t goldenCrossfeed[5] = {40575361, 971821124, 1045099822, -934481087, 934481087};
+
+// 重采样 LOW 档 44.1k -> 48k 第 64 相 (两个输入采样正中间)
+// phase 64 of the LOW resampler 44.1k -> 48k, halfway between two input samples
+static const int32_t goldenSrcPhase[16] = {
+    -2076019, 6681263, -15708885, 31603537, -58492298, 105920150, -208209878, 677153043,
+    677153043, -208209878, 105920150, -58492298, 31603537, -15708885, 6681263, -2076019,
+};
+
+// 伪随机满幅测试信号, 与基准测试的一样
+// pseudo random full scale test signal, the same as the benchmark's
+static void fillNoise(int16_t *buf, uint32_t count)
+{
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        buf[i] = (int16_t)(seed >> 16);
+    }
+}
+
+// 1kHz, -6dBFS 正弦, 整数递推生成, 每个平台都一样: y[n] = 2cos(w) y[n-1] - y[n-2], 内部多 15 位精度
+// 1kHz sine at -6dBFS from an integer recursion, identical on every platform:
+// y[n] = 2cos(w) y[n-1] - y[n-2], with 15 extra bits inside
+#define GOLDEN_SINE_COS_Q30 1062862106 // cos(2pi 1000 / 44100)
+#define GOLDEN_SINE_Y1 76232619        // 16384 << 15 * sin(2pi 1000 / 44100)
+
+static void fillSine(int16_t *buf, uint32_t count)
+{
+    int64_t y2 = 0, y1 = GOLDEN_SINE_Y1;
+    buf[0] = buf[1] = 0;
+    for (uint32_t i = 2; i < count; i += 2)
+    {
+        int16_t s = (int16_t)((y1 + (1 << 14)) >> 15);
+        buf[i] = buf[i + 1] = s;
+        int64_t y = ((2 * GOLDEN_SINE_COS_Q30 * y1 + (1 << 29)) >> 30) - y2;
+        y2 = y1;
+        y1 = y;
+    }
+}
+
+// 重采样内核用的表: 伪随机系数, 幅度 2^23 以内, 累加不会溢出; 内核的相位推进, 插值和舍入都逐位固定,
+// 滤波器本身的质量由主机上的 THD+N 测试负责
+// the table for the resampler kernel: pseudo random coefficients below 2^23, so the sums cannot
+// overflow; the kernel's phase stepping, interpolation and rounding are pinned bit for bit, and
+// the filter's own quality is left to the THD+N test on the host
+static void fillSrcTable(int32_t *table, uint32_t count)
+{
+    uint32_t seed = 0x9e3779b9;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        table[i] = (int32_t)seed >> 9;
+    }
+}
+
+static int32_t coefError(const int32_t *a, const int32_t *b, int n)
+{
+    int32_t worst = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int32_t e = abs(a[i] - b[i]);
+        if (e > worst)
+            worst = e;
+    }
+    return worst;
+}
+
+typedef struct
+{
+    audio_golden_result_t *results;
+    int count;
+    int crcIndex;
+} goldenRun_t;
+
+static void addCrc(goldenRun_t *run, const int32_t *samples, uint32_t count, uint32_t cycles)
+{
+    audio_golden_result_t *r = &run->results[run->count++];
+    memset(r, 0, sizeof(audio_golden_result_t));
+    r->name = goldenTable[run->crcIndex].name;
+    r->kind = AUDIO_GOLDEN_CRC;
+    r->crc = goldenCrc(samples, count * sizeof(int32_t));
+    r->expected = goldenTable[run->crcIndex++].crc;
+    r->ok = (r->crc == r->expected);
+    r->samples = count;
+    r->cycles = cycles;
+}
+
+static void addDesign(goldenRun_t *run, const char *name, int32_t error)
+{
+    audio_golden_result_t *r = &run->results[run->count++];
+    memset(r, 0, sizeof(audio_golden_result_t));
+    r->name = name;
+    r->kind = AUDIO_GOLDEN_DESIGN;
+    r->error = error;
+    r->ok = (error <= AUDIO_GOLDEN_DESIGN_LSB);
+}
+
+static void checkDesigns(goldenRun_t *run)
+{
+    audio_biquad_coef_t coef;
+    audio_biquad_designDeemphasis(&coef);
+    addDesign(run, "de-emphasis", coefError(&coef.b0, &goldenDeemph.b0, 5));
+
+    int32_t worst = 0;
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+    {
+        double q = goldenEq[i].q / 100.0;
+        if (goldenEq[i].type == AUDIO_EQ_LOW_SHELF)
+            audio_biquad_designLowShelf(&coef, 44100, goldenEq[i].freq, 3.0, q);
+        else if (goldenEq[i].type == AUDIO_EQ_HIGH_SHELF)
+            audio_biquad_designHighShelf(&coef, 44100, goldenEq[i].freq, 3.0, q);
+        else
+            audio_biquad_designPeaking(&coef, 44100, goldenEq[i].freq, 3.0, q);
+        int32_t e = coefError(&coef.b0, &goldenEq[i].coef.b0, 5);
+        if (e > worst)
+            worst = e;
+    }
+    addDesign(run, "eq", worst);
+
+    audio_crossfeed_t c;
+    audio_crossfeed_init(&c, 44100, AUDIO_CROSSFEED_MEDIUM);
+    const int32_t cf[5] = {c.loA0, c.loB1, c.hiA0, c.hiA1, c.hiB1};
+    addDesign(run, "crossfeed", coefError(cf, goldenCrossfeed, 5));
+
+    audio_src_t src;
+    if (audio_src_init(&src, 44100, 48000, AUDIO_SRC_LOW, GOLDEN_BLOCK_FRAMES) != ESP_OK)
+    {
+        addDesign(run, "src", INT32_MAX);
+        return;
+    }
+    addDesign(run, "src", coefError(src.table + AUDIO_SRC_PHASES / 2 * src.taps, goldenSrcPhase, 16));
+    audio_src_deinit(&src);
+}
+
+int audio_golden_run(audio_golden_result_t *results)
+{
+    static int16_t noise[GOLDEN_SAMPLES];
+    static int16_t sine[GOLDEN_SAMPLES];
+    static int32_t buf[GOLDEN_SAMPLES];
+    static int32_t srcOut[AUDIO_SRC_MAX_OUT(AUDIO_GOLDEN_FRAMES, 44100, 48000) * 2];
+    const uint32_t frames = AUDIO_GOLDEN_FRAMES;
+    goldenRun_t run = {results, 0, 0};
+    uint32_t t0, cycles;
+
+    fillNoise(noise, GOLDEN_SAMPLES);
+    fillSine(sine, GOLDEN_SAMPLES);
+
+    // 音量从 -18.6dB 渐变到 -2.1dB, 整个缓冲区都在渐变
+    // volume sliding from -18.6dB to -2.1dB across the whole buffer
+    audio_gain_t g;
+    audio_gain_init(&g, 3841, frames);
+    audio_gain_setTarget(&g, 25823);
+    audio_format_s16ToS32(noise, buf, GOLDEN_SAMPLES);
+    t0 = goldenCycles();
+    audio_gain_processS32(&g, buf, frames);
+    cycles = goldenCycles() - t0;
+    addCrc(&run, buf, GOLDEN_SAMPLES, cycles);
+
+    audio_biquad_t bq;
+    audio_biquad_init(&bq, &goldenDeemph);
+    audio_format_s16ToS32(sine, buf, GOLDEN_SAMPLES);
+    t0 = goldenCycles();
+    audio_biquad_processStereo(&bq, buf, frames);
+    cycles = goldenCycles() - t0;
+    addCrc(&run, buf, GOLDEN_SAMPLES, cycles);
+
+    // 均衡器的级联, 5 段都从零状态开始, 和 audio_eq 打开全部 5 段之后一样
+    // the EQ cascade with all five stages starting from zero, as audio_eq runs once all five are on
+    audio_biquad_t eq[AUDIO_EQ_BANDS];
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+        audio_biquad_init(&eq[i], &goldenEq[i].coef);
+    audio_format_s16ToS32(noise, buf, GOLDEN_SAMPLES);
+    t0 = goldenCycles();
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+        audio_biquad_processStereo(&eq[i], buf, frames);
+    cycles = goldenCycles() - t0;
+    addCrc(&run, buf, GOLDEN_SAMPLES, cycles);
+
+    audio_src_t src;
+    if (audio_src_init(&src, 44100, 48000, AUDIO_SRC_HIGH, frames) != ESP_OK)
+        return run.count;
+    fillSrcTable(src.table, (AUDIO_SRC_PHASES + 1) * src.taps);
+    audio_format_s16ToS32(sine, buf, GOLDEN_SAMPLES);
+    t0 = goldenCycles();
+    uint32_t outFrames = audio_src_process(&src, buf, frames, srcOut, sizeof(srcOut) / 8);
+    cycles = goldenCycles() - t0;
+    audio_src_deinit(&src);
+    addCrc(&run, srcOut, outFrames * 2, cycles);
+
+    // 抖动到 16 位, 量化和噪声都看得见
+    // dither to 16 bits, so both the quantization and the noise show
+    audio_dither_t d;
+    for (int mode = AUDIO_DITHER_TPDF; mode <= AUDIO_DITHER_SHAPED; mode++)
+    {
+        audio_dither_init(&d, mode, 16);
+        audio_format_s16ToS32(sine, buf, GOLDEN_SAMPLES);
+        t0 = goldenCycles();
+        audio_dither_process(&d, buf, frames);
+        cycles = goldenCycles() - t0;
+        addCrc(&run, buf, GOLDEN_SAMPLES, cycles);
+    }
+
+    audio_crossfeed_t c;
+    memset(&c, 0, sizeof(c));
+    c.level = AUDIO_CROSSFEED_MEDIUM;
+    c.loA0 = goldenCrossfeed[0];
+    c.loB1 = goldenCrossfeed[1];
+    c.hiA0 = goldenCrossfeed[2];
+    c.hiA1 = goldenCrossfeed[3];
+    c.hiB1 = goldenCrossfeed[4];
+    audio_format_s16ToS32(noise, buf, GOLDEN_SAMPLES);
+    t0 = goldenCycles();
+    audio_crossfeed_process(&c, buf, frames);
+    cycles = goldenCycles() - t0;
+    addCrc(&run, buf, GOLDEN_SAMPLES, cycles);
+
+    // 从单位矩阵渐变到全部打开, 过渡段和恒定段都在里面; 矩阵的设计只有四则运算和 lrint, 各平台一样
+    // sliding from identity to everything on, covering both the slide and the constant part; the
+    // matrix design is plain arithmetic and lrint, the same everywhere
+    static const audio_matrix_config_t unity = {0, AUDIO_MATRIX_WIDTH_UNITY, 0, 0, 0, {0}};
+    static const audio_matrix_config_t all = {-30, 150, 0, 1, 2, {0}};
+    audio_matrix_t m;
+    audio_matrix_init(&m, &unity, GOLDEN_BLOCK_FRAMES);
+    audio_matrix_setConfig(&m, &all);
+    audio_format_s16ToS32(noise, buf, GOLDEN_SAMPLES);
+    t0 = goldenCycles();
+    audio_matrix_process(&m, buf, frames);
+    cycles = goldenCycles() - t0;
+    addCrc(&run, buf, GOLDEN_SAMPLES, cycles);
+
+    // 电平表: 2 秒正弦之后峰值和 RMS (AES17) 都应读 -6.02dBFS
+    // meter: after 2 seconds of sine both peak and RMS (AES17) should read -6.02dBFS
+    audio_format_s16ToS32(sine, buf, GOLDEN_SAMPLES);
+    cycles = 0;
+    uint32_t samples = 0;
+    for (uint32_t n = 0; n < 2 * 44100; n += GOLDEN_BLOCK_FRAMES)
+    {
+        t0 = goldenCycles();
+        audio_meter_process(buf + n % frames * 2, GOLDEN_BLOCK_FRAMES, 44100, AUDIO_FORMAT_HEADROOM_BITS);
+        cycles += goldenCycles() - t0;
+        samples += GOLDEN_BLOCK_FRAMES * 2;
+    }
+    audio_golden_result_t *r = &results[run.count++];
+    memset(r, 0, sizeof(audio_golden_result_t));
+    r->name = "meter";
+    r->kind = AUDIO_GOLDEN_LEVEL;
+    r->samples = samples;
+    r->cycles = cycles;
+    audio_meter_snapshot_t snap;
+    r->ok = audio_meter_read(&snap);
+    r->error = r->ok ? 0 : INT32_MAX;
+    for (int ch = 0; r->ok && ch < 2; ch++)
+    {
+        float e = fmaxf(fabsf(snap.peak[ch] + 6.02f), fabsf(snap.rms[ch] + 6.02f));
+        if (e * 100 > r->error)
+            r->error = (int32_t)(e * 100);
+    }
+    r->ok = r->ok && r->error < 10;
+
+    checkDesigns(&run);
+    return run.count;
+}
+
+int audio_golden_log(const audio_golden_result_t *results, int count, const char *tag)
+{
+    int failed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const audio_golden_result_t *r = &results[i];
+        failed += !r->ok;
+        if (r->kind == AUDIO_GOLDEN_DESIGN)
+        {
+            if (r->ok)
+                ESP_LOGI(tag, "design %-14s %ld LSB, ok", r->name, (long)r->error);
+            else
+                ESP_LOGE(tag, "design %-14s %ld LSB, more than %d", r->name, (long)r->error, AUDIO_GOLDEN_DESIGN_LSB);
+            continue;
+        }
+
+        // 0.1ns 单位 in 0.1ns
+        uint32_t ns10 = (uint32_t)((uint64_t)r->cycles * 10000 / GOLDEN_CPU_MHZ / r->samples);
+        uint32_t mbps = (uint32_t)((uint64_t)r->samples * sizeof(int32_t) * GOLDEN_CPU_MHZ / (r->cycles ? r->cycles : 1));
+        if (r->kind == AUDIO_GOLDEN_LEVEL)
+        {
+            if (r->ok)
+                ESP_LOGI(tag, "golden %-14s %4lu.%lu ns/sample, ok", r->name, (unsigned long)ns10 / 10, (unsigned long)ns10 % 10);
+            else
+                ESP_LOGE(tag, "golden %-14s %4lu.%lu ns/sample, off by %ld.%02ld dB", r->name,
+                         (unsigned long)ns10 / 10, (unsigned long)ns10 % 10, (long)r->error / 100, (long)r->error % 100);
+        }
+        else if (r->ok)
+        {
+            ESP_LOGI(tag, "golden %-14s %4lu.%lu ns/sample, %4lu MB/s, ok",
+                     r->name, (unsigned long)ns10 / 10, (unsigned long)ns10 % 10, (unsigned long)mbps);
+        }
+        else
+        {
+            ESP_LOGE(tag, "golden %-14s %4lu.%lu ns/sample, %4lu MB/s, crc %08lx expected %08lx",
+                     r->name, (unsigned long)ns10 / 10, (unsigned long)ns10 % 10, (unsigned long)mbps,
+                     (unsigned long)r->crc, (unsigned long)r->expected);
+        }
+    }
+
+    if (failed)
+        ESP_LOGE(tag, "golden: %d of %d check(s) FAILED", failed, count);
+    else
+        ESP_LOGI(tag, "golden: all %d checks match", count);
+    return failed;
+}
@@ -0,0 +1,52 @@
+#ifndef __AUDIO_GOLDEN_H_
+#define __AUDIO_GOLDEN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 金样: 每个整数环节从干净的状态处理标准信号, 输出的 CRC32 和表里记下的对比. 环节的系数取自固定的整数表,
+// 不经过 libm, 所以板子 (newlib) 和主机 (glibc) 上的 CRC 一样; 滤波器设计另外检查, 用当前的 libm 算出的
+// 系数和表里的差几个 LSB 以内就算对. 板子上由 audio_bench 调用, 主机上由 host/ 里的程序调用
+// golden outputs: every integer stage processes a standard signal from a clean state and the
+// CRC32 of its output is compared against the table. The stages take their coefficients from
+// fixed integer tables rather than libm, so the CRCs are the same on the board (newlib) and on a
+// host (glibc); the filter designs are checked separately, passing when the coefficients the
+// running libm produces are within a few LSB of the table. audio_bench runs this on the board,
+// the program in host/ on a PC
+
+#define AUDIO_GOLDEN_MAX_RESULTS 16
+// 同一 4704 帧缓冲区, 与基准测试一样
+// the same 4704-frame buffer as the benchmark
+#define AUDIO_GOLDEN_FRAMES 4704
+// 设计检查允许的误差 (LSB), 各家 libm 的舍入差异只会让个别系数差 1
+// error allowed by the design checks, in LSB; rounding differences between libms move the odd
+// coefficient by 1
+#define AUDIO_GOLDEN_DESIGN_LSB 2
+
+typedef enum
+{
+    AUDIO_GOLDEN_CRC = 0, // 输出逐位比较 output compared bit for bit
+    AUDIO_GOLDEN_DESIGN,  // 系数在容差内 coefficients within tolerance
+    AUDIO_GOLDEN_LEVEL,   // 电平表读数在 0.1dB 内 meter reading within 0.1dB
+} audio_golden_kind_t;
+
+typedef struct
+{
+    const char *name;
+    uint8_t kind;      // audio_golden_kind_t
+    bool ok;
+    uint32_t crc;      // 这次的 CRC this run's CRC
+    uint32_t expected; // 表里的 CRC the table's CRC
+    int32_t error;     // 设计: 最大误差 LSB; 电平表: 最大误差 0.01dB design: largest error in LSB; meter: in 0.01dB
+    uint32_t samples;  // 处理的采样数, 设计检查为 0 samples processed, 0 for design checks
+    uint32_t cycles;
+} audio_golden_result_t;
+
+// 跑全部检查, 返回结果条数
+// runs every check and returns the number of results
+int audio_golden_run(audio_golden_result_t *results);
+// 按 ns/采样和 MB/s 打印速度, 返回失败的条数
+// logs each result with its speed in ns/sample and MB/s; returns the number that failed
+int audio_golden_log(const audio_golden_result_t *results, int count, const char *tag);
+
+#endif
@@ -0,0 +1,208 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "audio_graph.h"
+
+// 板子上用 CPU 周期计数器; 在主机上离线跑同一张图时用纳秒代替, "CPU 频率" 就是 1GHz
+// on the board the CPU cycle counter is used; when the same graph is run offline on a host,
+// nanoseconds stand in for it and the "CPU clock" is 1GHz
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+#define GRAPH_CPU_HZ ((uint64_t)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000)
+#define graphCycles() esp_cpu_get_cycle_count()
+#else
+#include <stdio.h>
+#include <time.h>
+#define GRAPH_CPU_HZ 1000000000ull
+#define ESP_LOGI(tag, fmt, ...) printf("%s: " fmt "\n", tag, ##__VA_ARGS__)
+static uint32_t graphCycles()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+#endif
+
+void audio_graph_init(audio_graph_t *g, uint32_t outRate, uint8_t budgetPercent, audio_sink_fn_t sink, void *sinkCtx)
+{
+    memset(g, 0, sizeof(audio_graph_t));
+    g->outRate = outRate;
+    g->budgetPercent = budgetPercent;
+    g->sink = sink;
+    g->sinkCtx = sinkCtx;
+}
+
+int audio_graph_add(audio_graph_t *g, const char *name, audio_stage_fn_t process, void *ctx, bool passive, uint32_t maxFrames)
+{
+    if (g->count == AUDIO_GRAPH_MAX_STAGES)
+        return -1;
+
+    audio_stage_t *s = &g->stage[g->count];
+    memset(s, 0, sizeof(audio_stage_t));
+    s->name = name;
+    s->process = process;
+    s->ctx = ctx;
+    s->bypass = true;
+    s->passive = passive;
+    s->maxFrames = maxFrames;
+    return g->count++;
+}
+
+void audio_graph_setOutputRate(audio_graph_t *g, uint32_t outRate)
+{
+    g->outRate = outRate;
+}
+
+void audio_graph_setLatency(audio_graph_t *g, int index, uint32_t latencyUs)
+{
+    g->stage[index].latencyUs = latencyUs;
+}
+
+static void rebuild(audio_graph_t *g)
+{
+    g->runCount = 0;
+    g->activeCount = 0;
+    for (uint8_t i = 0; i < g->count; i++)
+    {
+        if (g->stage[i].bypass)
+            continue;
+        g->run[g->runCount++] = i;
+        if (!g->stage[i].passive)
+            g->activeCount++;
+    }
+    g->dirty = false;
+}
+
+bool audio_graph_isActive(audio_graph_t *g)
+{
+    if (g->dirty)
+        rebuild(g);
+    return g->activeCount > 0;
+}
+
+uint32_t audio_graph_latencyUs(const audio_graph_t *g)
+{
+    uint32_t us = 0;
+    for (uint8_t i = 0; i < g->count; i++)
+        if (!g->stage[i].bypass)
+            us += g->stage[i].latencyUs;
+    return us;
+}
+
+// 从执行列表的第 r 项往后跑; 数据超过环节一次能收的帧数时分段递归, 每段跑完整个剩下的列表.
+// 换了缓冲区的环节在下一次被调用前, 它的输出已经全部送走了
+// runs the run list from entry r on; when the data is more than a stage takes at once, it recurses
+// piece by piece, each piece running the rest of the list. By the time a stage that switched
+// buffers is called again, all of its previous output has been passed on
+static esp_err_t runFrom(audio_graph_t *g, uint8_t r, int32_t *samples, uint32_t frames, uint32_t *cycles, uint32_t *outFrames)
+{
+    for (; r < g->runCount; r++)
+    {
+        audio_stage_t *s = &g->stage[g->run[r]];
+
+        if (s->maxFrames && frames > s->maxFrames)
+        {
+            esp_err_t err = ESP_OK;
+            for (uint32_t c = 0; c < frames && err == ESP_OK; c += s->maxFrames)
+            {
+                uint32_t piece = (frames - c < s->maxFrames) ? frames - c : s->maxFrames;
+                err = runFrom(g, r, samples + c * 2, piece, cycles, outFrames);
+            }
+            return err;
+        }
+
+        int32_t *out = samples;
+
+#if AUDIO_GRAPH_PROFILE
+        uint32_t t0 = graphCycles();
+        uint32_t n = s->process(s->ctx, samples, frames, &out);
+        uint32_t dt = graphCycles() - t0;
+        s->calls++;
+        s->cycles += dt;
+        if (dt > s->maxCycles)
+            s->maxCycles = dt;
+        *cycles += dt;
+#else
+        uint32_t n = s->process(s->ctx, samples, frames, &out);
+#endif
+        samples = out;
+        frames = n;
+    }
+
+    if (frames == 0)
+        return ESP_OK;
+    *outFrames += frames;
+    return g->sink(g->sinkCtx, samples, frames);
+}
+
+esp_err_t audio_graph_process(audio_graph_t *g, int32_t *samples, uint32_t frames)
+{
+    if (g->dirty)
+        rebuild(g);
+
+    uint32_t cycles = 0, outFrames = 0;
+    esp_err_t err = runFrom(g, 0, samples, frames, &cycles, &outFrames);
+
+#if AUDIO_GRAPH_PROFILE
+    // 没有输出的块 (变速攒输入时) 的处理时间算到下一个有输出的块上
+    // the processing time of a block with no output (time-stretch gathering input) is charged to
+    // the next block that has some
+    g->carryCycles += cycles;
+    if (outFrames)
+    {
+        uint32_t budget = audio_graph_budgetCycles(outFrames, g->outRate, g->budgetPercent);
+        uint32_t load = (uint32_t)((uint64_t)g->carryCycles * 1000 / (budget ? budget : 1));
+        g->carryCycles = 0;
+        g->blocks++;
+        if (load > g->maxLoad)
+            g->maxLoad = (load > UINT16_MAX) ? UINT16_MAX : load;
+        if (load > 1000)
+        {
+            g->deadlineMisses++;
+            if (g->lateRun < UINT16_MAX)
+                g->lateRun++;
+        }
+        else
+        {
+            g->lateRun = 0;
+        }
+    }
+#endif
+    return err;
+}
+
+uint32_t audio_graph_budgetCycles(uint32_t frames, uint32_t rate, uint8_t percent)
+{
+    return (uint32_t)(GRAPH_CPU_HZ * frames / rate * percent / 100);
+}
+
+void audio_graph_log(const audio_graph_t *g, const char *tag)
+{
+    for (uint8_t i = 0; i < g->count; i++)
+    {
+        const audio_stage_t *s = &g->stage[i];
+        uint32_t calls = s->calls;
+        uint32_t avg = calls ? (uint32_t)(s->cycles / calls) : 0;
+        ESP_LOGI(tag, "%-10s %-6s %8lu calls, avg %7lu, max %7lu cycles",
+                 s->name, s->bypass ? "bypass" : "on", (unsigned long)calls, (unsigned long)avg, (unsigned long)s->maxCycles);
+    }
+    ESP_LOGI(tag, "%lu blocks, %lu over deadline, peak load %u.%u%% of %u%%, latency %lu us",
+             (unsigned long)g->blocks, (unsigned long)g->deadlineMisses, g->maxLoad / 10, g->maxLoad % 10,
+             g->budgetPercent, (unsigned long)audio_graph_latencyUs(g));
+}
+
+void audio_graph_resetStats(audio_graph_t *g)
+{
+    for (uint8_t i = 0; i < g->count; i++)
+    {
+        g->stage[i].calls = 0;
+        g->stage[i].cycles = 0;
+        g->stage[i].maxCycles = 0;
+    }
+    g->blocks = 0;
+    g->deadlineMisses = 0;
+    g->maxLoad = 0;
+}
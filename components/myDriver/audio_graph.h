@@ -0,0 +1,111 @@
+#ifndef __AUDIO_GRAPH_H_
+#define __AUDIO_GRAPH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// 音频处理图: 一串按顺序执行的环节, 每块数据从头走到尾, 最后交给输出. 旁路的环节不在执行列表里,
+// 连判断都不用做; 每个环节分别计周期数, 整块的处理时间和这块音频的时长比较, 超过预算算一次误时
+// audio processing graph: a chain of stages run in order, each block goes from the first to the
+// last and then to the sink. Bypassed stages are not in the run list, so they cost not even a
+// test; cycles are counted per stage and the processing time of a block is checked against the
+// duration of the audio it produced, counting a deadline miss when it goes over budget
+
+#define AUDIO_GRAPH_MAX_STAGES 12
+
+// 为 0 时去掉所有计时, 执行列表之外没有额外开销
+// with 0 all timing is compiled out and nothing is left beyond walking the run list
+#ifndef AUDIO_GRAPH_PROFILE
+#define AUDIO_GRAPH_PROFILE 1
+#endif
+
+// 环节处理 frames 帧立体声交错的内部格式. 原地处理的环节直接返回 frames; 改变帧数的环节把结果写进
+// 自己的缓冲区, 通过 *out 返回, 输出帧数可以是任意个. 一次能收的帧数有上限的环节, 图会把送给它的数据
+// 切成几段, 每段一直走到输出再送下一段
+// a stage processes frames of interleaved stereo in the internal format. In-place stages just
+// return frames; stages that change the frame count write into their own buffer and return it
+// through *out, with any number of frames. For a stage with a limit on what it takes at once,
+// the graph cuts its input into pieces and runs each all the way to the sink before the next
+typedef uint32_t (*audio_stage_fn_t)(void *ctx, int32_t *samples, uint32_t frames, int32_t **out);
+// 输出, 收到的是最后一个环节的结果; 它的等待时间不计入处理时间
+// the sink gets the output of the last stage; its waiting is not counted as processing time
+typedef esp_err_t (*audio_sink_fn_t)(void *ctx, int32_t *samples, uint32_t frames);
+
+typedef struct
+{
+    const char *name;
+    audio_stage_fn_t process;
+    void *ctx;
+    uint32_t latencyUs; // 引入的延迟 latency it adds
+    bool bypass;
+    // 被动环节 (电平表, 抖动) 跟着图一起运行, 但单靠它们不值得离开直通
+    // passive stages (meter, dither) run whenever the graph does, but alone they are not worth
+    // leaving the pass-through for
+    bool passive;
+    uint32_t maxFrames; // 一次最多收的帧数, 0 不限 most frames taken at once, 0 for any
+
+    uint32_t calls;
+    uint32_t maxCycles; // 单次调用 per call
+    uint64_t cycles;
+} audio_stage_t;
+
+typedef struct
+{
+    audio_stage_t stage[AUDIO_GRAPH_MAX_STAGES];
+    uint8_t count;
+    uint8_t run[AUDIO_GRAPH_MAX_STAGES];
+    uint8_t runCount;
+    uint8_t activeCount; // 执行列表里不是被动的环节数 non-passive stages in the run list
+    bool dirty;
+
+    uint32_t outRate;      // 输出的采样率, 用来算时限 output sample rate, for the deadline
+    uint8_t budgetPercent; // 处理可用的时长占比 share of the audio's duration processing may use
+    audio_sink_fn_t sink;
+    void *sinkCtx;
+
+    uint32_t carryCycles;  // 还没有输出的处理时间 processing time not yet matched by output
+    uint32_t blocks;
+    uint32_t deadlineMisses;
+    uint16_t lateRun;      // 连续误时的块数 consecutive blocks over budget
+    uint16_t maxLoad;      // 占时限的最大千分比 largest share of the deadline, per mille
+} audio_graph_t;
+
+void audio_graph_init(audio_graph_t *g, uint32_t outRate, uint8_t budgetPercent, audio_sink_fn_t sink, void *sinkCtx);
+// 按执行顺序添加, 返回序号, 满了返回 -1; 新加的环节处于旁路
+// stages are added in execution order; returns the index, or -1 when full. A new stage starts bypassed
+int audio_graph_add(audio_graph_t *g, const char *name, audio_stage_fn_t process, void *ctx, bool passive, uint32_t maxFrames);
+void audio_graph_setOutputRate(audio_graph_t *g, uint32_t outRate);
+void audio_graph_setLatency(audio_graph_t *g, int index, uint32_t latencyUs);
+
+// 只在状态变化时重建执行列表, 可以每块都调用
+// the run list is only rebuilt when the state changes, so this can be called every block
+static inline void audio_graph_setBypass(audio_graph_t *g, int index, bool bypass)
+{
+    if (g->stage[index].bypass != bypass)
+    {
+        g->stage[index].bypass = bypass;
+        g->dirty = true;
+    }
+}
+
+// 有不是被动的环节没旁路
+// some non-passive stage is not bypassed
+bool audio_graph_isActive(audio_graph_t *g);
+// 没旁路的环节延迟之和
+// total latency of the stages not bypassed
+uint32_t audio_graph_latencyUs(const audio_graph_t *g);
+// 运行一块, 返回输出的错误
+// runs one block and returns the sink's error
+esp_err_t audio_graph_process(audio_graph_t *g, int32_t *samples, uint32_t frames);
+
+// frames 帧音频在 rate 下的时长里 percent% 的 CPU 周期数
+// CPU cycles in percent% of the duration of frames at rate
+uint32_t audio_graph_budgetCycles(uint32_t frames, uint32_t rate, uint8_t percent);
+
+// 统计可以在别的线程读, 最多差一块
+// the statistics may be read from another thread, at most one block stale
+void audio_graph_log(const audio_graph_t *g, const char *tag);
+void audio_graph_resetStats(audio_graph_t *g);
+
+#endif
@@ -0,0 +1,237 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_format.h"
+#include "audio_loudness.h"
+
+#define BIN_LUFS_MIN -70.0f
+#define BIN_LU 0.1f
+
+// BS.1770-4 附录 2 的 4 相 48 阶插值滤波器, Q13
+// the 4-phase 48-tap interpolation filter from BS.1770-4 Annex 2, Q13
+static const int16_t tpCoef[4][AUDIO_LOUDNESS_TP_TAPS] = {
+    {14, 90, -161, 272, -487, 1125, 7964, -838, 390, -218, 122, -68},
+    {-239, 240, -424, 730, -1364, 3810, 6388, -1641, 832, -477, 271, -155},
+    {-155, 271, -477, 832, -1641, 6388, 3810, -1364, 730, -424, 240, -239},
+    {-68, 122, -218, 390, -838, 7964, 1125, -487, 272, -161, 90, 14},
+};
+// 各相系数绝对值之和的最大值 (第 1, 2 相, 约 2.02 倍), 插值结果不会超过 12 个输入里最大的乘它
+// the largest sum of absolute coefficients over the phases (phases 1 and 2, about 2.02x); no
+// interpolated value exceeds the largest of the 12 inputs times this
+#define TP_COEF_ABS_SUM 16571
+
+// K 加权系数按采样率算 (与 libebur128 相同的模拟原型)
+// K-weighting coefficients for the sample rate (same analog prototypes as libebur128)
+static void designKWeighting(audio_loudness_t *l, double fs)
+{
+    audio_biquad_coef_t coef;
+
+    double f0 = 1681.974450955533;
+    double G = 3.999843853973347;
+    double Q = 0.7071752369554196;
+    double K = tan(M_PI * f0 / fs);
+    double Vh = pow(10.0, G / 20.0);
+    double Vb = pow(Vh, 0.4996667741545416);
+    audio_biquad_makeCoef(&coef,
+                          Vh + Vb * K / Q + K * K, 2.0 * (K * K - Vh), Vh - Vb * K / Q + K * K,
+                          1.0 + K / Q + K * K, 2.0 * (K * K - 1.0), 1.0 - K / Q + K * K);
+    audio_biquad_init(&l->shelf, &coef);
+
+    f0 = 38.13547087602444;
+    Q = 0.5003270373238773;
+    K = tan(M_PI * f0 / fs);
+    audio_biquad_makeCoef(&coef,
+                          1.0, -2.0, 1.0,
+                          1.0 + K / Q + K * K, 2.0 * (K * K - 1.0), 1.0 - K / Q + K * K);
+    // 高通的 b 系数没按 a0 归一化, 补回来
+    // the high-pass b coefficients are not normalised by a0 in the prototype, undo that
+    coef.b0 = (int32_t)(1 << AUDIO_BIQUAD_COEF_SHIFT);
+    coef.b1 = -(int32_t)(2 << AUDIO_BIQUAD_COEF_SHIFT);
+    coef.b2 = (int32_t)(1 << AUDIO_BIQUAD_COEF_SHIFT);
+    audio_biquad_init(&l->highpass, &coef);
+}
+
+void audio_loudness_init(audio_loudness_t *l, uint32_t sampleRate)
+{
+    memset(l, 0, sizeof(*l));
+    designKWeighting(l, sampleRate);
+    l->blockFrames = sampleRate / 10;
+}
+
+// 400ms 块 = 最近 4 个 100ms 子块, 75% 重叠
+// a 400ms block is the last four 100ms sub-blocks, 75% overlap
+static void finishSubBlock(audio_loudness_t *l)
+{
+    l->subCount++;
+    if (l->subCount >= 4)
+    {
+        uint64_t energy = l->subEnergy[0] + l->subEnergy[1] + l->subEnergy[2] + l->subEnergy[3];
+        // 平方和用的是右移 8 位后的采样, 满幅 1<<21
+        // the squares are of samples shifted right by 8, so full scale is 1<<21
+        double z = (double)energy / (4.0 * l->blockFrames) / (double)(1ULL << 42);
+        if (z > 0.0)
+        {
+            float lufs = -0.691f + 10.0f * log10f((float)z);
+            if (lufs > BIN_LUFS_MIN)
+            {
+                int bin = (int)((lufs - BIN_LUFS_MIN) / BIN_LU);
+                if (bin >= AUDIO_LOUDNESS_BINS)
+                    bin = AUDIO_LOUDNESS_BINS - 1;
+                l->hist[bin]++;
+            }
+        }
+    }
+
+    l->subEnergy[3] = l->subEnergy[2];
+    l->subEnergy[2] = l->subEnergy[1];
+    l->subEnergy[1] = l->subEnergy[0];
+    l->subEnergy[0] = 0;
+    l->subFrames = 0;
+}
+
+// 真峰值: 12 个输入里最大的乘系数绝对值之和都到不了当前峰值时这一段不插值, 这个上限不会漏掉真峰值;
+// 大部分采样只做 12 次比较, 不做 48 次乘加
+// true peak: a span is not interpolated when the largest of its 12 inputs times the sum of
+// absolute coefficients cannot reach the running peak; that bound never misses a true peak, and
+// most samples cost 12 compares instead of 48 multiply-adds
+static void truePeak(audio_loudness_t *l, const int16_t *samples, uint32_t frames)
+{
+    int32_t peak = l->peak;
+    uint32_t pos = l->tpPos;
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        for (int ch = 0; ch < 2; ch++)
+        {
+            int16_t *h = l->tpHist[ch];
+            int16_t x = samples[i * 2 + ch];
+            h[pos] = x;
+            h[pos + AUDIO_LOUDNESS_TP_TAPS] = x;
+
+            int32_t ax = (x < 0) ? -x : x;
+            if (ax > peak)
+                peak = ax;
+
+            const int16_t *w = h + pos + 1;
+            int32_t m = 0;
+            for (int k = 0; k < AUDIO_LOUDNESS_TP_TAPS; k++)
+            {
+                int32_t a = (w[k] < 0) ? -w[k] : w[k];
+                if (a > m)
+                    m = a;
+            }
+            // 右移取整最多让结果的绝对值进一, 所以这里用 <= 也不会漏
+            // the shift's rounding adds at most one to the magnitude, so <= still misses nothing
+            if (m * TP_COEF_ABS_SUM <= peak << 13)
+                continue;
+
+            for (int p = 0; p < 4; p++)
+            {
+                const int16_t *c = tpCoef[p];
+                int32_t acc = w[0] * c[0] + w[1] * c[1] + w[2] * c[2] + w[3] * c[3] +
+                              w[4] * c[4] + w[5] * c[5] + w[6] * c[6] + w[7] * c[7] +
+                              w[8] * c[8] + w[9] * c[9] + w[10] * c[10] + w[11] * c[11];
+                int32_t v = acc >> 13;
+                if (v < 0)
+                    v = -v;
+                if (v > peak)
+                    peak = v;
+            }
+        }
+        pos = (pos + 1 == AUDIO_LOUDNESS_TP_TAPS) ? 0 : pos + 1;
+    }
+
+    l->peak = peak;
+    l->tpPos = pos;
+}
+
+// K 加权后的平方和, 四个采样一组
+// sum of squares after K-weighting, four samples at a time
+static uint64_t sumSquares(const int32_t *y, uint32_t count)
+{
+    uint64_t s0 = 0, s1 = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        int32_t a = y[i] >> 8, b = y[i + 1] >> 8, c = y[i + 2] >> 8, d = y[i + 3] >> 8;
+        s0 += (int64_t)a * a + (int64_t)b * b;
+        s1 += (int64_t)c * c + (int64_t)d * d;
+    }
+    for (; i < count; i++)
+    {
+        int32_t a = y[i] >> 8;
+        s0 += (int64_t)a * a;
+    }
+    return s0 + s1;
+}
+
+void audio_loudness_process(audio_loudness_t *l, const int16_t *samples, uint32_t frames)
+{
+    truePeak(l, samples, frames);
+
+    while (frames > 0)
+    {
+        uint32_t n = l->blockFrames - l->subFrames;
+        if (n > AUDIO_LOUDNESS_CHUNK)
+            n = AUDIO_LOUDNESS_CHUNK;
+        if (n > frames)
+            n = frames;
+
+        audio_format_s16ToS32(samples, l->work, n * 2);
+        audio_biquad_processStereo(&l->shelf, l->work, n);
+        audio_biquad_processStereo(&l->highpass, l->work, n);
+        l->subEnergy[0] += sumSquares(l->work, n * 2);
+        l->subFrames += n;
+        if (l->subFrames == l->blockFrames)
+            finishSubBlock(l);
+
+        samples += n * 2;
+        frames -= n;
+    }
+}
+
+// 先按 -70 LUFS 绝对门限求平均, 再用平均值 -10 LU 的相对门限求一次
+// average above the -70 LUFS absolute gate, then again above the relative gate 10 LU below that
+bool audio_loudness_integrated(const audio_loudness_t *l, float *lufs)
+{
+    double sum = 0.0;
+    uint32_t count = 0;
+    for (int i = 0; i < AUDIO_LOUDNESS_BINS; i++)
+    {
+        if (l->hist[i] == 0)
+            continue;
+        sum += l->hist[i] * pow(10.0, (BIN_LUFS_MIN + (i + 0.5) * BIN_LU + 0.691) / 10.0);
+        count += l->hist[i];
+    }
+    if (count == 0)
+        return false;
+
+    double relGate = -0.691 + 10.0 * log10(sum / count) - 10.0;
+    int first = (int)ceil((relGate - BIN_LUFS_MIN) / BIN_LU - 0.5);
+    if (first < 0)
+        first = 0;
+
+    sum = 0.0;
+    count = 0;
+    for (int i = first; i < AUDIO_LOUDNESS_BINS; i++)
+    {
+        if (l->hist[i] == 0)
+            continue;
+        sum += l->hist[i] * pow(10.0, (BIN_LUFS_MIN + (i + 0.5) * BIN_LU + 0.691) / 10.0);
+        count += l->hist[i];
+    }
+    if (count == 0)
+        return false;
+
+    *lufs = (float)(-0.691 + 10.0 * log10(sum / count));
+    return true;
+}
+
+float audio_loudness_truePeakDb(const audio_loudness_t *l)
+{
+    if (l->peak == 0)
+        return -INFINITY;
+    return 20.0f * log10f((float)l->peak / 32768.0f);
+}
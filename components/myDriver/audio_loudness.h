@@ -0,0 +1,45 @@
+#ifndef __AUDIO_LOUDNESS_H_
+#define __AUDIO_LOUDNESS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "audio_biquad.h"
+
+// ITU-R BS.1770 / EBU R128 积分响度和真峰值, 16 位立体声输入
+// ITU-R BS.1770 / EBU R128 integrated loudness and true peak, 16-bit stereo input
+
+// 响度直方图 -70 ~ +5 LUFS, 0.1 LU 一格, 门限计算用格子中心代替每个块
+// loudness histogram from -70 to +5 LUFS in 0.1 LU bins; gating uses the bin centre in place of
+// each block
+#define AUDIO_LOUDNESS_BINS 750
+// 每次 K 加权处理的帧数
+// frames K-weighted per pass
+#define AUDIO_LOUDNESS_CHUNK 588
+// 真峰值 4 倍过采样, 每相 12 阶
+// true peak: 4x oversampling, 12 taps per phase
+#define AUDIO_LOUDNESS_TP_TAPS 12
+
+typedef struct
+{
+    audio_biquad_t shelf;    // K 加权第一级, 高搁架 K-weighting stage 1, high shelf
+    audio_biquad_t highpass; // K 加权第二级, RLB 高通 K-weighting stage 2, RLB high-pass
+    uint32_t blockFrames;    // 一个 100ms 子块的帧数 frames in a 100ms sub-block
+    uint32_t subFrames;      // 当前子块已累计的帧数 frames accumulated in the current sub-block
+    uint64_t subEnergy[4];   // 最近 4 个子块的平方和, [0] 是当前的 sums of squares of the last 4 sub-blocks, [0] is current
+    uint32_t subCount;       // 已完成的子块数 completed sub-blocks
+    uint32_t hist[AUDIO_LOUDNESS_BINS];
+    int32_t peak;            // 真峰值, 16 位采样单位 true peak in 16-bit sample units
+    int16_t tpHist[2][AUDIO_LOUDNESS_TP_TAPS * 2]; // 真峰值历史, 写两份省掉取模 true-peak history, written twice to avoid a modulo
+    uint32_t tpPos;
+    int32_t work[AUDIO_LOUDNESS_CHUNK * 2];
+} audio_loudness_t;
+
+void audio_loudness_init(audio_loudness_t *l, uint32_t sampleRate);
+void audio_loudness_process(audio_loudness_t *l, const int16_t *samples, uint32_t frames);
+// 没有一个块超过 -70 LUFS 时返回 false
+// returns false when no block is above -70 LUFS
+bool audio_loudness_integrated(const audio_loudness_t *l, float *lufs);
+float audio_loudness_truePeakDb(const audio_loudness_t *l);
+
+#endif
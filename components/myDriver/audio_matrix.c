@@ -0,0 +1,135 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_matrix.h"
+
+static inline int32_t sat32(int64_t x)
+{
+    if (x > INT32_MAX)
+        return INT32_MAX;
+    if (x < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)x;
+}
+
+// 两路乘积在 64 位里相加后才舍入, 单位矩阵的结果与输入逐位一致
+// the two products are summed in 64 bits before rounding, so the identity gives the input bit for bit
+static inline int32_t mix(int32_t x, int32_t cx, int32_t y, int32_t cy)
+{
+    return sat32(((int64_t)x * cx + (int64_t)y * cy + (1 << 29)) >> 30);
+}
+
+// 依次是互换, M/S 宽度 (左 = a L + b R, 右 = b L + a R), 平衡, 反相; 宽度矩阵对称, 互换只是把它的两列对调
+// in turn: swap, M/S width (left = a L + b R, right = b L + a R), balance, polarity; the width
+// matrix is symmetric, so a swap just exchanges its columns
+static void design(const audio_matrix_config_t *cfg, int32_t coef[4])
+{
+    int width = cfg->mono ? 0 : cfg->width;
+    if (width > AUDIO_MATRIX_WIDTH_MAX)
+        width = AUDIO_MATRIX_WIDTH_MAX;
+    int balance = cfg->balance;
+    if (balance > AUDIO_MATRIX_BALANCE_MAX)
+        balance = AUDIO_MATRIX_BALANCE_MAX;
+    if (balance < -AUDIO_MATRIX_BALANCE_MAX)
+        balance = -AUDIO_MATRIX_BALANCE_MAX;
+
+    double w = (double)width / AUDIO_MATRIX_WIDTH_UNITY;
+    double a = (1.0 + w) / 2, b = (1.0 - w) / 2;
+    double gl = (balance > 0) ? 1.0 - (double)balance / AUDIO_MATRIX_BALANCE_MAX : 1.0;
+    double gr = (balance < 0) ? 1.0 + (double)balance / AUDIO_MATRIX_BALANCE_MAX : 1.0;
+    if (cfg->invert & 1)
+        gl = -gl;
+    if (cfg->invert & 2)
+        gr = -gr;
+
+    double m[4] = {gl * a, gl * b, gr * b, gr * a};
+    if (cfg->swap)
+    {
+        m[0] = gl * b;
+        m[1] = gl * a;
+        m[2] = gr * a;
+        m[3] = gr * b;
+    }
+    for (int i = 0; i < 4; i++)
+        coef[i] = (int32_t)lrint(m[i] * AUDIO_MATRIX_UNITY_Q30);
+}
+
+void audio_matrix_init(audio_matrix_t *m, const audio_matrix_config_t *cfg, uint32_t rampFrames)
+{
+    memset(m, 0, sizeof(audio_matrix_t));
+    m->rampFrames = rampFrames;
+    design(cfg, m->target);
+    memcpy(m->coef, m->target, sizeof(m->coef));
+}
+
+// 从当前系数 (可能还在上一次过渡中) 重新开始过渡
+// restart the slide from the current coefficients, possibly in the middle of the previous one
+void audio_matrix_setConfig(audio_matrix_t *m, const audio_matrix_config_t *cfg)
+{
+    design(cfg, m->target);
+    if (m->rampFrames == 0)
+    {
+        memcpy(m->coef, m->target, sizeof(m->coef));
+        m->remain = 0;
+        return;
+    }
+    // 系数范围 ±1.5, 最宽时翻转极性两端相差 3.0, 差值要在 64 位里算; 只过渡一帧时步长也要夹在 int32 里,
+    // 这一帧差一点没关系, 过渡结束时直接换成目标值
+    // coefficients span ±1.5, so flipping polarity at full width puts the ends 3.0 apart and the
+    // difference has to be taken in 64 bits; with a one-frame slide the step is clamped to int32
+    // as well, which only bends that one frame, since the slide ends on the target itself
+    for (int i = 0; i < 4; i++)
+        m->step[i] = sat32(((int64_t)m->target[i] - m->coef[i]) / m->rampFrames);
+    m->remain = m->rampFrames;
+}
+
+bool audio_matrix_isIdentity(const audio_matrix_t *m)
+{
+    return m->remain == 0 &&
+           m->coef[0] == AUDIO_MATRIX_UNITY_Q30 && m->coef[1] == 0 &&
+           m->coef[2] == 0 && m->coef[3] == AUDIO_MATRIX_UNITY_Q30;
+}
+
+// 过渡段每帧多四次加法; 恒定段每次处理两帧, 四个乘加之间没有依赖, 可以把流水线排满
+// the slide costs four adds per frame; the constant part takes two frames per iteration, whose
+// four multiply-adds are independent and keep the pipeline full
+void audio_matrix_process(audio_matrix_t *m, int32_t *samples, uint32_t frames)
+{
+    uint32_t n = (m->remain < frames) ? m->remain : frames;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        m->coef[0] += m->step[0];
+        m->coef[1] += m->step[1];
+        m->coef[2] += m->step[2];
+        m->coef[3] += m->step[3];
+        int32_t l = samples[0], r = samples[1];
+        samples[0] = mix(l, m->coef[0], r, m->coef[1]);
+        samples[1] = mix(l, m->coef[2], r, m->coef[3]);
+        samples += 2;
+    }
+    frames -= n;
+    m->remain -= n;
+    if (n && m->remain == 0)
+        memcpy(m->coef, m->target, sizeof(m->coef)); // 消除整除误差 drop the division residue
+
+    const int32_t ll = m->coef[0], lr = m->coef[1], rl = m->coef[2], rr = m->coef[3];
+    uint32_t pairs = frames / 2;
+    while (pairs--)
+    {
+        int32_t l0 = samples[0], r0 = samples[1];
+        int32_t l1 = samples[2], r1 = samples[3];
+        samples[0] = mix(l0, ll, r0, lr);
+        samples[1] = mix(l0, rl, r0, rr);
+        samples[2] = mix(l1, ll, r1, lr);
+        samples[3] = mix(l1, rl, r1, rr);
+        samples += 4;
+    }
+    if (frames & 1)
+    {
+        int32_t l = samples[0], r = samples[1];
+        samples[0] = mix(l, ll, r, lr);
+        samples[1] = mix(l, rl, r, rr);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef __AUDIO_MATRIX_H_
+#define __AUDIO_MATRIX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 声道矩阵: 平衡, 单声道合并, 左右互换, 反相和 M/S 立体声宽度合成一个 2x2 定点矩阵, 每帧四次乘法,
+// 打开哪几项开销都一样; 设置改变时系数在 rampFrames 帧内线性过渡
+// channel matrix: balance, mono fold-down, channel swap, polarity inversion and M/S stereo width
+// fold into one 2x2 fixed-point matrix, four multiplies per frame whatever combination is on;
+// when the settings change, the coefficients slide linearly over rampFrames frames
+
+#define AUDIO_MATRIX_BALANCE_MAX 100
+#define AUDIO_MATRIX_WIDTH_UNITY 100
+#define AUDIO_MATRIX_WIDTH_MAX 200
+#define AUDIO_MATRIX_UNITY_Q30 (1 << 30)
+
+// 存进 NVS 的格式, 改动需保持兼容
+// this is the layout stored in NVS, keep it compatible
+typedef struct
+{
+    int8_t balance;  // -100 只剩左 ~ 100 只剩右, 只衰减另一侧 -100 left only ~ 100 right only, only the other side is attenuated
+    uint8_t width;   // 立体声宽度 %, 0 单声道, 100 不变, 最大 200 stereo width in %, 0 mono, 100 unchanged, 200 at most
+    uint8_t mono;    // 单声道合并, 优先于宽度 mono fold-down, overrides width
+    uint8_t swap;    // 左右互换 swap left and right
+    uint8_t invert;  // 反相, bit0 左 bit1 右 polarity inversion, bit0 left, bit1 right
+    uint8_t reserved[3];
+} audio_matrix_config_t;
+
+typedef struct
+{
+    // LL LR RL RR: 左出 = LL * 左入 + LR * 右入, 右出 = RL * 左入 + RR * 右入, Q30
+    // LL LR RL RR: left out = LL * left in + LR * right in, right out = RL * left in + RR * right in, Q30
+    int32_t coef[4];
+    int32_t target[4];
+    int32_t step[4];
+    uint32_t remain;
+    uint32_t rampFrames;
+} audio_matrix_t;
+
+void audio_matrix_init(audio_matrix_t *m, const audio_matrix_config_t *cfg, uint32_t rampFrames);
+void audio_matrix_setConfig(audio_matrix_t *m, const audio_matrix_config_t *cfg);
+// 单位矩阵且不在过渡中, 这时可以跳过整个环节
+// identity and not sliding, so the whole stage can be skipped
+bool audio_matrix_isIdentity(const audio_matrix_t *m);
+// 立体声交错, 内部 32 位格式, 原地处理
+// interleaved stereo in the internal 32-bit format, in place
+void audio_matrix_process(audio_matrix_t *m, int32_t *samples, uint32_t frames);
+
+#endif
@@ -0,0 +1,110 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_meter.h"
+
+// 以下只在音频线程使用, 线性值, 满幅 = 1
+// audio thread only below, linear with full scale = 1
+static float meter_peak[2];
+static float meter_meanSquare[2];
+static uint8_t meter_clipRun[2];
+static uint32_t meter_clips[2];
+
+// 快照用序号锁发布, 奇数表示正在写
+// the snapshot is published with a sequence lock, odd while being written
+static audio_meter_snapshot_t meter_snapshot = {
+    {AUDIO_METER_FLOOR_DB, AUDIO_METER_FLOOR_DB},
+    {AUDIO_METER_FLOOR_DB, AUDIO_METER_FLOOR_DB},
+    {0, 0},
+};
+static uint32_t meter_seq = 0;
+
+static float toDb(float x)
+{
+    float db = (x > 0.0f) ? 10.0f * log10f(x) : AUDIO_METER_FLOOR_DB;
+    return (db < AUDIO_METER_FLOOR_DB) ? AUDIO_METER_FLOOR_DB : db;
+}
+
+// 采样循环里只有取绝对值, 比较和一次乘加; 对数和指数每块各算一次
+// the sample loop only does an abs, compares and one multiply-add; logs and exponentials run once
+// per block
+void audio_meter_process(const int32_t *samples, uint32_t frames, uint32_t sampleRate, uint8_t headroomBits)
+{
+    if (frames == 0)
+        return;
+
+    // 平方和按 16 位精度累加, 64 位不会溢出
+    // squares are summed at 16-bit precision, so 64 bits cannot overflow
+    const int shift = 16 - headroomBits;
+    const uint32_t fullScale = 1u << (31 - headroomBits);
+    const uint32_t clipLevel = fullScale - (1u << shift);
+
+    for (int ch = 0; ch < 2; ch++)
+    {
+        const int32_t *p = samples + ch;
+        uint32_t peak = 0;
+        uint64_t sum = 0;
+        uint8_t run = meter_clipRun[ch];
+        uint32_t clips = meter_clips[ch];
+
+        for (uint32_t i = 0; i < frames; i++, p += 2)
+        {
+            int32_t x = *p;
+            uint32_t a = (x < 0) ? -(uint32_t)x : (uint32_t)x;
+            if (a > peak)
+                peak = a;
+            int32_t s = x >> shift;
+            sum += (int64_t)s * s;
+
+            // 一段连续满幅只算一次
+            // one continuous full-scale stretch counts once
+            if (a >= clipLevel)
+            {
+                if (run < AUDIO_METER_CLIP_SAMPLES && ++run == AUDIO_METER_CLIP_SAMPLES)
+                    clips++;
+            }
+            else
+            {
+                run = 0;
+            }
+        }
+        meter_clipRun[ch] = run;
+        meter_clips[ch] = clips;
+
+        // 块时长内的特性
+        // ballistics over the block's duration
+        float dt = (float)frames / (float)sampleRate;
+        float blockPeak = (float)peak / (float)fullScale;
+        float fall = powf(10.0f, -AUDIO_METER_PEAK_FALL_DB * dt / 20.0f);
+        meter_peak[ch] = (blockPeak > meter_peak[ch] * fall) ? blockPeak : meter_peak[ch] * fall;
+
+        float blockMs = (float)sum / (float)frames / (32768.0f * 32768.0f);
+        float tau = (blockMs > meter_meanSquare[ch] ? AUDIO_METER_RMS_ATTACK_MS : AUDIO_METER_RMS_RELEASE_MS) / 1000.0f;
+        meter_meanSquare[ch] += (blockMs - meter_meanSquare[ch]) * (1.0f - expf(-dt / tau));
+    }
+
+    uint32_t seq = meter_seq;
+    __atomic_store_n(&meter_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (int ch = 0; ch < 2; ch++)
+    {
+        meter_snapshot.peak[ch] = toDb(meter_peak[ch] * meter_peak[ch]);
+        meter_snapshot.rms[ch] = toDb(meter_meanSquare[ch] * 2.0f);
+        meter_snapshot.clips[ch] = meter_clips[ch];
+    }
+    __atomic_store_n(&meter_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+bool audio_meter_read(audio_meter_snapshot_t *snapshot)
+{
+    uint32_t s0 = __atomic_load_n(&meter_seq, __ATOMIC_ACQUIRE);
+    if (s0 & 1)
+        return false;
+
+    memcpy(snapshot, &meter_snapshot, sizeof(*snapshot));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&meter_seq, __ATOMIC_RELAXED) == s0;
+}
@@ -0,0 +1,39 @@
+#ifndef __AUDIO_METER_H_
+#define __AUDIO_METER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 电平表: 在送往 DAC 的最终采样上算每声道真峰值和 RMS, 带启动/释放特性和削波检测, 按块发布快照
+// level meter: true per-channel peak and RMS of the final samples going to the DAC, with attack /
+// release ballistics and clip detection, published as a snapshot once per block
+
+// 峰值: 立即上升, 每秒下落 AUDIO_METER_PEAK_FALL_DB (IEC 60268-18, 1.7s 落 20dB)
+// peak: instant rise, falls AUDIO_METER_PEAK_FALL_DB per second (IEC 60268-18, 20dB in 1.7s)
+#define AUDIO_METER_PEAK_FALL_DB 11.8f
+// RMS: 上升/下降时间常数
+// RMS: rise/fall time constants
+#define AUDIO_METER_RMS_ATTACK_MS 50
+#define AUDIO_METER_RMS_RELEASE_MS 300
+// 连续这么多个满幅采样算一次削波
+// this many consecutive full-scale samples count as one clip
+#define AUDIO_METER_CLIP_SAMPLES 3
+#define AUDIO_METER_FLOOR_DB (-90.0f)
+
+typedef struct
+{
+    float peak[2]; // dBFS
+    float rms[2];  // dBFS, 满幅正弦读 0 (AES17) full-scale sine reads 0 (AES17)
+    uint32_t clips[2]; // 累计削波次数, 界面比较前后两次看是否有新的削波 running clip count; the GUI compares readings to spot new clips
+} audio_meter_snapshot_t;
+
+// 音频线程, 每块调用一次; headroomBits 是满幅之上留的位数 (内部格式 2, I2S 字 0)
+// audio thread, once per block; headroomBits is the headroom above full scale (2 for the internal
+// format, 0 for I2S words)
+void audio_meter_process(const int32_t *samples, uint32_t frames, uint32_t sampleRate, uint8_t headroomBits);
+
+// 界面线程, 不等待; 快照正在更新时返回 false, 下一帧再读
+// GUI thread, never waits; returns false while the snapshot is being updated, read again next frame
+bool audio_meter_read(audio_meter_snapshot_t *snapshot);
+
+#endif
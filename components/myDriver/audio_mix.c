@@ -0,0 +1,92 @@
+#include <stdint.h>
+#include <math.h>
+
+#include "audio_mix.h"
+
+// 增益每 64 帧用 sinf 算一次, 中间线性插值, 每帧只有两次乘加
+// gains come from sinf every 64 frames and are interpolated linearly in between, leaving two
+// multiply-adds per frame
+#define MIX_SEGMENT_FRAMES 64
+#define MIX_GAIN_SHIFT 8
+
+// sin(pi/2 * x/len), Q15
+static int32_t fadeGain(uint32_t x, uint32_t len)
+{
+    if (x >= len)
+        return 32768;
+    return (int32_t)(sinf((float)M_PI_2 * (float)x / (float)len) * 32768.0f + 0.5f);
+}
+
+static inline int16_t sat16(int32_t x)
+{
+    if (x > INT16_MAX)
+        return INT16_MAX;
+    if (x < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)x;
+}
+
+void audio_mix_crossfadeS16(int16_t *in, const int16_t *out, uint32_t frames, uint32_t pos, uint32_t len)
+{
+    for (uint32_t i = 0; i < frames; i += MIX_SEGMENT_FRAMES)
+    {
+        uint32_t n = (frames - i < MIX_SEGMENT_FRAMES) ? frames - i : MIX_SEGMENT_FRAMES;
+        uint32_t p0 = pos + i;
+        uint32_t p1 = p0 + n;
+
+        int32_t gIn = fadeGain(p0, len) << MIX_GAIN_SHIFT;
+        int32_t gOut = fadeGain((p0 < len) ? len - p0 : 0, len) << MIX_GAIN_SHIFT;
+        const int32_t stepIn = ((fadeGain(p1, len) << MIX_GAIN_SHIFT) - gIn) / (int32_t)n;
+        const int32_t stepOut = ((fadeGain((p1 < len) ? len - p1 : 0, len) << MIX_GAIN_SHIFT) - gOut) / (int32_t)n;
+
+        int16_t *a = in + i * 2;
+        const int16_t *b = out + i * 2;
+        for (uint32_t k = 0; k < n; k++)
+        {
+            int32_t gi = gIn >> MIX_GAIN_SHIFT;
+            int32_t go = gOut >> MIX_GAIN_SHIFT;
+            a[0] = sat16((a[0] * gi + b[0] * go + (1 << 14)) >> 15);
+            a[1] = sat16((a[1] * gi + b[1] * go + (1 << 14)) >> 15);
+            a += 2;
+            b += 2;
+            gIn += stepIn;
+            gOut += stepOut;
+        }
+    }
+}
+
+// 按 fadeGain(x, len) 给 frames 帧加增益, x 从 pos 开始每帧加 dir (1 或 -1)
+// apply fadeGain(x, len) to frames frames, x starting at pos and moving by dir (1 or -1) per frame
+static void fadeS16(int16_t *buf, uint32_t frames, uint32_t pos, int dir, uint32_t len)
+{
+    for (uint32_t i = 0; i < frames; i += MIX_SEGMENT_FRAMES)
+    {
+        uint32_t n = (frames - i < MIX_SEGMENT_FRAMES) ? frames - i : MIX_SEGMENT_FRAMES;
+        uint32_t p0 = pos + dir * (int32_t)i;
+        uint32_t p1 = p0 + dir * (int32_t)n;
+
+        int32_t g = fadeGain(p0, len) << MIX_GAIN_SHIFT;
+        const int32_t step = ((fadeGain(p1, len) << MIX_GAIN_SHIFT) - g) / (int32_t)n;
+
+        int16_t *a = buf + i * 2;
+        for (uint32_t k = 0; k < n; k++)
+        {
+            int32_t gi = g >> MIX_GAIN_SHIFT;
+            a[0] = (int16_t)((a[0] * gi + (1 << 14)) >> 15);
+            a[1] = (int16_t)((a[1] * gi + (1 << 14)) >> 15);
+            a += 2;
+            g += step;
+        }
+    }
+}
+
+void audio_mix_fadeEdgesS16(int16_t *buf, uint32_t frames, uint32_t fadeFrames)
+{
+    if (fadeFrames > frames / 2)
+        fadeFrames = frames / 2;
+    if (fadeFrames == 0)
+        return;
+
+    fadeS16(buf, fadeFrames, 0, 1, fadeFrames);
+    fadeS16(buf + (frames - fadeFrames) * 2, fadeFrames, fadeFrames, -1, fadeFrames);
+}
@@ -0,0 +1,17 @@
+#ifndef __AUDIO_MIX_H_
+#define __AUDIO_MIX_H_
+
+#include <stdint.h>
+
+// 两路 16 位立体声等功率交叉淡化, 结果写进 in: out 渐出 (cos), in 渐入 (sin);
+// pos 为这一段在整个淡化里的起点, len 为淡化总长, 单位都是帧
+// equal-power crossfade of two 16-bit stereo streams, written into in: out fades out (cos) and in
+// fades in (sin); pos is where this chunk starts within the fade and len the whole fade, both in frames
+void audio_mix_crossfadeS16(int16_t *in, const int16_t *out, uint32_t frames, uint32_t pos, uint32_t len);
+
+// 一段 16 位立体声两头各 fadeFrames 帧的淡入和淡出 (sin), 段不够长时两头各占一半
+// fade a chunk of 16-bit stereo in and out (sin) over fadeFrames frames at each end; a chunk too
+// short for that gets half of it for each
+void audio_mix_fadeEdgesS16(int16_t *buf, uint32_t frames, uint32_t fadeFrames);
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "audio_scope.h"
+
+// 中间缓冲区的序号, 加上表示音频线程放进来后还没被取走的标志; 两边都只用原子交换换走它
+// index of the middle buffer plus a flag meaning the audio thread put it there and it has not
+// been taken yet; both sides only ever swap it out with an atomic exchange
+#define SCOPE_FRESH 0x4
+
+static audio_scope_frame_t scope_buf[3];
+static uint8_t scope_middle = 1;
+
+// 以下只在音频线程使用
+// audio thread only below
+static uint8_t scope_back = 0;
+static uint32_t scope_column = 0;
+static uint32_t scope_count = 0;
+static int16_t scope_min[2] = {INT16_MAX, INT16_MAX};
+static int16_t scope_max[2] = {INT16_MIN, INT16_MIN};
+
+// 只在界面线程使用
+// GUI thread only
+static uint8_t scope_front = 2;
+
+// 每列只在收尾时写一次缓冲区, 采样循环里只有不带分支的最小/最大 (S3 上是 MIN/MAX 指令)
+// each column is written to the buffer once when it closes; the sample loop is branch-free
+// min/max (MIN/MAX instructions on the S3)
+void audio_scope_capture(const int16_t *samples, uint32_t frames)
+{
+    int32_t minL = scope_min[0], minR = scope_min[1];
+    int32_t maxL = scope_max[0], maxR = scope_max[1];
+
+    while (frames)
+    {
+        uint32_t n = AUDIO_SCOPE_FRAMES_PER_COLUMN - scope_count;
+        if (n > frames)
+            n = frames;
+
+        for (uint32_t i = 0; i < n; i++, samples += 2)
+        {
+            int32_t l = samples[0], r = samples[1];
+            minL = (l < minL) ? l : minL;
+            maxL = (l > maxL) ? l : maxL;
+            minR = (r < minR) ? r : minR;
+            maxR = (r > maxR) ? r : maxR;
+        }
+        frames -= n;
+        scope_count += n;
+        if (scope_count < AUDIO_SCOPE_FRAMES_PER_COLUMN)
+            break;
+
+        audio_scope_frame_t *back = &scope_buf[scope_back];
+        back->min[0][scope_column] = minL;
+        back->max[0][scope_column] = maxL;
+        back->min[1][scope_column] = minR;
+        back->max[1][scope_column] = maxR;
+        minL = minR = INT16_MAX;
+        maxL = maxR = INT16_MIN;
+        scope_count = 0;
+
+        // 一屏满了: 写好的换到中间, 拿回原来中间那块接着写; 界面还没取走的旧屏就此作废
+        // screen full: the finished buffer goes to the middle and the old middle comes back to be
+        // written; an old screen the GUI has not taken yet is simply dropped
+        if (++scope_column == AUDIO_SCOPE_COLUMNS)
+        {
+            scope_column = 0;
+            uint8_t old = __atomic_exchange_n(&scope_middle, scope_back | SCOPE_FRESH, __ATOMIC_ACQ_REL);
+            scope_back = old & 3;
+        }
+    }
+
+    scope_min[0] = minL;
+    scope_min[1] = minR;
+    scope_max[0] = maxL;
+    scope_max[1] = maxR;
+}
+
+const audio_scope_frame_t *audio_scope_read()
+{
+    if (!(__atomic_load_n(&scope_middle, __ATOMIC_RELAXED) & SCOPE_FRESH))
+        return NULL;
+
+    uint8_t old = __atomic_exchange_n(&scope_middle, scope_front, __ATOMIC_ACQ_REL);
+    scope_front = old & 3;
+    return &scope_buf[scope_front];
+}
@@ -0,0 +1,35 @@
+#ifndef __AUDIO_SCOPE_H_
+#define __AUDIO_SCOPE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 示波器: 音频线程按块把 16 位立体声抽成每列的最小/最大值, 攒满一屏后和中间缓冲区交换;
+// 界面线程每帧最多拿一次, 把中间缓冲区换成自己手里的那块. 三块缓冲区轮换, 双方都不等待
+// oscilloscope: the audio thread decimates 16-bit stereo block by block into a min/max per column
+// and, once a screen is full, swaps it with the middle buffer; the GUI thread takes at most one
+// per frame by swapping its own buffer for the middle one. Three buffers rotate, neither side waits
+
+// 一列一个像素, 和界面上示波器的宽度一致
+// one column per pixel, matching the oscilloscope width on screen
+#define AUDIO_SCOPE_COLUMNS 114
+// 每列的帧数, 一屏 114 * 20 帧约 52ms
+// frames per column; a screen of 114 * 20 frames is about 52ms
+#define AUDIO_SCOPE_FRAMES_PER_COLUMN 20
+
+typedef struct
+{
+    int16_t min[2][AUDIO_SCOPE_COLUMNS];
+    int16_t max[2][AUDIO_SCOPE_COLUMNS];
+} audio_scope_frame_t;
+
+// 音频线程, 每块调用一次
+// audio thread, once per block
+void audio_scope_capture(const int16_t *samples, uint32_t frames);
+
+// 界面线程: 有新的一屏时返回它, 否则返回 NULL; 返回的缓冲区在下次调用前不会被改写
+// GUI thread: returns the new screen if there is one, otherwise NULL; the returned buffer is not
+// touched until the next call
+const audio_scope_frame_t *audio_scope_read();
+
+#endif
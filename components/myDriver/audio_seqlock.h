@@ -0,0 +1,50 @@
+#ifndef __AUDIO_SEQLOCK_H_
+#define __AUDIO_SEQLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// 控制线程发布设置, 音频线程取用: 只有一份数据, 用序号锁保护, 和电平表快照一样, 奇数表示正在写.
+// 写的一方只有一个线程; 读的一方从不等待, 正好撞上写入就这一块先用旧的设置, 下一块再读
+// settings published by a control thread and taken by the audio thread: a single copy guarded by
+// a sequence lock, as the meter snapshot is, odd while being written. There is one writer thread;
+// the reader never waits, and when it runs into a write it keeps the old settings for this block
+// and reads again on the next
+
+// 控制线程 control thread
+static inline void audio_seqlock_write(uint32_t *seq, void *shared, const void *value, size_t size)
+{
+    uint32_t s = *seq;
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(shared, value, size);
+    __atomic_store_n(seq, s + 2, __ATOMIC_RELEASE);
+}
+
+// 音频线程: 有新发布且读到的是完整的一份时返回 true, 并记下它的序号
+// audio thread: returns true when something new was published and a whole copy was read, and
+// records its sequence number
+static inline bool audio_seqlock_read(uint32_t *seq, uint32_t *seen, void *value, const void *shared, size_t size)
+{
+    uint32_t s0 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+    if (s0 == *seen || (s0 & 1))
+        return false;
+
+    memcpy(value, shared, size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(seq, __ATOMIC_RELAXED) != s0)
+        return false;
+
+    *seen = s0;
+    return true;
+}
+
+// 有还没取走的发布 (可能正在写)
+// something published and not yet taken, possibly still being written
+static inline bool audio_seqlock_pending(uint32_t *seq, uint32_t seen)
+{
+    return __atomic_load_n(seq, __ATOMIC_RELAXED) != seen;
+}
+
+#endif
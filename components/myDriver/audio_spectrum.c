@@ -0,0 +1,192 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_fft.h"
+#include "audio_spectrum.h"
+
+#define SAMPLE_RATE 44100
+
+// 采集环只有音频线程写, 写完再更新总帧数; 分析线程拷完一窗后再看一次总帧数, 被覆盖了就丢掉这一窗
+// only the audio thread writes the capture ring and it bumps the frame total after copying; the
+// analyzer checks the total again after copying a window and drops it if it was overwritten
+static int16_t spec_ring[AUDIO_SPECTRUM_RING_FRAMES * 2];
+static uint32_t spec_written = 0;
+
+// 发布用序号锁: 写之前序号变奇数, 写完变偶数; 读的一方序号对不上就下次再读
+// publishing uses a sequence lock: odd while the frame is written, even once done; a reader
+// that sees the number move simply tries again next time
+static audio_spectrum_frame_t spec_published;
+static uint32_t spec_seq = 0;
+
+// 以下只在分析线程使用
+// analyzer thread only below
+static float spec_fftBuf[AUDIO_SPECTRUM_FFT_N * 2];
+static float spec_window[AUDIO_SPECTRUM_FFT_N];
+static float spec_pow[2][AUDIO_SPECTRUM_FFT_N / 2 + 1];
+static uint16_t spec_bandLo[AUDIO_SPECTRUM_BANDS];
+static uint16_t spec_bandHi[AUDIO_SPECTRUM_BANDS];
+static float spec_fullScale;
+static uint32_t spec_lastWritten = 0;
+static int16_t spec_level[2][AUDIO_SPECTRUM_BANDS]; // 0.1dB
+static int16_t spec_peak[2][AUDIO_SPECTRUM_BANDS];  // 0.1dB
+static uint8_t spec_hold[2][AUDIO_SPECTRUM_BANDS];
+
+void audio_spectrum_init()
+{
+    audio_fft_init();
+
+    // Hann 窗
+    // Hann window
+    for (int i = 0; i < AUDIO_SPECTRUM_FFT_N; i++)
+        spec_window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / AUDIO_SPECTRUM_FFT_N));
+
+    // 对数频带, 低频一个频带不到一根谱线时至少取一根
+    // log-spaced bands; where a low band is narrower than a bin it still takes one bin
+    for (int b = 0; b < AUDIO_SPECTRUM_BANDS; b++)
+    {
+        double f0 = AUDIO_SPECTRUM_FREQ_LOW * pow((double)AUDIO_SPECTRUM_FREQ_HIGH / AUDIO_SPECTRUM_FREQ_LOW, (double)b / AUDIO_SPECTRUM_BANDS);
+        double f1 = AUDIO_SPECTRUM_FREQ_LOW * pow((double)AUDIO_SPECTRUM_FREQ_HIGH / AUDIO_SPECTRUM_FREQ_LOW, (double)(b + 1) / AUDIO_SPECTRUM_BANDS);
+        uint32_t lo = (uint32_t)lround(f0 * AUDIO_SPECTRUM_FFT_N / SAMPLE_RATE);
+        uint32_t hi = (uint32_t)lround(f1 * AUDIO_SPECTRUM_FFT_N / SAMPLE_RATE);
+        if (lo < 1)
+            lo = 1;
+        if (hi <= lo)
+            hi = lo + 1;
+        spec_bandLo[b] = lo;
+        spec_bandHi[b] = hi;
+    }
+
+    // 满幅正弦经 Hann 窗后主瓣的总功率 (等效噪声带宽 1.5 根谱线), 作为 0dBFS
+    // total main-lobe power of a full-scale sine through the Hann window (1.5 bins of equivalent
+    // noise bandwidth) is taken as 0dBFS
+    spec_fullScale = (AUDIO_SPECTRUM_FFT_N / 4.0f) * (AUDIO_SPECTRUM_FFT_N / 4.0f) * 1.5f;
+}
+
+void audio_spectrum_capture(const int16_t *samples, uint32_t frames)
+{
+    if (frames > AUDIO_SPECTRUM_RING_FRAMES)
+    {
+        samples += (frames - AUDIO_SPECTRUM_RING_FRAMES) * 2;
+        frames = AUDIO_SPECTRUM_RING_FRAMES;
+    }
+
+    uint32_t written = spec_written;
+    uint32_t at = written % AUDIO_SPECTRUM_RING_FRAMES;
+    uint32_t n = AUDIO_SPECTRUM_RING_FRAMES - at;
+    if (n > frames)
+        n = frames;
+    memcpy(spec_ring + at * 2, samples, n * 2 * sizeof(int16_t));
+    memcpy(spec_ring, samples + n * 2, (frames - n) * 2 * sizeof(int16_t));
+
+    __atomic_store_n(&spec_written, written + frames, __ATOMIC_RELEASE);
+}
+
+// 取最新一窗加窗后放进 FFT 缓冲区, 左声道实部, 右声道虚部
+// copy the newest window into the FFT buffer with the window applied, left in the real part and
+// right in the imaginary part
+static bool takeWindow()
+{
+    uint32_t written = __atomic_load_n(&spec_written, __ATOMIC_ACQUIRE);
+    if (written == spec_lastWritten || written < AUDIO_SPECTRUM_FFT_N)
+        return false;
+    spec_lastWritten = written;
+
+    uint32_t start = written - AUDIO_SPECTRUM_FFT_N;
+    const float scale = 1.0f / 32768.0f;
+    for (uint32_t i = 0; i < AUDIO_SPECTRUM_FFT_N; i++)
+    {
+        const int16_t *s = spec_ring + ((start + i) % AUDIO_SPECTRUM_RING_FRAMES) * 2;
+        float w = spec_window[i] * scale;
+        spec_fftBuf[i * 2] = s[0] * w;
+        spec_fftBuf[i * 2 + 1] = s[1] * w;
+    }
+
+    written = __atomic_load_n(&spec_written, __ATOMIC_ACQUIRE);
+    return written - start <= AUDIO_SPECTRUM_RING_FRAMES;
+}
+
+// 电平上升立即跟上, 下降按固定速度; 峰值保持一段时间后再下落
+// levels rise at once and fall at a fixed rate; peaks hold for a while before falling
+static void updateBand(int ch, int b, int16_t now)
+{
+    int16_t level = spec_level[ch][b] - AUDIO_SPECTRUM_LEVEL_FALL_DB10;
+    if (now > level)
+        level = now;
+    if (level < 0)
+        level = 0;
+    spec_level[ch][b] = level;
+
+    if (level >= spec_peak[ch][b])
+    {
+        spec_peak[ch][b] = level;
+        spec_hold[ch][b] = AUDIO_SPECTRUM_PEAK_HOLD_FRAMES;
+    }
+    else if (spec_hold[ch][b])
+    {
+        spec_hold[ch][b]--;
+    }
+    else
+    {
+        int16_t peak = spec_peak[ch][b] - AUDIO_SPECTRUM_PEAK_FALL_DB10;
+        spec_peak[ch][b] = (peak > level) ? peak : level;
+    }
+}
+
+void audio_spectrum_analyze()
+{
+    bool fresh = takeWindow();
+    if (fresh)
+    {
+        audio_fft_complex(spec_fftBuf, AUDIO_SPECTRUM_FFT_N);
+        audio_fft_splitStereo(spec_fftBuf, spec_pow[0], spec_pow[1], AUDIO_SPECTRUM_FFT_N);
+    }
+
+    for (int ch = 0; ch < 2; ch++)
+    {
+        for (int b = 0; b < AUDIO_SPECTRUM_BANDS; b++)
+        {
+            int16_t now = 0;
+            if (fresh)
+            {
+                float sum = 0.0f;
+                for (int k = spec_bandLo[b]; k < spec_bandHi[b]; k++)
+                    sum += spec_pow[ch][k];
+                float db10 = 100.0f * log10f(sum / spec_fullScale + 1e-12f) + AUDIO_SPECTRUM_RANGE_DB * 10;
+                if (db10 > AUDIO_SPECTRUM_RANGE_DB * 10)
+                    db10 = AUDIO_SPECTRUM_RANGE_DB * 10;
+                now = (db10 > 0.0f) ? (int16_t)db10 : 0;
+            }
+            updateBand(ch, b, now);
+        }
+    }
+
+    uint32_t seq = spec_seq;
+    __atomic_store_n(&spec_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (int ch = 0; ch < 2; ch++)
+    {
+        for (int b = 0; b < AUDIO_SPECTRUM_BANDS; b++)
+        {
+            spec_published.level[ch][b] = spec_level[ch][b] / 10;
+            spec_published.peak[ch][b] = spec_peak[ch][b] / 10;
+        }
+    }
+    __atomic_store_n(&spec_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+bool audio_spectrum_read(audio_spectrum_frame_t *frame, uint32_t *seq)
+{
+    uint32_t s0 = __atomic_load_n(&spec_seq, __ATOMIC_ACQUIRE);
+    if ((s0 & 1) || s0 == *seq)
+        return false;
+
+    memcpy(frame, &spec_published, sizeof(*frame));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    if (__atomic_load_n(&spec_seq, __ATOMIC_RELAXED) != s0)
+        return false;
+    *seq = s0;
+    return true;
+}
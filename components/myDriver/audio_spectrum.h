@@ -0,0 +1,49 @@
+#ifndef __AUDIO_SPECTRUM_H_
+#define __AUDIO_SPECTRUM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 频谱分析: 音频线程把 16 位立体声写进采集环, 分析线程按显示帧率取最新一窗做 FFT, 按对数频带汇总,
+// 带峰值保持, 发布给界面; 三方都不会等待彼此
+// spectrum analyzer: the audio thread writes 16-bit stereo into a capture ring, the analyzer
+// thread takes the newest window at display rate, runs the FFT, sums log-spaced bands with peak
+// hold and publishes them to the GUI; none of the three ever waits on another
+
+#define AUDIO_SPECTRUM_FFT_N 1024
+#define AUDIO_SPECTRUM_RING_FRAMES 2048
+#define AUDIO_SPECTRUM_BANDS 16
+#define AUDIO_SPECTRUM_FREQ_LOW 50
+#define AUDIO_SPECTRUM_FREQ_HIGH 16000
+// 显示范围 0 ~ 60, 即 -60 ~ 0dBFS
+// display range 0 ~ 60, i.e. -60 ~ 0dBFS
+#define AUDIO_SPECTRUM_RANGE_DB 60
+// 峰值保持时间和之后的下落速度, 以及电平的下落速度, 按分析帧计
+// peak hold time and fall rate afterwards, and the level fall rate, in analyzer frames
+#define AUDIO_SPECTRUM_PEAK_HOLD_FRAMES 15
+#define AUDIO_SPECTRUM_PEAK_FALL_DB10 5
+#define AUDIO_SPECTRUM_LEVEL_FALL_DB10 15
+
+typedef struct
+{
+    uint8_t level[2][AUDIO_SPECTRUM_BANDS]; // dB 高于 -60dBFS dB above -60dBFS
+    uint8_t peak[2][AUDIO_SPECTRUM_BANDS];
+} audio_spectrum_frame_t;
+
+// 采样率 44100
+// sample rate 44100
+void audio_spectrum_init();
+
+// 音频线程: 只拷贝, 不等待
+// audio thread: copies only, never waits
+void audio_spectrum_capture(const int16_t *samples, uint32_t frames);
+
+// 分析线程, 按显示帧率调用; 没有新数据时电平照样下落
+// analyzer thread, called at display rate; levels keep falling when no new data arrived
+void audio_spectrum_analyze();
+
+// 界面线程: 有新的一帧时拷出来返回 true, seq 记录上次拿到的帧号
+// GUI thread: copies out and returns true when there is a new frame; seq tracks the last frame taken
+bool audio_spectrum_read(audio_spectrum_frame_t *frame, uint32_t *seq);
+
+#endif
@@ -0,0 +1,176 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_src.h"
+
+typedef struct
+{
+    uint32_t taps;
+    double beta; // Kaiser
+} srcQuality_t;
+
+static const srcQuality_t srcQuality[] = {
+    [AUDIO_SRC_LOW] = {16, 5.65},
+    [AUDIO_SRC_MEDIUM] = {32, 7.86},
+    [AUDIO_SRC_HIGH] = {64, 10.06},
+};
+
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+// 第 p 相第 j 个系数对应的距离 d = p/P + taps/2 - 1 - j (单位: 输入采样),
+// 截止频率取输入和输出奈奎斯特频率中较低的那个, 每相归一化为直流增益 1
+// tap j of phase p sits at distance d = p/P + taps/2 - 1 - j (in input samples); the cutoff is
+// the lower of the input and output Nyquist frequencies; every phase is normalised to unity DC gain
+static void designTable(int32_t *table, uint32_t taps, double beta, double cutoff)
+{
+    double half = taps / 2.0;
+    double i0Beta = besselI0(beta);
+    double h[64];
+
+    for (int p = 0; p <= AUDIO_SRC_PHASES; p++)
+    {
+        double sum = 0;
+        for (uint32_t j = 0; j < taps; j++)
+        {
+            double d = (double)p / AUDIO_SRC_PHASES + half - 1 - j;
+            double r = d / half;
+            double w = (r <= -1.0 || r >= 1.0) ? 0.0 : besselI0(beta * sqrt(1.0 - r * r)) / i0Beta;
+            double x = M_PI * cutoff * d;
+            double sinc = (fabs(x) < 1e-12) ? 1.0 : sin(x) / x;
+            h[j] = cutoff * sinc * w;
+            sum += h[j];
+        }
+        for (uint32_t j = 0; j < taps; j++)
+            table[p * taps + j] = (int32_t)lrint(h[j] / sum * (double)(1 << 30));
+    }
+}
+
+esp_err_t audio_src_init(audio_src_t *src, uint32_t inRate, uint32_t outRate, audio_src_quality_t quality, uint32_t maxInFrames)
+{
+    memset(src, 0, sizeof(audio_src_t));
+    if (quality > AUDIO_SRC_HIGH)
+        quality = AUDIO_SRC_HIGH;
+
+    src->taps = srcQuality[quality].taps;
+    src->histCap = src->taps + maxInFrames;
+    src->table = (int32_t *)malloc((AUDIO_SRC_PHASES + 1) * src->taps * sizeof(int32_t));
+    src->hist = (int32_t *)malloc(src->histCap * 2 * sizeof(int32_t));
+    if (!src->table || !src->hist)
+    {
+        audio_src_deinit(src);
+        return ESP_ERR_NO_MEM;
+    }
+
+    double cutoff = (outRate < inRate) ? (double)outRate / inRate : 1.0;
+    designTable(src->table, src->taps, srcQuality[quality].beta, cutoff);
+    src->step = ((uint64_t)inRate << 32) / outRate;
+    audio_src_reset(src);
+    return ESP_OK;
+}
+
+void audio_src_deinit(audio_src_t *src)
+{
+    free(src->table);
+    free(src->hist);
+    src->table = NULL;
+    src->hist = NULL;
+}
+
+void audio_src_reset(audio_src_t *src)
+{
+    uint32_t half = src->taps / 2;
+    memset(src->hist, 0, half * 2 * sizeof(int32_t));
+    src->histFrames = half;
+    src->pos = half - 1;
+    src->frac = 0;
+}
+
+void audio_src_trim(audio_src_t *src, uint32_t inRate, uint32_t outRate, int32_t ppm)
+{
+    src->step = (((uint64_t)inRate << 32) / outRate) * 1000000 / (uint32_t)(1000000 + ppm);
+}
+
+// 32x32 取高 32 位, Xtensa 上是一条 MULSH
+// high 32 bits of a 32x32 product, a single MULSH on Xtensa
+static inline int32_t mulsh(int32_t a, int32_t b)
+{
+    return (int32_t)(((int64_t)a * b) >> 32);
+}
+
+static inline int32_t sat32(int64_t x)
+{
+    if (x > INT32_MAX)
+        return INT32_MAX;
+    if (x < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)x;
+}
+
+uint32_t audio_src_process(audio_src_t *src, const int32_t *in, uint32_t inFrames, int32_t *out, uint32_t maxOutFrames)
+{
+    const uint32_t taps = src->taps;
+    const uint32_t half = taps / 2;
+    const uint32_t stepInt = (uint32_t)(src->step >> 32);
+    const uint32_t stepFrac = (uint32_t)src->step;
+
+    if (src->histFrames + inFrames > src->histCap)
+        inFrames = src->histCap - src->histFrames;
+    memcpy(src->hist + src->histFrames * 2, in, inFrames * 2 * sizeof(int32_t));
+    src->histFrames += inFrames;
+
+    uint32_t pos = src->pos;
+    uint32_t frac = src->frac;
+    uint32_t n = 0;
+    while (pos + half < src->histFrames && n < maxOutFrames)
+    {
+        const int32_t *x = src->hist + (pos + 1 - half) * 2;
+        const int32_t *c0 = src->table + (frac >> (32 - AUDIO_SRC_PHASE_BITS)) * taps;
+        const int32_t *c1 = c0 + taps;
+        // 相位间的插值系数 Q31
+        // interpolation weight between the two phases, Q31
+        const int32_t mu = (int32_t)((frac << AUDIO_SRC_PHASE_BITS) >> 1);
+
+        // 左右声道共用同一组插值后的系数; x 满幅 Q29, 系数 Q30, 累加 Q27
+        // both channels share the interpolated coefficients; x is Q29 full scale, coefficients Q30,
+        // the sum is Q27
+        int32_t accL = 0;
+        int32_t accR = 0;
+        for (uint32_t j = 0; j < taps; j++)
+        {
+            int32_t c = c0[j] + (mulsh(c1[j] - c0[j], mu) << 1);
+            accL += mulsh(x[j * 2], c);
+            accR += mulsh(x[j * 2 + 1], c);
+        }
+        out[n * 2] = sat32((int64_t)accL << 2);
+        out[n * 2 + 1] = sat32((int64_t)accR << 2);
+        n++;
+
+        uint32_t f = frac + stepFrac;
+        pos += stepInt + (f < frac);
+        frac = f;
+    }
+
+    // 丢掉不再需要的输入
+    // drop input that is no longer needed
+    uint32_t drop = pos + 1 - half;
+    if (drop > src->histFrames)
+        drop = src->histFrames;
+    memmove(src->hist, src->hist + drop * 2, (src->histFrames - drop) * 2 * sizeof(int32_t));
+    src->histFrames -= drop;
+    src->pos = pos - drop;
+    src->frac = frac;
+    return n;
+}
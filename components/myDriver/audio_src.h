@@ -0,0 +1,44 @@
+#ifndef __AUDIO_SRC_H_
+#define __AUDIO_SRC_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// 多相 FIR 重采样, 每相之间线性插值系数, 任意比例
+// polyphase FIR resampler, coefficients linearly interpolated between phases, any ratio
+#define AUDIO_SRC_PHASE_BITS 7
+#define AUDIO_SRC_PHASES (1 << AUDIO_SRC_PHASE_BITS)
+
+typedef enum
+{
+    AUDIO_SRC_LOW = 0, // 16 taps, 60dB
+    AUDIO_SRC_MEDIUM,  // 32 taps, 80dB
+    AUDIO_SRC_HIGH,    // 64 taps, 100dB
+} audio_src_quality_t;
+
+typedef struct
+{
+    uint32_t taps;
+    int32_t *table;       // (AUDIO_SRC_PHASES + 1) * taps, Q30
+    int32_t *hist;        // 立体声输入历史 stereo input history
+    uint32_t histCap;     // 帧 frames
+    uint32_t histFrames;
+    uint32_t pos;         // 当前输出对应的输入位置, 整数部分 integer input position of the next output
+    uint32_t frac;        // 小数部分 Q32 fraction
+    uint64_t step;        // 每个输出帧前进的输入帧数 input frames per output frame, Q32
+} audio_src_t;
+
+// 输出帧数上限 (含一帧余量)
+// upper bound of output frames (one frame of slack)
+#define AUDIO_SRC_MAX_OUT(inFrames, inRate, outRate) ((uint32_t)(((uint64_t)(inFrames) * (outRate) + (inRate) - 1) / (inRate)) + 1)
+
+esp_err_t audio_src_init(audio_src_t *src, uint32_t inRate, uint32_t outRate, audio_src_quality_t quality, uint32_t maxInFrames);
+void audio_src_deinit(audio_src_t *src);
+void audio_src_reset(audio_src_t *src);
+// 输出端的实际频率比 outRate 高 ppm 时微调比例, 滤波器不变, 可以在两次处理之间随时调用
+// fine-tunes the ratio for an output running ppm faster than outRate; the filter stays as it is,
+// and this may be called between any two process calls
+void audio_src_trim(audio_src_t *src, uint32_t inRate, uint32_t outRate, int32_t ppm);
+uint32_t audio_src_process(audio_src_t *src, const int32_t *in, uint32_t inFrames, int32_t *out, uint32_t maxOutFrames);
+
+#endif
@@ -0,0 +1,194 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_wsola.h"
+
+typedef struct
+{
+    uint16_t search; // 搜索范围 ± 帧 search range, ± frames
+    uint8_t coarse;  // 粗找的位置和采样间隔 lag and sample step of the coarse search
+    uint8_t fine;    // 细找的采样间隔 sample step of the fine search
+} wsolaQuality_t;
+
+static const wsolaQuality_t wsolaQuality[] = {
+    [AUDIO_WSOLA_LOW] = {128, 8, 4},
+    [AUDIO_WSOLA_MEDIUM] = {256, 8, 2},
+    [AUDIO_WSOLA_HIGH] = {AUDIO_WSOLA_SEARCH_MAX, 4, 1},
+};
+
+// 渐入增益 sin^2, Q15, 和渐出的 cos^2 加起来为 1
+// fade-in gain sin^2 in Q15; it sums to 1 with the cos^2 fade-out
+static int32_t wsola_fade[AUDIO_WSOLA_HOP];
+static bool wsola_fadeReady = false;
+
+esp_err_t audio_wsola_init(audio_wsola_t *w, audio_wsola_quality_t quality, uint32_t maxInFrames)
+{
+    memset(w, 0, sizeof(audio_wsola_t));
+
+    // 保留的输入最多是两个步长加两倍搜索范围, 再加上新来的一块
+    // the input kept is at most two hops plus twice the search range, plus the block just added
+    w->cap = AUDIO_WSOLA_HOP * 3 + AUDIO_WSOLA_SEARCH_MAX * 2 + maxInFrames;
+    w->in = (int32_t *)malloc(w->cap * 2 * sizeof(int32_t));
+    w->mono = (float *)malloc(w->cap * sizeof(float));
+    if (!w->in || !w->mono)
+    {
+        audio_wsola_deinit(w);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (!wsola_fadeReady)
+    {
+        for (int i = 0; i < AUDIO_WSOLA_HOP; i++)
+        {
+            double s = sin(M_PI_2 * (i + 0.5) / AUDIO_WSOLA_HOP);
+            wsola_fade[i] = (int32_t)lrint(s * s * 32768.0);
+        }
+        wsola_fadeReady = true;
+    }
+
+    w->speed = AUDIO_WSOLA_SPEED_UNITY;
+    audio_wsola_setQuality(w, quality);
+    return ESP_OK;
+}
+
+void audio_wsola_deinit(audio_wsola_t *w)
+{
+    free(w->in);
+    free(w->mono);
+    w->in = NULL;
+    w->mono = NULL;
+}
+
+// 上一段假定在输入开头之前一个步长, 第一段的自然延续就是输入开头, 速度为 1 时逐采样原样输出
+// the previous segment is taken to sit one hop before the start of the input, so the first
+// natural continuation is the start itself and at speed 1 the output equals the input sample for sample
+void audio_wsola_reset(audio_wsola_t *w)
+{
+    w->frames = 0;
+    w->prev = -AUDIO_WSOLA_HOP;
+    w->nominal = 0;
+}
+
+void audio_wsola_setSpeed(audio_wsola_t *w, uint32_t speed)
+{
+    if (speed < AUDIO_WSOLA_SPEED_MIN)
+        speed = AUDIO_WSOLA_SPEED_MIN;
+    if (speed > AUDIO_WSOLA_SPEED_MAX)
+        speed = AUDIO_WSOLA_SPEED_MAX;
+    w->speed = speed;
+}
+
+void audio_wsola_setQuality(audio_wsola_t *w, audio_wsola_quality_t quality)
+{
+    if (quality > AUDIO_WSOLA_HIGH)
+        quality = AUDIO_WSOLA_HIGH;
+    w->search = wsolaQuality[quality].search;
+    w->coarse = wsolaQuality[quality].coarse;
+    w->fine = wsolaQuality[quality].fine;
+    audio_wsola_reset(w);
+}
+
+// 归一化互相关的平方, 带符号, 省掉开方: c|c| / e
+// signed square of the normalised cross-correlation, c|c| / e, which saves the square root
+static float similarity(const float *a, const float *b, uint32_t step)
+{
+    float c = 0.0f, e = 0.0f;
+    for (uint32_t i = 0; i < AUDIO_WSOLA_HOP; i += step)
+    {
+        c += a[i] * b[i];
+        e += b[i] * b[i];
+    }
+    return (e > 0.0f) ? c * fabsf(c) / e : 0.0f;
+}
+
+static uint32_t bestMatch(const audio_wsola_t *w, uint32_t target, uint32_t lo, uint32_t hi)
+{
+    const float *ref = w->mono + target;
+
+    uint32_t best = lo;
+    float bestScore = -INFINITY;
+    for (uint32_t c = lo; c <= hi; c += w->coarse)
+    {
+        float s = similarity(ref, w->mono + c, w->coarse);
+        if (s > bestScore)
+        {
+            bestScore = s;
+            best = c;
+        }
+    }
+
+    uint32_t fineLo = (best > lo + w->coarse - 1) ? best - (w->coarse - 1) : lo;
+    uint32_t fineHi = (best + w->coarse - 1 < hi) ? best + (w->coarse - 1) : hi;
+    bestScore = -INFINITY;
+    for (uint32_t c = fineLo; c <= fineHi; c++)
+    {
+        float s = similarity(ref, w->mono + c, w->fine);
+        if (s > bestScore)
+        {
+            bestScore = s;
+            best = c;
+        }
+    }
+    return best;
+}
+
+uint32_t audio_wsola_process(audio_wsola_t *w, const int32_t *in, uint32_t inFrames, int32_t *out, uint32_t maxOutFrames)
+{
+    if (w->frames + inFrames > w->cap)
+        inFrames = w->cap - w->frames;
+    memcpy(w->in + w->frames * 2, in, inFrames * 2 * sizeof(int32_t));
+    for (uint32_t i = 0; i < inFrames; i++)
+        w->mono[w->frames + i] = (float)in[i * 2] + (float)in[i * 2 + 1];
+    w->frames += inFrames;
+
+    uint32_t n = 0;
+    while (n + AUDIO_WSOLA_HOP <= maxOutFrames)
+    {
+        uint32_t target = (uint32_t)(w->prev + AUDIO_WSOLA_HOP);
+        uint32_t nominal = (uint32_t)(w->nominal >> 16);
+        uint32_t lo = (nominal > w->search) ? nominal - w->search : 0;
+        uint32_t hi = nominal + w->search;
+        if (hi + AUDIO_WSOLA_HOP > w->frames || target + AUDIO_WSOLA_HOP > w->frames)
+            break;
+
+        uint32_t pos = bestMatch(w, target, lo, hi);
+
+        // 上一段的后半渐出, 新一段的前半渐入
+        // the second half of the previous segment fades out while the first half of the new one fades in
+        const int32_t *a = w->in + target * 2;
+        const int32_t *b = w->in + pos * 2;
+        int32_t *o = out + n * 2;
+        for (uint32_t i = 0; i < AUDIO_WSOLA_HOP * 2; i++)
+        {
+            int32_t g = wsola_fade[i >> 1];
+            o[i] = (int32_t)(((int64_t)a[i] * (32768 - g) + (int64_t)b[i] * g) >> 15);
+        }
+        n += AUDIO_WSOLA_HOP;
+
+        w->prev = pos;
+        w->nominal += (uint64_t)AUDIO_WSOLA_HOP * w->speed;
+    }
+
+    // 丢掉以后不会再用到的输入: 下一段的自然延续和搜索范围都在这之后
+    // drop input that will not be used again: both the next natural continuation and the search
+    // range lie beyond it
+    uint32_t target = (uint32_t)(w->prev + AUDIO_WSOLA_HOP);
+    uint32_t nominal = (uint32_t)(w->nominal >> 16);
+    uint32_t drop = (nominal > w->search) ? nominal - w->search : 0;
+    if (drop > target)
+        drop = target;
+    if (drop > w->frames)
+        drop = w->frames;
+    if (drop)
+    {
+        memmove(w->in, w->in + drop * 2, (w->frames - drop) * 2 * sizeof(int32_t));
+        memmove(w->mono, w->mono + drop, (w->frames - drop) * sizeof(float));
+        w->frames -= drop;
+        w->prev -= drop;
+        w->nominal -= (uint64_t)drop << 16;
+    }
+    return n;
+}
@@ -0,0 +1,62 @@
+#ifndef __AUDIO_WSOLA_H_
+#define __AUDIO_WSOLA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// WSOLA 变速不变调: 输出每次前进一个步长, 输入按速度前进; 在名义位置附近找和上一段自然延续最相似的一段,
+// 两段交叉淡化接上. 相似度先在抽取后的单声道上粗找, 再在粗找结果附近细找, 每个输出采样的运算量固定
+// WSOLA time-stretch: the output advances one hop at a time while the input advances by hop times
+// speed; around the nominal position it picks the segment most similar to the natural
+// continuation of the previous one and crossfades the two. Similarity is searched coarsely on
+// decimated mono, then finely around the coarse hit, so the work per output sample is fixed
+
+// 输出步长, 也是交叉淡化长度 (11.6ms)
+// output hop, which is also the crossfade length (11.6ms)
+#define AUDIO_WSOLA_HOP 512
+#define AUDIO_WSOLA_SEARCH_MAX 448
+// 速度 Q16, 0.5 ~ 2 倍
+// speed in Q16, 0.5x ~ 2x
+#define AUDIO_WSOLA_SPEED_UNITY 65536
+#define AUDIO_WSOLA_SPEED_MIN (AUDIO_WSOLA_SPEED_UNITY / 2)
+#define AUDIO_WSOLA_SPEED_MAX (AUDIO_WSOLA_SPEED_UNITY * 2)
+// 一次调用最多输出的帧数
+// most frames a single call can output
+#define AUDIO_WSOLA_MAX_OUT(inFrames) ((inFrames) * 2 + AUDIO_WSOLA_HOP)
+
+typedef enum
+{
+    AUDIO_WSOLA_LOW = 0, // 搜索 ±128, 粗找每 8 个, 细找每 4 个采样 search ±128, coarse every 8th, fine every 4th sample
+    AUDIO_WSOLA_MEDIUM,  // ±256, 8, 2
+    AUDIO_WSOLA_HIGH,    // ±448, 4, 1
+} audio_wsola_quality_t;
+
+typedef struct
+{
+    int32_t *in;       // 立体声输入, 内部格式 stereo input in the internal format
+    float *mono;       // 同一段输入的单声道, 只用来比较相似度 mono of the same input, only for similarity
+    uint32_t cap;      // 帧 frames
+    uint32_t frames;
+    int32_t prev;      // 上一段的起点 start of the previous segment
+    uint64_t nominal;  // 下一段的名义起点 Q16 nominal start of the next segment, Q16
+    uint32_t speed;    // Q16
+    uint16_t search;
+    uint8_t coarse;
+    uint8_t fine;
+} audio_wsola_t;
+
+// 缓冲区按输入块大小分配
+// buffers are sized for the input block size
+esp_err_t audio_wsola_init(audio_wsola_t *w, audio_wsola_quality_t quality, uint32_t maxInFrames);
+void audio_wsola_deinit(audio_wsola_t *w);
+void audio_wsola_reset(audio_wsola_t *w);
+// 下一个步长开始生效, 不用清空
+// takes effect from the next hop, no reset needed
+void audio_wsola_setSpeed(audio_wsola_t *w, uint32_t speed);
+void audio_wsola_setQuality(audio_wsola_t *w, audio_wsola_quality_t quality);
+// 输出帧数平均为输入的 1/速度, 按步长成批产生, 一次可能是 0
+// outputs 1/speed as many frames as it takes on average, produced hop by hop, so a call may return 0
+uint32_t audio_wsola_process(audio_wsola_t *w, const int32_t *in, uint32_t inFrames, int32_t *out, uint32_t maxOutFrames);
+
+#endif
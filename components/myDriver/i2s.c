@@ -4,51 +4,224 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "driver/i2s_std.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "sdkconfig.h"
 
 #include "main.h"
 #include "i2s.h"
 #include "cdPlayer.h"
+#include "audio_gain.h"
+#include "audio_biquad.h"
+#include "audio_format.h"
+#include "audio_eq.h"
+#include "audio_src.h"
+#include "audio_dither.h"
+#include "audio_dynamics.h"
+#include "audio_crossfeed.h"
+#include "audio_spectrum.h"
+#include "audio_meter.h"
+#include "audio_scope.h"
+#include "audio_wsola.h"
+#include "audio_graph.h"
+#include "audio_clock.h"
+#include "audio_matrix.h"
+#include "audio_seqlock.h"
 
 #define EXAMPLE_STD_BCLK_IO1 PIN_I2S_BCK // I2S bit clock io number
 #define EXAMPLE_STD_WS_IO1 PIN_I2S_LRCK  // I2S word select io number
 #define EXAMPLE_STD_DOUT_IO1 PIN_I2S_DAT // I2S data in io number
 
 #define I2S_SAMPLE_RATE 44100
-#define I2S_DATA_BIT I2S_DATA_BIT_WIDTH_16BIT
-#define BYTES_PER_SAMPLE (I2S_DATA_BIT_WIDTH_16BIT / 8 * 2)
+#define I2S_DATA_BIT I2S_DATA_BIT_WIDTH_32BIT
+#define BYTES_PER_SAMPLE (I2S_DATA_BIT_WIDTH_32BIT / 8 * 2)
+
+// 每次写入 I2S 的帧数 (一个 CD 扇区, 13.3ms), 音量在块之间重新读取
+// frames per I2S write (one CD sector, 13.3ms); volume is re-read between blocks
+#define I2S_BLOCK_FRAMES 588
+// 变调变速时重采样器的输入率跟着速度缩放, 最慢时一块输出最多; 跟随外部时钟再加上微调范围
+// in tape-style varispeed the resampler's input rate scales with speed, so the slowest speed
+// gives the most output per block; following an external clock adds the trim range on top
+#define I2S_SRC_OUT_FRAMES AUDIO_SRC_MAX_OUT(I2S_BLOCK_FRAMES, I2S_SAMPLE_RATE * I2S_SPEED_MIN / 100, \
+                                             I2S_OUTPUT_RATE_MAX + I2S_OUTPUT_RATE_MAX / 1000 * I2S_CLOCK_TRIM_PPM / 1000)
+#define I2S_STRETCH_OUT_FRAMES AUDIO_WSOLA_MAX_OUT(I2S_BLOCK_FRAMES)
 
 TaskHandle_t transmitTask;
 
 i2s_chan_handle_t tx_chan;
 
 uint8_t i2s_txBuf[I2S_BUF_NUM][I2S_TX_BUFFER_LEN];
+// 每个缓冲区在光盘上的位置和所属代数, i2s_flush() 之后旧一代的缓冲区不再播放
+// disc position and generation of each buffer; buffers of an older generation are not played
+// after i2s_flush()
+static i2s_bufPos_t i2s_bufPos[I2S_BUF_NUM];
+static uint8_t i2s_bufGen[I2S_BUF_NUM];
+static volatile uint8_t i2s_gen = 0;
+// 正在播放的位置, 音轨在高 8 位, 扇区在低 24 位, 一次读写不会读到一半
+// position being played: track in the top 8 bits, sector in the low 24, so it is read and written
+// in one go
+#define I2S_PLAY_POS_NONE 0xffffffff
+static volatile uint32_t i2s_playPos = I2S_PLAY_POS_NONE;
 uint8_t i2s_buf_sendI = 0;
 uint8_t i2s_buf_inserI = 0;
 volatile bool i2s_bufsEmpty = true;
 volatile bool i2s_bufsFull = false;
+// 已填的缓冲区数, 两个线程都用原子加减; 到目标深度就算满
+// buffers filled, changed atomically by both threads; the ring counts as full at the target depth
+static uint8_t i2s_bufCount = 0;
+static volatile uint8_t i2s_bufDepth = I2S_BUF_NUM;
 
-// -60dB ~ 0dB
-const float volumeScale[31] = {
-    0.000000,
-    0.001000, 0.001269, 0.001610, 0.002043, 0.002593, 0.003290, 0.004175, 0.005298, 0.006723, 0.008532,
-    0.010826, 0.013738, 0.017433, 0.022122, 0.028072, 0.035622, 0.045204, 0.057362, 0.072790, 0.092367,
-    0.117210, 0.148735, 0.188739, 0.239503, 0.303920, 0.385662, 0.489390, 0.621017, 0.788046, 1.000000};
+// 断流统计: 排空时发送线程记下开始时间和原因, 恢复后由它算时长并调整深度
+// underrun accounting: on draining, the transmit task notes the start time and cause; once
+// resumed it works out the duration and adjusts the depth
+#define I2S_XRUN_STABLE_SECTORS (I2S_XRUN_STABLE_MS * 75 / 1000)
+static volatile bool i2s_streaming = false;
+static volatile bool i2s_depthHeld = false;
+static volatile int64_t i2s_readStart = 0;
+static i2s_xrunStats_t i2s_xrun = {.depth = I2S_BUF_NUM};
+static const char *i2s_xrunCauseName[I2S_XRUN_CAUSES] = {"usb", "control", "seek"};
 
-void i2s_fillBuffer(uint8_t *dat)
+typedef struct
 {
-    if (i2s_bufsFull)
+    uint8_t dmaDesc;
+    uint16_t dmaFrames;
+    uint8_t sectors;  // 每次读盘 per disc read
+    uint8_t depthMin;
+    uint8_t depthMax;
+} i2s_profileConfig_t;
+
+static const i2s_profileConfig_t i2s_profiles[I2S_LATENCY_PROFILES] = {
+    [I2S_LATENCY_LOW] = {3, 240, 2, 2, 4},
+    [I2S_LATENCY_BALANCED] = {6, 240, I2S_TX_BUFFER_SIZE_FRAME, 2, I2S_BUF_NUM},
+    [I2S_LATENCY_ROBUST] = {8, 480, I2S_TX_BUFFER_SIZE_FRAME, 4, I2S_BUF_NUM},
+};
+// 请求的档位和通道实际用的档位 requested profile and the one the channel was built with
+static volatile uint8_t i2s_profile = I2S_LATENCY_BALANCED;
+static uint8_t i2s_profileOpen = I2S_LATENCY_BALANCED;
+
+// 延迟测量: 控制线程写好其余字段后最后写时间, 非 0 表示在等
+// latency probe: the control thread writes the time last, after the other fields; non-zero means waiting
+#define I2S_PROBE_TIMEOUT_MS 5000
+static volatile int64_t i2s_probeAt = 0;
+static volatile uint8_t i2s_probeKind;
+static volatile uint8_t i2s_probeGen;
+static volatile uint32_t i2s_probeBlock;
+static volatile uint32_t i2s_blockSeq = 0;
+static volatile uint32_t i2s_latencyMs = 0;
+
+// -60dB ~ 0dB, Q15
+const int32_t volumeGain[31] = {
+    0,
+    33, 42, 53, 67, 85, 108, 137, 174, 220, 280,
+    355, 450, 571, 725, 920, 1167, 1481, 1880, 2385, 3027,
+    3841, 4874, 6185, 7848, 9959, 12637, 16036, 20349, 25823, AUDIO_GAIN_UNITY_Q15};
+
+// 重采样器在控制线程里建好 (设计滤波器较慢), 发送线程在两个缓冲区之间换上
+// the resampler is built on the control thread (filter design is slow) and the transmit task
+// swaps it in between buffers
+static audio_src_t i2s_srcNext;
+static volatile bool i2s_srcNextOn = false;
+static volatile uint32_t i2s_srcNextRate = I2S_SAMPLE_RATE;
+static volatile uint32_t i2s_srcNextInRate = I2S_SAMPLE_RATE;
+// 设置的输出采样率; 逐位直通时实际用 44100
+// the output rate asked for; bit-perfect mode uses 44100 regardless
+static volatile uint32_t i2s_rateRequest = I2S_SAMPLE_RATE;
+static volatile uint8_t i2s_srcNextQuality = AUDIO_SRC_HIGH;
+static volatile bool i2s_srcPending = false;
+static volatile bool i2s_srcOverBudget = false;
+// 重采样连续超出预算的块数, 只在发送线程使用
+// blocks in a row the resampler went over budget, transmit task only
+static int i2s_srcOverRun = 0;
+static int32_t i2s_srcOut[I2S_SRC_OUT_FRAMES * 2];
+static SemaphoreHandle_t i2s_srcMutex;
+static volatile uint8_t i2s_ditherMode = AUDIO_DITHER_TPDF;
+static volatile uint8_t i2s_crossfeedLevel = AUDIO_CROSSFEED_OFF;
+
+// 变速: 变调时就是重采样器的输入率按速度缩放; 不变调时在 44100 上做 WSOLA, 第一次用到时在控制线程里分配,
+// 之后只有发送线程使用. 速度都是百分比
+// varispeed: with pitch following speed it is just the resampler's input rate scaled by speed;
+// with pitch kept, WSOLA runs at 44100, allocated on the control thread the first time it is
+// needed and used only by the transmit task afterwards. Speeds are percentages
+static volatile uint16_t i2s_tapeSpeed = 100;
+static volatile uint16_t i2s_stretchSpeed = 100;
+static volatile uint8_t i2s_stretchQuality = AUDIO_WSOLA_MEDIUM;
+static audio_wsola_t i2s_wsola;
+static volatile bool i2s_wsolaReady = false;
+static int32_t i2s_stretchOut[I2S_STRETCH_OUT_FRAMES * 2];
+
+// 处理图由发送线程建好并运行; 统计可以在控制线程读, 清零交给发送线程在缓冲区之间做
+// the processing graph is built and run by the transmit task; its statistics may be read on the
+// control thread, while clearing them is left to the transmit task between buffers
+static audio_graph_t i2s_graph;
+static volatile bool i2s_graphReady = false;
+static volatile bool i2s_graphResetStats = false;
+static volatile bool i2s_graphLate = false;
+
+// 从模式下的外部时钟跟踪, 只在发送线程使用; 环路带宽低到能滤掉一个 DMA 描述符的时间戳抖动
+// external clock tracking in slave mode, transmit task only; the loop bandwidth is low enough to
+// filter out a DMA descriptor's worth of timestamp jitter
+#define I2S_CLOCK_LOOP_HZ 0.1
+#if I2S_CLOCK_SLAVE
+static audio_clock_t i2s_clock;
+#endif
+static volatile uint32_t i2s_clockMismatch = 0;
+
+// 逐位直通和校验: 读盘一方在装缓冲区时算好每个扇区的 CRC, 发送线程校验; 统计的清零交给发送线程在缓冲区之间做
+// bit-perfect mode and its check: the reading side works out each sector's CRC as it fills a
+// buffer and the transmit task checks it; clearing the statistics is left to the transmit task
+// between buffers
+static volatile bool i2s_bitPerfect = false;
+static volatile bool i2s_verifyOn = false;
+static volatile bool i2s_verifyReset = false;
+static uint32_t i2s_bufCrc[I2S_BUF_NUM][I2S_TX_BUFFER_SIZE_FRAME];
+static bool i2s_bufCrcOn[I2S_BUF_NUM];
+static i2s_verify_t i2s_verify;
+static uint64_t i2s_verifyCycles = 0;
+
+// 压缩/限幅参数: 控制线程留一份自己读, 再在序号锁下发布, 发送线程看到序号变化后拷走
+// compressor/limiter settings: the control side keeps a copy of its own to read back and
+// publishes it under the sequence lock, the transmit task copies it once it sees the sequence change
+static audio_dynamics_config_t i2s_dynSettings = {0, 0, -20, 40, 200, 6, 0};
+static audio_dynamics_config_t i2s_dynPublished;
+static uint32_t i2s_dynSeq = 0;
+// 声道矩阵设置, 发布方式同上
+// channel matrix settings, published the same way
+static audio_matrix_config_t i2s_matrixSettings = {0, AUDIO_MATRIX_WIDTH_UNITY, 0, 0, 0, {0}};
+static audio_matrix_config_t i2s_matrixPublished;
+static uint32_t i2s_matrixSeq = 0;
+// 增益衰减峰值保持, 读走后清零, 0.1dB. 用 32 位, 读和清是一次原子交换
+// gain reduction peak hold, cleared when taken, 0.1dB. 32 bits wide, so reading and clearing is
+// one atomic exchange
+static uint32_t i2s_compReduction = 0;
+static uint32_t i2s_limitReduction = 0;
+
+// 只拷贝有效扇区, 缓冲区发完后已清零, 不会把上一次读盘的残留送出去
+// only the valid sectors are copied; buffers are cleared once sent, so nothing left over from an
+// earlier read goes out
+void i2s_fillBuffer(const uint8_t *dat, const i2s_bufPos_t *pos)
+{
+    i2s_readStart = 0;
+    if (__atomic_load_n(&i2s_bufCount, __ATOMIC_ACQUIRE) >= I2S_BUF_NUM)
         return;
 
-    memcpy(i2s_txBuf[i2s_buf_inserI], dat, I2S_TX_BUFFER_LEN);
+    memcpy(i2s_txBuf[i2s_buf_inserI], dat, pos->frames * 2352);
+    i2s_bufCrcOn[i2s_buf_inserI] = i2s_verifyOn;
+    if (i2s_verifyOn)
+        for (int f = 0; f < pos->frames; f++)
+            i2s_bufCrc[i2s_buf_inserI][f] = esp_rom_crc32_le(0, dat + f * 2352, 2352);
+    i2s_bufPos[i2s_buf_inserI] = *pos;
+    i2s_bufGen[i2s_buf_inserI] = i2s_gen;
 
     i2s_buf_inserI = (i2s_buf_inserI + 1) % I2S_BUF_NUM;
 
-    if (i2s_buf_inserI == i2s_buf_sendI)
+    if (__atomic_add_fetch(&i2s_bufCount, 1, __ATOMIC_ACQ_REL) >= i2s_bufDepth)
         i2s_bufsFull = true;
 
     if (i2s_bufsEmpty)
@@ -59,85 +232,325 @@ void i2s_fillBuffer(uint8_t *dat)
     }
 }
 
-void i2s_transmitTask(void *args)
+// 跳转时丢掉还没播的缓冲区, 正在播的那个在下一块停下
+// on a seek, drop the buffers not played yet; the one being played stops at its next block
+void i2s_flush()
+{
+    i2s_gen++;
+    i2s_playPos = I2S_PLAY_POS_NONE;
+}
+
+void i2s_setStreaming(bool on)
+{
+    i2s_streaming = on;
+}
+
+void i2s_readBegin()
+{
+    i2s_readStart = esp_timer_get_time();
+}
+
+void i2s_getXrunStats(i2s_xrunStats_t *stats)
+{
+    *stats = i2s_xrun;
+}
+
+void i2s_setLatencyProfile(uint8_t profile)
+{
+    i2s_profile = (profile < I2S_LATENCY_PROFILES) ? profile : I2S_LATENCY_BALANCED;
+}
+
+uint8_t i2s_getReadSectors()
+{
+    return i2s_profiles[i2s_profile].sectors;
+}
+
+uint32_t i2s_getRingMaxMs()
+{
+    const i2s_profileConfig_t *p = &i2s_profiles[i2s_profile];
+    return p->depthMax * p->sectors * 1000 / 75;
+}
+
+void i2s_probeLatency(uint8_t kind)
+{
+    i2s_probeKind = kind;
+    i2s_probeGen = i2s_gen;
+    i2s_probeBlock = i2s_blockSeq;
+    i2s_probeAt = esp_timer_get_time();
+}
+
+uint32_t i2s_getLatencyMs()
+{
+    return i2s_latencyMs;
+}
+
+bool i2s_getPlayPosition(int8_t *track, uint32_t *frame)
+{
+    uint32_t pos = i2s_playPos;
+    if (pos == I2S_PLAY_POS_NONE)
+        return false;
+
+    *track = (int8_t)(pos >> 24);
+    *frame = pos & 0xffffff;
+    return true;
+}
+
+void i2s_setOutputRate(uint32_t rate, uint8_t quality)
 {
-    if (i2s_buf_sendI == i2s_buf_inserI)
+    if (rate != 48000 && rate != 96000)
+        rate = I2S_SAMPLE_RATE;
+
+    xSemaphoreTake(i2s_srcMutex, portMAX_DELAY);
+    i2s_rateRequest = rate;
+    if (i2s_bitPerfect)
+        rate = I2S_SAMPLE_RATE;
+
+    // 上一次请求还没被取走就直接替换
+    // a request that was never taken is simply replaced
+    if (i2s_srcPending && i2s_srcNextOn)
+        audio_src_deinit(&i2s_srcNext);
+
+    uint32_t inRate = i2s_bitPerfect ? I2S_SAMPLE_RATE : I2S_SAMPLE_RATE * i2s_tapeSpeed / 100;
+    bool on = (rate != inRate);
+    if (on && audio_src_init(&i2s_srcNext, inRate, rate, quality, I2S_BLOCK_FRAMES) != ESP_OK)
     {
-        ESP_ERROR_CHECK(i2s_channel_disable(tx_chan));
-        i2s_bufsEmpty = true;
-        vTaskSuspend(transmitTask);
+        ESP_LOGE("i2s_setOutputRate", "resampler alloc fail, keep 44100");
+        rate = I2S_SAMPLE_RATE;
+        on = false;
     }
 
-    uint8_t *buf;
-    static int downSampleCount = 0;
-    static int64_t oL = 0;
-    static int64_t oR = 0;
-    while (1)
-    {
-        buf = i2s_txBuf[i2s_buf_sendI];
+    i2s_srcNextOn = on;
+    i2s_srcNextRate = rate;
+    i2s_srcNextInRate = inRate;
+    i2s_srcNextQuality = quality;
+    i2s_srcOverBudget = false;
+    i2s_srcPending = true;
+    xSemaphoreGive(i2s_srcMutex);
+}
 
-        // 发给示波器
-        // sent to oscilloscope
-        if (queue_oscilloscope != NULL)
-        {
-            ChannelValue_t oscilloscope;
+bool i2s_takeSrcOverBudget()
+{
+    bool ret = i2s_srcOverBudget;
+    i2s_srcOverBudget = false;
+    return ret;
+}
 
-            for (int i = 0; i < I2S_TX_BUFFER_LEN / 2; i += 2)
-            {
-                oL += ((int16_t *)buf)[i];
-                oR += ((int16_t *)buf)[i + 1];
-                downSampleCount++;
+uint32_t i2s_takeClockMismatch()
+{
+    uint32_t ret = i2s_clockMismatch;
+    i2s_clockMismatch = 0;
+    return ret;
+}
 
-                if (downSampleCount == 20)
-                {
-                    oscilloscope.l = oL / downSampleCount;
-                    oscilloscope.r = oR / downSampleCount;
-                    xQueueSend(queue_oscilloscope, &oscilloscope, 0);
-                    oL = 0;
-                    oR = 0;
-                    downSampleCount = 0;
-                }
-            }
-        }
+// 不变调时 WSOLA 的缓冲区第一次在这里分配, 分配不到就退回变调
+// WSOLA's buffers are allocated here the first time pitch is kept; if that fails it falls back to
+// tape-style speed
+void i2s_setSpeed(uint16_t percent, bool keepPitch, uint8_t quality)
+{
+    if (percent < I2S_SPEED_MIN)
+        percent = I2S_SPEED_MIN;
+    if (percent > I2S_SPEED_MAX)
+        percent = I2S_SPEED_MAX;
 
-        // 音量处理
-        // change volume
-        float scale = volumeScale[cdplayer_playerInfo.volume];
-        int16_t *sample = (int16_t *)(buf);
-        for (int i = 0; i < (I2S_TX_BUFFER_LEN / 2); i++)
+    if (keepPitch && percent != 100 && !i2s_wsolaReady)
+    {
+        if (audio_wsola_init(&i2s_wsola, quality, I2S_BLOCK_FRAMES) == ESP_OK)
+            i2s_wsolaReady = true;
+        else
         {
-            *sample = (int16_t)((float)(*sample) * scale);
-            sample++;
+            ESP_LOGE("i2s_setSpeed", "time-stretch alloc fail, pitch follows speed");
+            keepPitch = false;
         }
+    }
 
-        if (i2s_channel_write(tx_chan, buf, I2S_TX_BUFFER_LEN, NULL, portMAX_DELAY) == ESP_OK)
-        {
-            memset(buf, 0, I2S_TX_BUFFER_LEN);
-            i2s_bufsFull = false;
+    i2s_stretchQuality = quality;
+    i2s_stretchSpeed = keepPitch ? percent : 100;
 
-            i2s_buf_sendI = (i2s_buf_sendI + 1) % I2S_BUF_NUM;
+    uint16_t tape = keepPitch ? 100 : percent;
+    if (tape != i2s_tapeSpeed)
+    {
+        i2s_tapeSpeed = tape;
+        i2s_setOutputRate(i2s_rateRequest, i2s_srcNextQuality);
+    }
+}
 
-            if (i2s_buf_sendI == i2s_buf_inserI)
-            {
-                ESP_LOGW("i2s_transmitTask", "I2S buffer empty");
-                ESP_ERROR_CHECK(i2s_channel_disable(tx_chan));
-                i2s_bufsEmpty = true;
-                vTaskSuspend(transmitTask);
-            }
-        }
-        else
-        {
-            printf("Write Task: i2s write failed\n");
-        }
+// 重采样器按新的状态重建, 变调变速也跟着停下或恢复
+// the resampler is rebuilt for the new state, which also stops or resumes tape-style varispeed
+void i2s_setBitPerfect(bool on)
+{
+    i2s_bitPerfect = on;
+    i2s_setOutputRate(i2s_rateRequest, i2s_srcNextQuality);
+}
+
+void i2s_verifyStart()
+{
+    i2s_verifyReset = true;
+    i2s_verifyOn = true;
+}
+
+void i2s_verifyStop()
+{
+    i2s_verifyOn = false;
+}
+
+void i2s_getVerify(i2s_verify_t *v)
+{
+    *v = i2s_verify;
+}
+
+void i2s_setDither(uint8_t mode)
+{
+    i2s_ditherMode = mode;
+}
+
+void i2s_setCrossfeed(uint8_t level)
+{
+    i2s_crossfeedLevel = (level < AUDIO_CROSSFEED_LEVELS) ? level : AUDIO_CROSSFEED_OFF;
+}
+
+void i2s_setDynamics(const audio_dynamics_config_t *cfg)
+{
+    i2s_dynSettings = *cfg;
+    audio_seqlock_write(&i2s_dynSeq, &i2s_dynPublished, cfg, sizeof(*cfg));
+}
+
+void i2s_getDynamics(audio_dynamics_config_t *cfg)
+{
+    *cfg = i2s_dynSettings;
+}
+
+void i2s_setChannelMatrix(const audio_matrix_config_t *cfg)
+{
+    i2s_matrixSettings = *cfg;
+    audio_seqlock_write(&i2s_matrixSeq, &i2s_matrixPublished, cfg, sizeof(*cfg));
+}
+
+void i2s_getChannelMatrix(audio_matrix_config_t *cfg)
+{
+    *cfg = i2s_matrixSettings;
+}
+
+bool i2s_takeDeadlineMiss()
+{
+    bool ret = i2s_graphLate;
+    i2s_graphLate = false;
+    return ret;
+}
+
+void i2s_logGraph()
+{
+    if (!i2s_graphReady)
+        return;
+    audio_graph_log(&i2s_graph, "i2s_graph");
+    i2s_graphResetStats = true;
+}
+
+void i2s_takeGainReduction(uint16_t *comp, uint16_t *limit)
+{
+    // 音频线程在读和清之间抬高的值不会被清掉
+    // a value the audio thread raises between the read and the clear is not wiped out
+    *comp = (uint16_t)__atomic_exchange_n(&i2s_compReduction, 0, __ATOMIC_RELAXED);
+    *limit = (uint16_t)__atomic_exchange_n(&i2s_limitReduction, 0, __ATOMIC_RELAXED);
+}
+
+// 换上新的重采样器并重设 I2S 时钟 (从模式下时钟在外面, 不用设), 控制线程正在建新的就等下一个缓冲区
+// swap in the new resampler and reclock I2S (in slave mode the clock is external and left alone);
+// if the control thread is still building one, try again on the next buffer
+static void applyOutputRate(audio_src_t *src, bool *srcOn, uint32_t *rate, uint32_t *inRate)
+{
+    if (xSemaphoreTake(i2s_srcMutex, 0) != pdTRUE)
+        return;
+
+    if (*srcOn)
+        audio_src_deinit(src);
+    *srcOn = i2s_srcNextOn;
+    if (*srcOn)
+        *src = i2s_srcNext;
+    *inRate = i2s_srcNextInRate;
+
+    if (i2s_srcNextRate != *rate && !I2S_CLOCK_SLAVE)
+    {
+        i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(i2s_srcNextRate);
+        ESP_ERROR_CHECK(i2s_channel_disable(tx_chan));
+        ESP_ERROR_CHECK(i2s_channel_reconfig_std_clock(tx_chan, &clk_cfg));
+        ESP_ERROR_CHECK(i2s_channel_enable(tx_chan));
     }
+
+    *rate = i2s_srcNextRate;
+    i2s_srcPending = false;
+    xSemaphoreGive(i2s_srcMutex);
+    ESP_LOGI("i2s_transmitTask", "output %ld Hz, resampler quality %d", *rate, i2s_srcNextQuality);
 }
 
-void i2s_init()
+// 改目标深度, 已经填到新深度的话读盘一方马上停下
+// change the target depth; if the ring already holds that much, the reading side stops at once
+static void setDepth(uint8_t depth)
+{
+    i2s_bufDepth = depth;
+    i2s_xrun.depth = depth;
+    i2s_bufsFull = (__atomic_load_n(&i2s_bufCount, __ATOMIC_ACQUIRE) >= depth);
+}
+
+void i2s_holdDepth(bool on)
+{
+    if (on == i2s_depthHeld)
+        return;
+    i2s_depthHeld = on;
+    if (on)
+        setDepth(i2s_profiles[i2s_profileOpen].depthMax);
+}
+
+// 断流结束: 记下时长; 读盘或控制线程跟不上就加深一级, 跳转本来就要重新读, 不算在内
+// an underrun is over: record its duration; if the drive or the control loop could not keep up,
+// deepen the ring by one; a seek has to read again anyway and does not count
+static void xrunEnd(int64_t at, uint8_t cause)
+{
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - at) / 1000);
+    i2s_xrun.count[cause]++;
+    i2s_xrun.lastMs = ms;
+    i2s_xrun.totalMs += ms;
+    if (ms > i2s_xrun.longestMs)
+        i2s_xrun.longestMs = ms;
+    i2s_xrun.lastAt = at;
+    i2s_xrun.lastCause = cause;
+
+    if (cause == I2S_XRUN_SEEK)
+    {
+        ESP_LOGI("i2s_transmitTask", "seek gap %lu ms", ms);
+        return;
+    }
+
+    uint8_t depth = i2s_bufDepth;
+    if (depth < i2s_profiles[i2s_profileOpen].depthMax)
+        setDepth(depth + 1);
+    ESP_LOGW("i2s_transmitTask", "underrun #%lu (%s) %lu ms, depth %u -> %u",
+             i2s_xrun.count[I2S_XRUN_USB] + i2s_xrun.count[I2S_XRUN_CONTROL], i2s_xrunCauseName[cause], ms, depth, i2s_bufDepth);
+}
+
+// 延迟测量结束, at 是效果被听到的时间; 超时的不算 (打点后一直没有播放)
+// the latency probe is done, at being when the effect is heard; timed-out ones are dropped
+// (nothing was played after the mark)
+static void probeEnd(int64_t at)
+{
+    uint32_t ms = (uint32_t)((at - i2s_probeAt) / 1000);
+    uint8_t kind = i2s_probeKind;
+    i2s_probeAt = 0;
+    if (ms > I2S_PROBE_TIMEOUT_MS)
+        return;
+    i2s_latencyMs = ms;
+    ESP_LOGI("i2s_transmitTask", "latency (%s): %lu ms", kind == I2S_PROBE_DRAIN ? "drain" : "next block", ms);
+}
+
+// 按延迟档位的 DMA 设置建 I2S 通道, 建好后未启用
+// creates the I2S channel with the latency profile's DMA settings, left disabled
+static void openChannel(uint32_t rate, uint8_t profile)
 {
-    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_CLOCK_SLAVE ? I2S_ROLE_SLAVE : I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = i2s_profiles[profile].dmaDesc;
+    chan_cfg.dma_frame_num = i2s_profiles[profile].dmaFrames;
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_chan, NULL));
     i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(I2S_SAMPLE_RATE),
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(rate),
         // .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT, I2S_SLOT_MODE_STEREO),
         .slot_cfg = {
             .data_bit_width = I2S_DATA_BIT,
@@ -165,6 +578,550 @@ void i2s_init()
         },
     };
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_chan, &std_cfg));
+    i2s_profileOpen = profile;
+}
+
+#if I2S_CLOCK_SLAVE
+// DMA 从空开始写时调用, 写满之前的写入不等外部时钟, 不算
+// called when DMA starts from empty; writes before it is full do not wait for the external clock
+// and are not counted
+static void clockRestart()
+{
+    const i2s_profileConfig_t *p = &i2s_profiles[i2s_profileOpen];
+    audio_clock_reset(&i2s_clock, p->dmaDesc * p->dmaFrames + I2S_BLOCK_FRAMES, p->dmaFrames);
+}
+
+// 锁定后重采样按实测频率微调, 直通时逐位输出不动它; 差得太远说明设置的输出采样率不对, 报告一次给控制线程
+// once locked, the resampler is trimmed to the measured rate, while pass-through stays
+// bit-perfect and untouched; a rate too far off means the set output rate is wrong, which is
+// reported to the control thread once
+static void clockFollow(audio_src_t *src, bool srcOn, uint32_t inRate, uint32_t outputRate)
+{
+    static uint32_t reported = 0;
+    if (!i2s_clock.locked)
+        return;
+
+    double rate = audio_clock_rate(&i2s_clock);
+    int32_t ppm = (int32_t)lrint((rate / outputRate - 1.0) * 1e6);
+    if (ppm > I2S_CLOCK_MISMATCH_PPM || ppm < -I2S_CLOCK_MISMATCH_PPM)
+    {
+        uint32_t nearest = (rate < 46050) ? 44100 : (rate < 72000) ? 48000 : 96000;
+        if (nearest != reported && nearest != outputRate)
+        {
+            ESP_LOGW("i2s_transmitTask", "external clock %.0f Hz, output rate %lu -> %lu", rate, outputRate, nearest);
+            reported = nearest;
+            i2s_clockMismatch = nearest;
+        }
+        return;
+    }
+    reported = 0;
+
+    if (ppm > I2S_CLOCK_TRIM_PPM)
+        ppm = I2S_CLOCK_TRIM_PPM;
+    if (ppm < -I2S_CLOCK_TRIM_PPM)
+        ppm = -I2S_CLOCK_TRIM_PPM;
+    if (srcOn)
+        audio_src_trim(src, inRate, outputRate, ppm);
+}
+#endif
+
+// 换延迟档位: DMA 设置变了就重建通道, 深度从新档位的上限开始
+// switch latency profile: the channel is rebuilt if the DMA settings change, and the depth starts
+// from the new profile's maximum
+static void applyLatencyProfile(uint8_t profile, uint32_t rate)
+{
+    const i2s_profileConfig_t *now = &i2s_profiles[i2s_profileOpen];
+    const i2s_profileConfig_t *next = &i2s_profiles[profile];
+    if (now->dmaDesc != next->dmaDesc || now->dmaFrames != next->dmaFrames)
+    {
+        ESP_ERROR_CHECK(i2s_channel_disable(tx_chan));
+        ESP_ERROR_CHECK(i2s_del_channel(tx_chan));
+        openChannel(rate, profile);
+        ESP_ERROR_CHECK(i2s_channel_enable(tx_chan));
+#if I2S_CLOCK_SLAVE
+        clockRestart();
+#endif
+    }
+    i2s_profileOpen = profile;
+    setDepth(next->depthMax);
+    ESP_LOGI("i2s_transmitTask", "latency profile %u: DMA %u x %u, %u sectors/read, depth %u~%u",
+             profile, next->dmaDesc, next->dmaFrames, next->sectors, next->depthMin, next->depthMax);
+}
+
+// 处理图的各个环节, 按这个顺序执行
+// stages of the processing graph, run in this order
+enum
+{
+    I2S_STAGE_DEEMPHASIS = 0,
+    I2S_STAGE_EQ,
+    I2S_STAGE_MATRIX,
+    I2S_STAGE_CROSSFEED,
+    I2S_STAGE_STRETCH,
+    I2S_STAGE_SRC,
+    I2S_STAGE_VOLUME,
+    I2S_STAGE_DYNAMICS,
+    I2S_STAGE_METER,
+    I2S_STAGE_DITHER,
+};
+
+static uint32_t stage_deemphasis(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_biquad_processStereo((audio_biquad_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_eq(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_eq_process(samples, frames);
+    return frames;
+}
+
+static uint32_t stage_matrix(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_matrix_process((audio_matrix_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_crossfeed(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_crossfeed_process((audio_crossfeed_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_stretch(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    *out = i2s_stretchOut;
+    return audio_wsola_process((audio_wsola_t *)ctx, samples, frames, i2s_stretchOut, I2S_STRETCH_OUT_FRAMES);
+}
+
+static uint32_t stage_src(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    uint32_t n = audio_src_process((audio_src_t *)ctx, samples, frames, i2s_srcOut, I2S_SRC_OUT_FRAMES);
+    uint32_t cycles = esp_cpu_get_cycle_count() - t0;
+    *out = i2s_srcOut;
+
+    // 连续超出预算就通知控制线程降一档
+    // tell the control thread to drop a quality tier when the budget is exceeded repeatedly
+    i2s_srcOverRun = (cycles > audio_graph_budgetCycles(n, i2s_graph.outRate, I2S_SRC_BUDGET_PERCENT)) ? i2s_srcOverRun + 1 : 0;
+    if (i2s_srcOverRun == 8)
+    {
+        ESP_LOGW("i2s_transmitTask", "resampler over budget (%ld cycles/%ld frames)", cycles, n);
+        i2s_srcOverBudget = true;
+    }
+    return n;
+}
+
+static uint32_t stage_volume(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_gain_processS32((audio_gain_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_dynamics(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_dynamics_t *dynamics = (audio_dynamics_t *)ctx;
+    audio_dynamics_process(dynamics, samples, frames);
+    if (dynamics->compReduction > __atomic_load_n(&i2s_compReduction, __ATOMIC_RELAXED))
+        __atomic_store_n(&i2s_compReduction, dynamics->compReduction, __ATOMIC_RELAXED);
+    if (dynamics->limitReduction > __atomic_load_n(&i2s_limitReduction, __ATOMIC_RELAXED))
+        __atomic_store_n(&i2s_limitReduction, dynamics->limitReduction, __ATOMIC_RELAXED);
+    return frames;
+}
+
+static uint32_t stage_meter(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_meter_process(samples, frames, ((audio_graph_t *)ctx)->outRate, AUDIO_FORMAT_HEADROOM_BITS);
+    return frames;
+}
+
+static uint32_t stage_dither(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_dither_process((audio_dither_t *)ctx, samples, frames);
+    return frames;
+}
+
+// 把交给 I2S 的字还原成 16 位再算 CRC, 和读盘时算的比较; 有低 16 位不是 0 的字也算对不上
+// the words handed to I2S are turned back into 16 bits and their CRC compared with the one worked
+// out at read time; any word with a non-zero bottom half is a mismatch as well
+static void verifyBlock(const int32_t *words, uint32_t crc, uint32_t cycles, int8_t track, uint32_t frame)
+{
+    static int16_t s16[I2S_BLOCK_FRAMES * 2];
+    bool exact = audio_format_wordToS16(words, s16, I2S_BLOCK_FRAMES * 2);
+    if (!exact || esp_rom_crc32_le(0, (const uint8_t *)s16, sizeof(s16)) != crc)
+    {
+        if (i2s_verify.mismatched++ == 0)
+            ESP_LOGW("i2s_transmitTask", "bit-perfect check failed at track %d sector %lu", track + 1, frame);
+    }
+    i2s_verifyCycles += cycles;
+    i2s_verify.sectors++;
+    i2s_verify.cycles = (uint32_t)(i2s_verifyCycles / i2s_verify.sectors);
+}
+
+// 从模式下写入返回的时刻就是外部时钟的节奏
+// in slave mode the moments writes return keep the external clock's pace
+static esp_err_t i2s_write(void *ctx, int32_t *samples, uint32_t frames)
+{
+    esp_err_t err = i2s_channel_write(tx_chan, samples, frames * BYTES_PER_SAMPLE, NULL, portMAX_DELAY);
+#if I2S_CLOCK_SLAVE
+    if (err == ESP_OK)
+        audio_clock_update(&i2s_clock, esp_timer_get_time(), frames);
+#endif
+    return err;
+}
+
+void i2s_transmitTask(void *args)
+{
+    static audio_gain_t volume;
+    audio_gain_init(&volume, volumeGain[cdplayer_playerInfo.volume], I2S_SAMPLE_RATE * I2S_VOLUME_RAMP_MS / 1000);
+
+    static audio_biquad_t deemphasis;
+    static audio_biquad_coef_t deemphasisCoef;
+    static int32_t blockS32[I2S_BLOCK_FRAMES * 2];
+    bool deemphasisOn = false;
+    audio_biquad_designDeemphasis(&deemphasisCoef);
+    audio_biquad_init(&deemphasis, &deemphasisCoef);
+
+    static audio_src_t src;
+    bool srcOn = false;
+    uint32_t outputRate = I2S_SAMPLE_RATE;
+    uint32_t srcInRate = I2S_SAMPLE_RATE;
+#if I2S_CLOCK_SLAVE
+    audio_clock_init(&i2s_clock, outputRate, I2S_CLOCK_LOOP_HZ);
+    clockRestart();
+#endif
+
+    static audio_dither_t dither;
+    audio_dither_init(&dither, i2s_ditherMode, I2S_DAC_BITS);
+
+    // 声道矩阵接在均衡器之后, 交叉馈送之前, 设置改变时和音量一样渐变
+    // the channel matrix follows the EQ and precedes the crossfeed; it slides to new settings
+    // like the volume does
+    // 还没发布过或者正好在写就先用默认设置, 之后每块再取
+    // the default settings are used until something is published or while it is being written,
+    // and taken on a later block
+    static audio_matrix_t matrix;
+    audio_matrix_config_t matrixCfg = {0, AUDIO_MATRIX_WIDTH_UNITY, 0, 0, 0, {0}};
+    uint32_t matrixSeen = 0;
+    audio_seqlock_read(&i2s_matrixSeq, &matrixSeen, &matrixCfg, &i2s_matrixPublished, sizeof(matrixCfg));
+    audio_matrix_init(&matrix, &matrixCfg, I2S_SAMPLE_RATE * I2S_VOLUME_RAMP_MS / 1000);
+
+    // 交叉馈送在 44100 上做, 在重采样之前
+    // crossfeed runs at 44100, ahead of the resampler
+    static audio_crossfeed_t crossfeed;
+    audio_crossfeed_init(&crossfeed, I2S_SAMPLE_RATE, i2s_crossfeedLevel);
+
+    // 压缩/限幅接在重采样之后, 时间常数跟着输出采样率
+    // the compressor/limiter runs after the resampler, so its time constants follow the output rate
+    static audio_dynamics_t dynamics;
+    audio_dynamics_config_t dynCfg = {0, 0, -20, 40, 200, 6, 0};
+    uint32_t dynSeen = 0;
+    audio_seqlock_read(&i2s_dynSeq, &dynSeen, &dynCfg, &i2s_dynPublished, sizeof(dynCfg));
+    audio_dynamics_init(&dynamics, outputRate, &dynCfg);
+
+    // 不变调变速接在交叉馈送之后, 一块的输出可能是 0 帧也可能有几块长, 由处理图分成不超过一块的几段送给重采样
+    // the pitch-keeping time-stretch follows the crossfeed; a block may come out as nothing or as
+    // several blocks' worth, which the graph hands to the resampler in pieces of at most one block
+    uint16_t stretchSpeed = 100;
+    uint8_t stretchQuality = 0xff;
+    uint8_t stretchGen = 0;
+
+    audio_graph_init(&i2s_graph, outputRate, I2S_GRAPH_BUDGET_PERCENT, i2s_write, NULL);
+    audio_graph_add(&i2s_graph, "deemph", stage_deemphasis, &deemphasis, false, 0);
+    audio_graph_add(&i2s_graph, "eq", stage_eq, NULL, false, 0);
+    audio_graph_add(&i2s_graph, "matrix", stage_matrix, &matrix, false, 0);
+    audio_graph_add(&i2s_graph, "crossfeed", stage_crossfeed, &crossfeed, false, 0);
+    audio_graph_add(&i2s_graph, "stretch", stage_stretch, &i2s_wsola, false, I2S_BLOCK_FRAMES);
+    audio_graph_add(&i2s_graph, "src", stage_src, &src, false, I2S_BLOCK_FRAMES);
+    audio_graph_add(&i2s_graph, "volume", stage_volume, &volume, false, 0);
+    audio_graph_add(&i2s_graph, "dynamics", stage_dynamics, &dynamics, false, 0);
+    audio_graph_add(&i2s_graph, "meter", stage_meter, &i2s_graph, true, 0);
+    audio_graph_add(&i2s_graph, "dither", stage_dither, &dither, true, 0);
+    audio_graph_setBypass(&i2s_graph, I2S_STAGE_METER, false);
+    audio_graph_setBypass(&i2s_graph, I2S_STAGE_DITHER, false);
+    audio_graph_setLatency(&i2s_graph, I2S_STAGE_DYNAMICS, AUDIO_DYNAMICS_LOOKAHEAD_US);
+    i2s_graphReady = true;
+
+    if (__atomic_load_n(&i2s_bufCount, __ATOMIC_ACQUIRE) == 0)
+    {
+        ESP_ERROR_CHECK(i2s_channel_disable(tx_chan));
+        i2s_bufsEmpty = true;
+        vTaskSuspend(transmitTask);
+#if I2S_CLOCK_SLAVE
+        clockRestart();
+#endif
+    }
+
+    // 上次断流以来连续播放的扇区数
+    // sectors played in a row since the last underrun
+    uint32_t stableSectors = 0;
+
+    uint8_t *buf;
+    while (1)
+    {
+        buf = i2s_txBuf[i2s_buf_sendI];
+
+        // 输出采样率
+        // output rate
+        if (i2s_srcPending)
+        {
+            uint32_t lastRate = outputRate;
+            applyOutputRate(&src, &srcOn, &outputRate, &srcInRate);
+            i2s_srcOverRun = 0;
+            if (outputRate != lastRate)
+            {
+                audio_dynamics_init(&dynamics, outputRate, &dynamics.cfg);
+                audio_graph_setOutputRate(&i2s_graph, outputRate);
+            }
+            // 重采样的延迟是半个滤波器长度
+            // the resampler's latency is half its filter length
+            audio_graph_setBypass(&i2s_graph, I2S_STAGE_SRC, !srcOn);
+            if (srcOn)
+                audio_graph_setLatency(&i2s_graph, I2S_STAGE_SRC, src.taps * 500000 / srcInRate);
+        }
+
+#if I2S_CLOCK_SLAVE
+        // 外部时钟
+        // external clock
+        clockFollow(&src, srcOn, srcInRate, outputRate);
+#endif
+
+        // 延迟档位
+        // latency profile
+        if (i2s_profile != i2s_profileOpen)
+        {
+            applyLatencyProfile(i2s_profile, outputRate);
+            stableSectors = 0;
+        }
+
+        if (i2s_verifyReset)
+        {
+            i2s_verifyReset = false;
+            memset(&i2s_verify, 0, sizeof(i2s_verify));
+            i2s_verifyCycles = 0;
+        }
+
+        if (i2s_graphResetStats)
+        {
+            i2s_graphResetStats = false;
+            audio_graph_resetStats(&i2s_graph);
+        }
+
+        const i2s_bufPos_t *pos = &i2s_bufPos[i2s_buf_sendI];
+        const uint8_t gen = i2s_bufGen[i2s_buf_sendI];
+
+        if (dither.mode != i2s_ditherMode)
+            audio_dither_init(&dither, i2s_ditherMode, I2S_DAC_BITS);
+
+        // 正好撞上写入就下一块再取, 发送线程不等
+        // running into a write takes it on the next block, the transmit task never waits
+        if (audio_seqlock_read(&i2s_matrixSeq, &matrixSeen, &matrixCfg, &i2s_matrixPublished, sizeof(matrixCfg)))
+            audio_matrix_setConfig(&matrix, &matrixCfg);
+        audio_graph_setBypass(&i2s_graph, I2S_STAGE_MATRIX, audio_matrix_isIdentity(&matrix));
+
+        if (crossfeed.level != i2s_crossfeedLevel)
+            audio_crossfeed_init(&crossfeed, I2S_SAMPLE_RATE, i2s_crossfeedLevel);
+        audio_graph_setBypass(&i2s_graph, I2S_STAGE_CROSSFEED, crossfeed.level == AUDIO_CROSSFEED_OFF);
+
+        if (audio_seqlock_read(&i2s_dynSeq, &dynSeen, &dynCfg, &i2s_dynPublished, sizeof(dynCfg)))
+            audio_dynamics_setConfig(&dynamics, &dynCfg);
+        audio_graph_setBypass(&i2s_graph, I2S_STAGE_DYNAMICS, !audio_dynamics_isActive(&dynamics));
+
+        // 速度或质量改变, 或者跳转之后, 丢掉 WSOLA 里旧的输入
+        // old input in WSOLA is dropped when speed or quality changes, or after a seek
+        if (i2s_wsolaReady)
+        {
+            if (stretchQuality != i2s_stretchQuality)
+            {
+                stretchQuality = i2s_stretchQuality;
+                audio_wsola_setQuality(&i2s_wsola, stretchQuality);
+                // 延迟约为一个步长加搜索范围
+                // latency is about one hop plus the search range
+                audio_graph_setLatency(&i2s_graph, I2S_STAGE_STRETCH, (AUDIO_WSOLA_HOP + i2s_wsola.search) * 1000000ull / I2S_SAMPLE_RATE);
+            }
+            if (stretchSpeed != i2s_stretchSpeed || stretchGen != gen)
+            {
+                if (stretchSpeed == 100 || stretchGen != gen)
+                    audio_wsola_reset(&i2s_wsola);
+                stretchSpeed = i2s_stretchSpeed;
+                stretchGen = gen;
+                audio_wsola_setSpeed(&i2s_wsola, (uint32_t)stretchSpeed * AUDIO_WSOLA_SPEED_UNITY / 100);
+            }
+        }
+        audio_graph_setBypass(&i2s_graph, I2S_STAGE_STRETCH, stretchSpeed == 100);
+
+        // 去加重, 均衡器, 声道矩阵, 交叉馈送, 变速, 重采样, 音量和压缩/限幅都在内部 32 位格式里做, 最后抖动到 DAC 字长, 按块读取音量并写入,
+        // 块内逐帧渐变; 都不需要且 0dB 不在渐变时 16 位数据直接放进 32 位字, 输出与光盘数据逐位一致
+        // de-emphasis, EQ, channel matrix, crossfeed, time-stretch, resampling, volume and compressor/limiter all run in the
+        // internal 32-bit format, then get dithered to the DAC word length; volume is read and the
+        // data written block by block, ramping per frame inside a block. With nothing active, at 0dB and no
+        // ramp pending, the 16-bit data goes straight into 32-bit words, so the output is bit-perfect
+        // 一块正好一个扇区, 跨音轨的缓冲区在块之间换音轨
+        // a block is exactly one sector, so a buffer crossing a track boundary changes track between blocks
+        // 逐位直通要等不需要重采样的设置换上之后
+        // bit-perfect output waits until settings without resampling are in place
+        const bool bitPerfect = i2s_bitPerfect && !srcOn;
+        const bool verify = i2s_verifyOn && i2s_bufCrcOn[i2s_buf_sendI];
+
+        esp_err_t err = ESP_OK;
+        for (int b = 0; b < pos->frames && gen == i2s_gen && err == ESP_OK; b++)
+        {
+            int16_t *block = (int16_t *)buf + b * I2S_BLOCK_FRAMES * 2;
+            uint32_t seq = ++i2s_blockSeq;
+
+            bool nextTrack = (b >= pos->nextAt);
+
+            // 去加重, 跟随每个扇区所属音轨的标志, 打开时清掉旧状态
+            // de-emphasis follows the flag of the track each sector belongs to; stale state is cleared
+            // when it turns on
+            bool preEmphasis = !bitPerfect && ((pos->preEmphasis >> nextTrack) & 1);
+            if (preEmphasis && !deemphasisOn)
+                audio_biquad_reset(&deemphasis);
+            deemphasisOn = preEmphasis;
+            audio_graph_setBypass(&i2s_graph, I2S_STAGE_DEEMPHASIS, !deemphasisOn);
+
+            // 频谱分析和示波器只取光盘原始数据, 不等待
+            // the spectrum analyzer and the oscilloscope only take the disc data, never wait
+            audio_spectrum_capture(block, I2S_BLOCK_FRAMES);
+            audio_scope_capture(block, I2S_BLOCK_FRAMES);
+
+            audio_graph_setBypass(&i2s_graph, I2S_STAGE_EQ, !audio_eq_isActive());
+            // 音量乘上这个扇区所属音轨的响度增益
+            // volume times the loudness gain of the track this sector belongs to
+            audio_gain_setTarget(&volume, (int32_t)(((int64_t)volumeGain[cdplayer_playerInfo.volume] * pos->gain[nextTrack]) >> 12));
+            audio_graph_setBypass(&i2s_graph, I2S_STAGE_VOLUME, audio_gain_isUnity(&volume));
+            const bool graphOn = !bitPerfect && audio_graph_isActive(&i2s_graph);
+            // 只有音量要处理 (最常见的: 关小了音量, 别的都没开) 且不在渐变时, 转换, 音量和抖动合成一遍, 不走处理图,
+            // 这些块不计入处理图的统计
+            // with only the volume to apply (the usual case: volume turned down, nothing else on) and
+            // no ramp, conversion, volume and dither run as a single pass outside the graph; these
+            // blocks are not counted in the graph's statistics
+            if (graphOn && i2s_graph.activeCount == 1 && !i2s_graph.stage[I2S_STAGE_VOLUME].bypass &&
+                volume.remain == 0 && volume.target <= AUDIO_DITHER_S16_GAIN_MAX)
+            {
+                if (verify)
+                    i2s_verify.processed++;
+                audio_dither_processS16(&dither, volume.target, block, blockS32, I2S_BLOCK_FRAMES);
+                audio_meter_process(blockS32, I2S_BLOCK_FRAMES, I2S_SAMPLE_RATE, 0);
+                err = i2s_write(NULL, blockS32, I2S_BLOCK_FRAMES);
+            }
+            else if (graphOn)
+            {
+                if (verify)
+                    i2s_verify.processed++;
+                audio_format_s16ToS32(block, blockS32, I2S_BLOCK_FRAMES * 2);
+                err = audio_graph_process(&i2s_graph, blockS32, I2S_BLOCK_FRAMES);
+
+                // 连续超出时限就报告控制线程
+                // report to the control thread when the deadline is missed repeatedly
+                if (i2s_graph.lateRun == 8)
+                {
+                    ESP_LOGW("i2s_transmitTask", "processing over deadline (%u.%u%% of %u%%)",
+                             i2s_graph.maxLoad / 10, i2s_graph.maxLoad % 10, I2S_GRAPH_BUDGET_PERCENT);
+                    i2s_graphLate = true;
+                }
+            }
+            else
+            {
+                uint32_t t0 = esp_cpu_get_cycle_count();
+                audio_format_s16ToWord(block, blockS32, I2S_BLOCK_FRAMES * 2);
+                audio_meter_process(blockS32, I2S_BLOCK_FRAMES, I2S_SAMPLE_RATE, 0);
+                if (verify)
+                    verifyBlock(blockS32, i2s_bufCrc[i2s_buf_sendI][b], esp_cpu_get_cycle_count() - t0,
+                                nextTrack ? pos->track + 1 : pos->track, nextTrack ? (uint32_t)(b - pos->nextAt) : pos->frame + b);
+                err = i2s_write(NULL, blockS32, I2S_BLOCK_FRAMES);
+            }
+
+            // 写进 DMA 后, 前面排着的 DMA 数据播完才听得到
+            // once written to DMA it is heard after the DMA data queued ahead of it has played
+            if (err == ESP_OK && i2s_probeAt && i2s_probeKind == I2S_PROBE_NEXT_BLOCK && seq > i2s_probeBlock && gen == i2s_probeGen)
+            {
+                const i2s_profileConfig_t *p = &i2s_profiles[i2s_profileOpen];
+                probeEnd(esp_timer_get_time() + (int64_t)p->dmaDesc * p->dmaFrames * 1000000 / outputRate);
+            }
+
+            if (err == ESP_OK && gen == i2s_gen)
+            {
+                if (nextTrack)
+                    i2s_playPos = ((uint32_t)(pos->track + 1) << 24) | (b - pos->nextAt + 1);
+                else
+                    i2s_playPos = ((uint32_t)pos->track << 24) | (pos->frame + b + 1);
+            }
+        }
+
+        if (err == ESP_OK)
+        {
+            memset(buf, 0, I2S_TX_BUFFER_LEN);
+            i2s_buf_sendI = (i2s_buf_sendI + 1) % I2S_BUF_NUM;
+            uint8_t count = __atomic_sub_fetch(&i2s_bufCount, 1, __ATOMIC_ACQ_REL);
+            if (count < i2s_bufDepth)
+                i2s_bufsFull = false;
+
+            // 一直稳定就变浅一级, 换来更短的延迟
+            // stable for long enough: one level shallower, for less latency
+            if (i2s_streaming && !i2s_depthHeld && (stableSectors += pos->frames) >= I2S_XRUN_STABLE_SECTORS)
+            {
+                stableSectors = 0;
+                if (i2s_bufDepth > i2s_profiles[i2s_profileOpen].depthMin)
+                {
+                    setDepth(i2s_bufDepth - 1);
+                    ESP_LOGI("i2s_transmitTask", "stable, depth -> %u", i2s_bufDepth);
+                }
+            }
+
+            if (count == 0)
+            {
+                // 读盘一方还在送数据时排空就是断流; 原因按当时的情况分: 刚跳转过, 正在读盘, 还是没在读
+                // draining while the reading side still sends data is an underrun; its cause depends on
+                // the moment: just after a seek, in the middle of a disc read, or not reading at all
+                int64_t xrunAt = 0;
+                uint8_t cause = I2S_XRUN_USB;
+                if (i2s_streaming)
+                {
+                    xrunAt = esp_timer_get_time();
+                    if (gen != i2s_gen)
+                        cause = I2S_XRUN_SEEK;
+                    else if (i2s_readStart == 0)
+                        cause = I2S_XRUN_CONTROL;
+                }
+                else
+                {
+                    ESP_LOGI("i2s_transmitTask", "I2S buffer empty");
+                    // 停下就是听到暂停的时候
+                    // stopping is when the pause is heard
+                    if (i2s_probeAt && i2s_probeKind == I2S_PROBE_DRAIN)
+                        probeEnd(esp_timer_get_time());
+                }
+
+                ESP_ERROR_CHECK(i2s_channel_disable(tx_chan));
+                i2s_bufsEmpty = true;
+                vTaskSuspend(transmitTask);
+#if I2S_CLOCK_SLAVE
+                clockRestart();
+#endif
+
+                if (xrunAt)
+                {
+                    xrunEnd(xrunAt, cause);
+                    if (cause != I2S_XRUN_SEEK)
+                        stableSectors = 0;
+                }
+            }
+        }
+        else
+        {
+            printf("Write Task: i2s write failed\n");
+        }
+    }
+}
+
+void i2s_init()
+{
+    audio_eq_init(I2S_SAMPLE_RATE);
+    audio_spectrum_init();
+    i2s_srcMutex = xSemaphoreCreateMutex();
+
+    openChannel(I2S_SAMPLE_RATE, i2s_profile);
     ESP_ERROR_CHECK(i2s_channel_enable(tx_chan));
 
     BaseType_t taskCreatRet;
@@ -1,14 +1,213 @@
 #ifndef __I2S_H_
 #define __I2S_H_
 
+#include "audio_dynamics.h"
+#include "audio_matrix.h"
+
 #define I2S_BUF_NUM 5
 #define I2S_TX_BUFFER_SIZE_FRAME (8)
 #define I2S_TX_BUFFER_LEN (2352 * I2S_TX_BUFFER_SIZE_FRAME)
+#define I2S_TX_BUFFER_FRAMES (I2S_TX_BUFFER_LEN / 4)
+
+// 环形缓冲区的目标深度在延迟档位给的范围内自动调整: 读盘或控制线程跟不上造成断流时加深一级,
+// 连续播放 I2S_XRUN_STABLE_MS 没有断流就变浅一级. I2S_BUF_NUM 个缓冲区是静态分配的, 就是内存预算
+// the ring's target depth adapts within the range the latency profile gives: an underrun caused
+// by the drive or the control loop deepens it by one, and I2S_XRUN_STABLE_MS of playback without
+// one makes it one shallower. The I2S_BUF_NUM buffers are allocated statically, so they are the
+// memory budget
+#define I2S_XRUN_STABLE_MS 60000
+
+// 延迟档位: 一起决定 DMA 描述符个数和长度, 每次读盘的扇区数 (即每个缓冲区装多少) 和缓冲区深度范围.
+// 音量等处理在 DMA 之前生效, 只等 DMA; 跳转要重新读盘; 暂停要等缓冲区播完.
+// 下面的毫秒数是按 44100 从这些长度算出来的, 不是测量值; 实际的端到端延迟用 i2s_probeLatency() 测,
+// 还没有在硬件上测过各档
+// latency profiles: each sets the DMA descriptor count and length, the sectors per disc read
+// (i.e. how much each buffer holds) and the ring depth range together. Volume and other
+// processing take effect ahead of DMA, so they only wait for DMA; a skip has to read again; a
+// pause waits for the ring to play out. The milliseconds below are worked out from these sizes
+// at 44100, not measured; the end-to-end latency is what i2s_probeLatency() measures, and the
+// profiles have not been measured on hardware yet
+typedef enum
+{
+    I2S_LATENCY_LOW = 0, // DMA 3 x 240 (16ms), 2 扇区, 深度 2~4 (53~107ms) DMA 3 x 240 (16ms), 2 sectors, depth 2~4 (53~107ms)
+    I2S_LATENCY_BALANCED, // DMA 6 x 240 (33ms), 8 扇区, 深度 2~5 (213~533ms) DMA 6 x 240 (33ms), 8 sectors, depth 2~5 (213~533ms)
+    I2S_LATENCY_ROBUST,   // DMA 8 x 480 (87ms), 8 扇区, 深度 4~5 (427~533ms) DMA 8 x 480 (87ms), 8 sectors, depth 4~5 (427~533ms)
+    I2S_LATENCY_PROFILES,
+} i2s_latencyProfile_t;
+
+// 端到端延迟测量: 控制线程处理完按键时打点, 发送线程在效果真正送出时算时长
+// end-to-end latency probe: the control thread marks the moment it handled a button, the transmit
+// task works out the time once the effect actually goes out
+typedef enum
+{
+    I2S_PROBE_NEXT_BLOCK = 0, // 打点之后开始的第一块 (音量, 跳转, 继续播放) 听到为止 until the first block begun after the mark is heard (volume, skip, resume)
+    I2S_PROBE_DRAIN,          // 缓冲区播完停下为止 (暂停) until the ring has played out and stopped (pause)
+} i2s_probe_t;
+
+// 音量改变时的渐变时长
+// how long a volume change takes to slide to the new level
+#define I2S_VOLUME_RAMP_MS 20
+
+// 输出采样率: 44100 直通, 48000/96000 经过重采样
+// output rate: 44100 passes through, 48000/96000 go through the resampler
+#define I2S_OUTPUT_RATE_MAX 96000
+// 重采样在 core 1 上最多占用的 CPU 百分比, 超出后由 i2s_takeSrcOverBudget() 报告
+// CPU share the resampler may use on core 1; going over is reported by i2s_takeSrcOverBudget()
+#define I2S_SRC_BUDGET_PERCENT 30
+// 整个处理图可用的 CPU 百分比 (按输出音频的时长算), 连续超出由 i2s_takeDeadlineMiss() 报告
+// CPU share the whole processing graph may use (against the duration of the audio it outputs);
+// going over repeatedly is reported by i2s_takeDeadlineMiss()
+#define I2S_GRAPH_BUDGET_PERCENT 80
+
+// I2S 时钟方向: 0 由 ESP32 产生 LRCK/BCK; 1 由外部 (比如原电路里的 DIT4096) 产生, ESP32 工作在从模式.
+// 从模式下输出采样率就是外部时钟的频率, 这边改不了: 发送线程测出它的实际频率, 重采样时按实测微调比例,
+// 和设置的输出采样率差得太远时由 i2s_takeClockMismatch() 报告. 读盘按缓冲区空出来的速度进行, 缓冲区本身不会因为时钟漂移而溢出或放空
+// I2S clock direction: 0 has the ESP32 generate LRCK/BCK; 1 takes them from outside (such as the
+// DIT4096 in the original circuit) with the ESP32 as slave. In slave mode the output rate is
+// whatever the external clock runs at and cannot be set from here: the transmit task measures the
+// actual rate and trims the resampler ratio to it, and a clock too far from the set output rate
+// is reported by i2s_takeClockMismatch(). Disc reads run as buffers free up, so the ring itself
+// never over- or underfills from clock drift
+#ifndef I2S_CLOCK_SLAVE
+#define I2S_CLOCK_SLAVE 0
+#endif
+// 重采样比例跟着外部时钟微调的范围; 超出 I2S_CLOCK_MISMATCH_PPM 就不是晶振误差, 是外部时钟不在这个采样率上
+// how far the resampler ratio is trimmed to follow the external clock; beyond
+// I2S_CLOCK_MISMATCH_PPM it is no crystal tolerance but an external clock at another rate
+#define I2S_CLOCK_TRIM_PPM 1000
+#define I2S_CLOCK_MISMATCH_PPM 20000
+
+// 变速范围, 百分比
+// varispeed range, percent
+#define I2S_SPEED_MIN 50
+#define I2S_SPEED_MAX 200
+
+// DAC 字长, 处理过的信号按这个位数抖动量化, I2S 总是发 32 位字
+// DAC word length: processed audio is dithered to this many bits; I2S always sends 32-bit words
+#define I2S_DAC_BITS 24
+
+// 缓冲区在光盘上的位置 (扇区 = CD 帧, 2352 字节), 读盘跨过音轨边界时 nextAt 记下一音轨从第几个扇区开始
+// where a buffer sits on the disc (sector = CD frame, 2352 bytes); when a read crosses a track
+// boundary, nextAt is the sector the next track starts at
+typedef struct
+{
+    int8_t track;        // 开头所在音轨 track at the start of the buffer
+    uint8_t frames;      // 有效扇区数, 光盘末尾会不足 valid sectors, fewer at the end of the disc
+    uint8_t nextAt;      // 下一音轨开始的扇区, 不跨音轨时等于 frames; sector the next track starts at, == frames when none
+    uint8_t preEmphasis; // bit0 本音轨, bit1 下一音轨 bit0 this track, bit1 next track
+    uint32_t frame;      // 开头在音轨内的扇区号 sector within the track at the start
+    uint16_t gain[2];    // 本音轨/下一音轨的响度增益, Q12 loudness gain of this/next track, Q12
+} i2s_bufPos_t;
+
+// 音轨响度增益 Q12, 4096 = 0dB, 最大 +12dB
+// per-track loudness gain in Q12, 4096 = 0dB, at most +12dB
+#define I2S_TRACK_GAIN_UNITY 4096
+#define I2S_TRACK_GAIN_MAX (4 * I2S_TRACK_GAIN_UNITY)
+
+// 断流原因 underrun causes
+typedef enum
+{
+    I2S_XRUN_USB = 0, // 正在读盘, 光驱或 USB 太慢 a disc read was in progress, the drive or USB was too slow
+    I2S_XRUN_CONTROL, // 控制线程没在读盘 the control loop was not reading
+    I2S_XRUN_SEEK,    // 跳转后重新读盘 reading again after a seek
+    I2S_XRUN_CAUSES,
+} i2s_xrunCause_t;
+
+typedef struct
+{
+    uint32_t count[I2S_XRUN_CAUSES];
+    uint32_t lastMs;    // 最近一次断流的时长 duration of the last underrun
+    uint32_t longestMs;
+    uint32_t totalMs;
+    int64_t lastAt;     // 最近一次断流开始的时间, esp_timer 微秒 when the last one began, esp_timer us
+    uint8_t lastCause;
+    uint8_t depth;      // 当前目标深度 current target depth
+} i2s_xrunStats_t;
+
+// 逐位一致校验的结果. 控制线程可以随时读, 最多差一块
+// results of the bit-perfect check; the control thread may read them at any time, at most a block stale
+typedef struct
+{
+    uint32_t sectors;    // 校验过的扇区 sectors checked
+    uint32_t mismatched; // 和光盘数据对不上的 sectors that did not match the disc data
+    uint32_t processed;  // 经过处理图的, 本来就不是逐位一致 sectors run through the graph, not meant to match
+    uint32_t cycles;     // 直通路径每扇区平均周期数, 不含等 DMA average cycles per sector on the pass-through path, not counting the wait for DMA
+} i2s_verify_t;
 
 extern uint8_t i2s_txBuf[I2S_BUF_NUM][I2S_TX_BUFFER_LEN];
 extern volatile bool i2s_bufsFull;
+extern volatile bool i2s_bufsEmpty;
 
 void i2s_init();
-void i2s_fillBuffer(uint8_t *dat);
+void i2s_fillBuffer(const uint8_t *dat, const i2s_bufPos_t *pos);
+void i2s_flush();
+bool i2s_getPlayPosition(int8_t *track, uint32_t *frame);
+// 读盘一方是否还要送数据 (播放中, 没到光盘末尾); 不送数据时缓冲区排空不算断流
+// whether the reading side still means to send data (playing, not past the end of the disc);
+// the ring draining while it does not is not an underrun
+void i2s_setStreaming(bool on);
+// 开始读一次盘, 到 i2s_fillBuffer() 为止算读盘中
+// a disc read begins; it counts as in progress until i2s_fillBuffer()
+void i2s_readBegin();
+void i2s_getXrunStats(i2s_xrunStats_t *stats);
+// 在两个缓冲区之间生效, DMA 设置变了就重建 I2S 通道
+// takes effect between buffers; the I2S channel is rebuilt when the DMA settings change
+void i2s_setLatencyProfile(uint8_t profile);
+// 当前档位下每次读盘的扇区数
+// sectors per disc read in the current profile
+uint8_t i2s_getReadSectors();
+// 当前档位下环形缓冲区最深时装得下的时长, ms
+// how long the ring holds at its deepest in the current profile, ms
+uint32_t i2s_getRingMaxMs();
+// 打开时环形缓冲区保持在档位的最深处, 不因为一直稳定而变浅; 交叉淡化要来回寻道时用
+// while on, the ring stays at the profile's deepest and does not get shallower for being stable;
+// for crossfades, which seek back and forth
+void i2s_holdDepth(bool on);
+void i2s_probeLatency(uint8_t kind);
+// 最近一次测到的端到端延迟, ms
+// the last end-to-end latency measured, ms
+uint32_t i2s_getLatencyMs();
+void i2s_setOutputRate(uint32_t rate, uint8_t quality);
+// 逐位直通: 去加重, 均衡, 声道矩阵, 变速, 重采样, 音量和压缩都不做, 光盘数据原样放进 32 位字交给 I2S,
+// 输出固定 44100; 关掉后恢复原来的输出采样率和速度
+// bit-perfect pass-through: no de-emphasis, EQ, channel matrix, varispeed, resampling, volume or
+// dynamics; disc data goes into 32-bit words untouched and is handed to I2S at a fixed 44100.
+// Turning it off restores the output rate and speed set before
+void i2s_setBitPerfect(bool on);
+// 逐位一致校验: 开始后读盘时给每个扇区算 CRC32, 发送时把交给 i2s_channel_write 的数据还原成 16 位再算一次比较,
+// 同时统计直通路径的开销. 开始时统计清零
+// bit-perfect check: once started, each sector gets a CRC32 as it is read from the disc, and the
+// data handed to i2s_channel_write is turned back into 16 bits and checked against it, while the
+// cost of the pass-through path is measured. Starting clears the statistics
+void i2s_verifyStart();
+void i2s_verifyStop();
+void i2s_getVerify(i2s_verify_t *v);
+bool i2s_takeSrcOverBudget();
+// 从模式下测到的外部时钟和输出采样率对不上时, 返回最接近它的输出采样率, 否则返回 0
+// in slave mode, when the measured external clock does not match the output rate, returns the
+// output rate closest to it, otherwise 0
+uint32_t i2s_takeClockMismatch();
+bool i2s_takeDeadlineMiss();
+// 打印处理图各环节的调用次数, 平均/最大周期数, 误时次数和延迟, 然后清零统计
+// logs call counts, average/peak cycles per stage, deadline misses and latency of the
+// processing graph, then clears the statistics
+void i2s_logGraph();
+// 播放速度百分比; keepPitch 时用 WSOLA 保持音高 (quality 为 audio_wsola_quality_t), 否则音高跟着变.
+// 读盘按缓冲区空出来的速度进行, 自然跟着速度走
+// playback speed in percent; with keepPitch WSOLA keeps the pitch (quality is an
+// audio_wsola_quality_t), otherwise pitch follows speed. Disc reads run as buffers free up, so
+// they follow the speed by themselves
+void i2s_setSpeed(uint16_t percent, bool keepPitch, uint8_t quality);
+void i2s_setDither(uint8_t mode);
+void i2s_setCrossfeed(uint8_t level);
+// 平衡, 单声道, 左右互换, 反相和立体声宽度, 在两个缓冲区之间生效并渐变过去
+// balance, mono, swap, polarity and stereo width; takes effect between buffers and slides over
+void i2s_setChannelMatrix(const audio_matrix_config_t *cfg);
+void i2s_getChannelMatrix(audio_matrix_config_t *cfg);
+void i2s_setDynamics(const audio_dynamics_config_t *cfg);
+void i2s_getDynamics(audio_dynamics_config_t *cfg);
+// 上次读取以来压缩器/限幅器最大的增益衰减, 0.1dB, 供电平表显示
+// largest compressor/limiter gain reduction since the last call, 0.1dB, for metering
+void i2s_takeGainReduction(uint16_t *comp, uint16_t *limit);
 
 #endif
@@ -18,33 +18,127 @@
 #define LCD_SCLK PIN_SPI_CLK
 #define LCD_MOSI PIN_SPI_MOSI
 
+// 传输的 user 字段: bit0 是 DC 电平, bit1 表示一次刷新的最后一笔
+// the user field of a transaction: bit0 is the DC level, bit1 marks the last one of a flush
+#define LCD_TRANS_DATA 1
+#define LCD_TRANS_LAST 2
+// 一次刷新: 列地址, 行地址, 写显存三条命令各带参数, 最后是像素
+// one flush: column address, row address and memory write, each command with its parameters,
+// then the pixels
+#define LCD_FLUSH_TRANS 6
+
 spi_device_handle_t spiHandle;
 uint32_t blDuty = 0;
 
-void SPI_WriteByte(uint8_t *TxData, int len)
+static spi_transaction_t lcd_flushTrans[LCD_FLUSH_TRANS];
+static int lcd_inflight = 0;
+static lcd_flushDone_t lcd_flushDone = NULL;
+static void *lcd_flushArg = NULL;
+
+// 每笔传输开始前按 user 设置 DC, 排队和轮询的传输都会经过这里
+// sets DC from user before each transaction; queued and polled ones both come through here
+static void lcd_spiPreTransfer(spi_transaction_t *t)
+{
+    gpio_set_level(LCD_DC, (uintptr_t)t->user & LCD_TRANS_DATA);
+}
+
+// 中断里调用; SPI 中断不在 IRAM (CONFIG_SPI_MASTER_ISR_IN_IRAM=n), 回调可以在 flash 里
+// called in the interrupt; the SPI interrupt is not in IRAM (CONFIG_SPI_MASTER_ISR_IN_IRAM=n), so
+// the callback may live in flash
+static void lcd_spiPostTransfer(spi_transaction_t *t)
+{
+    if (((uintptr_t)t->user & LCD_TRANS_LAST) && lcd_flushDone)
+        lcd_flushDone(lcd_flushArg);
+}
+
+void lcd_waitFlush()
+{
+    spi_transaction_t *t;
+    while (lcd_inflight > 0)
+    {
+        spi_device_get_trans_result(spiHandle, &t, portMAX_DELAY);
+        lcd_inflight--;
+    }
+}
+
+// 轮询传输不能和还在队列里的传输交错, 先等上一次刷新收尾
+// polled transactions must not interleave with queued ones, so the last flush is finished first
+void SPI_WriteByte(uint8_t *TxData, int len, int dc)
 {
+    lcd_waitFlush();
     spi_transaction_t t = {
         .length = len * 8,
         .tx_buffer = TxData,
+        .user = (void *)(uintptr_t)dc,
     };
     spi_device_polling_transmit(spiHandle, &t);
 }
 
 void lcd_write_cmd(uint8_t cmd)
 {
-    gpio_set_level(LCD_DC, 0);
-    SPI_WriteByte(&cmd, 1);
+    SPI_WriteByte(&cmd, 1, 0);
 }
 
 void lcd_write_data(uint8_t dat)
 {
-    gpio_set_level(LCD_DC, 1);
-    SPI_WriteByte(&dat, 1);
+    SPI_WriteByte(&dat, 1, LCD_TRANS_DATA);
 }
 void lcd_write_data_batch(uint8_t *dat, int len)
 {
-    gpio_set_level(LCD_DC, 1);
-    SPI_WriteByte(dat, len);
+    SPI_WriteByte(dat, len, LCD_TRANS_DATA);
+}
+
+static void queueTrans(spi_transaction_t *t)
+{
+    spi_device_queue_trans(spiHandle, t, portMAX_DELAY);
+    lcd_inflight++;
+}
+
+static void queueCmd(spi_transaction_t *t, uint8_t cmd)
+{
+    memset(t, 0, sizeof(spi_transaction_t));
+    t->length = 8;
+    t->flags = SPI_TRANS_USE_TXDATA;
+    t->tx_data[0] = cmd;
+    queueTrans(t);
+}
+
+static void queueAddr(spi_transaction_t *t, uint16_t a1, uint16_t a2)
+{
+    memset(t, 0, sizeof(spi_transaction_t));
+    t->length = 32;
+    t->flags = SPI_TRANS_USE_TXDATA;
+    t->user = (void *)LCD_TRANS_DATA;
+    t->tx_data[0] = a1 >> 8;
+    t->tx_data[1] = a1 & 0xff;
+    t->tx_data[2] = a2 >> 8;
+    t->tx_data[3] = a2 & 0xff;
+    queueTrans(t);
+}
+
+// 窗口命令和像素一起排进队列就返回, 像素由 DMA 发送, 发完在中断里调用 done;
+// pixels 在 done 之前必须保持不变, 且要在 DMA 能访问的内存里
+// queues the window commands and the pixels and returns; DMA sends the pixels and done is called
+// in the interrupt once they are out. pixels must stay untouched until then and be DMA capable
+void lcd_flushAsync(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const void *pixels, uint32_t len,
+                    lcd_flushDone_t done, void *arg)
+{
+    lcd_waitFlush();
+    lcd_flushDone = done;
+    lcd_flushArg = arg;
+
+    queueCmd(&lcd_flushTrans[0], 0x2a);
+    queueAddr(&lcd_flushTrans[1], x1, x2);
+    queueCmd(&lcd_flushTrans[2], 0x2b);
+    queueAddr(&lcd_flushTrans[3], y1 + 80, y2 + 80);
+    queueCmd(&lcd_flushTrans[4], 0x2C); // Memory Write
+
+    spi_transaction_t *t = &lcd_flushTrans[5];
+    memset(t, 0, sizeof(spi_transaction_t));
+    t->length = len * 8;
+    t->tx_buffer = pixels;
+    t->user = (void *)(LCD_TRANS_DATA | LCD_TRANS_LAST);
+    queueTrans(t);
 }
 
 void lcd_set_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
@@ -94,7 +188,7 @@ void lcd_init(void)
         .sclk_io_num = LCD_SCLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = SOC_SPI_MAXIMUM_BUFFER_SIZE,
+        .max_transfer_sz = LCD_W * LCD_DRAW_ROWS * 2, // 一次刷新的像素一笔发完 a flush's pixels in one transaction
     };
     spi_bus_initialize(SPI2_HOST, &buscfg, SPI_DMA_CH_AUTO);
 
@@ -107,8 +201,10 @@ void lcd_init(void)
         .clock_speed_hz = SPI_MASTER_FREQ_40M, // 40MHz
         .mode = 0,                             // SPI mode 0
         .spics_io_num = LCD_CS,
-        .queue_size = 7,
+        .queue_size = LCD_FLUSH_TRANS,
         .flags = SPI_DEVICE_HALFDUPLEX,
+        .pre_cb = lcd_spiPreTransfer,
+        .post_cb = lcd_spiPostTransfer,
     };
     spi_bus_add_device(SPI2_HOST, &devcfg, &spiHandle);
 
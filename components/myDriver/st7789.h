@@ -3,9 +3,17 @@
 
 #define LCD_W 240
 #define LCD_H 240
+// LVGL 绘制缓冲区的行数, 也决定一笔 DMA 传输的最大长度
+// rows per LVGL draw buffer, which also sets the longest DMA transaction
+#define LCD_DRAW_ROWS 40
+
+typedef void (*lcd_flushDone_t)(void *arg);
 
 void lcd_set_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
 void lcd_write_data_batch(uint8_t *dat, int len);
+void lcd_flushAsync(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const void *pixels, uint32_t len,
+                    lcd_flushDone_t done, void *arg);
+void lcd_waitFlush();
 void lcd_fill(uint32_t color);
 void lcd_drawPoint(uint16_t x, uint16_t y, uint32_t color);
 
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "audio_format.h"
+#include "audio_wsola.h"
+
+// 不变调变速每个质量在最慢, 原速附近和最快三种速度下每个输出帧的耗时, 输入按扇区送进去, 和发送线程一样;
+// 主机上 1ns 算一个周期 (1GHz), 板子上的数字由 audio_bench 报告
+// pitch-keeping varispeed: time per output frame for each quality at the slowest speed, near
+// normal speed and the fastest, with input going in sector by sector as on the transmit task; on
+// a host 1ns counts as one cycle (1GHz), the board's figures come from audio_bench
+
+#define BLOCK_FRAMES 588
+#define BLOCKS 750
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int main()
+{
+    static const char *names[] = {"low", "medium", "high"};
+    static const uint32_t speeds[] = {AUDIO_WSOLA_SPEED_MIN, AUDIO_WSOLA_SPEED_UNITY * 11 / 10, AUDIO_WSOLA_SPEED_MAX};
+    static int16_t in16[BLOCK_FRAMES * 2];
+    static int32_t in[BLOCK_FRAMES * 2];
+    static int32_t out[AUDIO_WSOLA_MAX_OUT(BLOCK_FRAMES) * 2];
+    audio_wsola_t w;
+
+    if (audio_wsola_init(&w, AUDIO_WSOLA_LOW, BLOCK_FRAMES) != ESP_OK)
+    {
+        printf("wsola: alloc fail\n");
+        return 1;
+    }
+
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < BLOCK_FRAMES * 2; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        in16[i] = (int16_t)(seed >> 16);
+    }
+    audio_format_s16ToS32(in16, in, BLOCK_FRAMES * 2);
+
+    int failed = 0;
+    for (int q = AUDIO_WSOLA_LOW; q <= AUDIO_WSOLA_HIGH; q++)
+    {
+        for (int s = 0; s < 3; s++)
+        {
+            audio_wsola_reset(&w);
+            audio_wsola_setQuality(&w, q);
+            audio_wsola_setSpeed(&w, speeds[s]);
+
+            uint64_t outFrames = 0;
+            uint64_t t0 = nowNs();
+            for (int b = 0; b < BLOCKS; b++)
+                outFrames += audio_wsola_process(&w, in, BLOCK_FRAMES, out, AUDIO_WSOLA_MAX_OUT(BLOCK_FRAMES));
+            uint64_t ns = nowNs() - t0;
+
+            // 输出帧数应接近 输入 / 速度, 少的是还留在缓冲里的几个步长
+            // the output should come close to input / speed, short by the few hops still buffered
+            uint64_t expected = (uint64_t)BLOCKS * BLOCK_FRAMES * AUDIO_WSOLA_SPEED_UNITY / speeds[s];
+            failed += (outFrames + 4 * AUDIO_WSOLA_HOP < expected || outFrames > expected + AUDIO_WSOLA_HOP);
+            printf("wsola %-6s x%.2f: %6.1f ns/output frame, %5.1f ns/output sample, %llu frames out\n",
+                   names[q], (double)speeds[s] / AUDIO_WSOLA_SPEED_UNITY,
+                   (double)ns / outFrames, (double)ns / outFrames / 2, (unsigned long long)outFrames);
+        }
+    }
+    audio_wsola_deinit(&w);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_golden.h"
+
+// 不带参数: 跑全部金样和设计检查, 有失败就返回 1
+// --generate: 打印 audio_golden.c 里 goldenTable 的新内容, 确认输出是对的之后贴回去
+// without arguments: runs every golden and design check, returning 1 on any failure
+// --generate: prints new contents for goldenTable in audio_golden.c, to paste back once the
+// output has been confirmed right
+int main(int argc, char **argv)
+{
+    static audio_golden_result_t results[AUDIO_GOLDEN_MAX_RESULTS];
+    int count = audio_golden_run(results);
+
+    if (argc > 1 && strcmp(argv[1], "--generate") == 0)
+    {
+        for (int i = 0; i < count; i++)
+            if (results[i].kind == AUDIO_GOLDEN_CRC)
+                printf("    {\"%s\", 0x%08x},\n", results[i].name, results[i].crc);
+        return 0;
+    }
+
+    return audio_golden_log(results, count, "audio_golden") ? 1 : 0;
+}
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "audio_graph.h"
+#include "audio_biquad.h"
+#include "audio_format.h"
+#include "audio_eq.h"
+#include "audio_matrix.h"
+#include "audio_crossfeed.h"
+#include "audio_wsola.h"
+#include "audio_src.h"
+#include "audio_gain.h"
+#include "audio_dynamics.h"
+#include "audio_meter.h"
+#include "audio_dither.h"
+
+// 和发送线程 (i2s.c) 一样的处理图, 全部环节打开: 0.8 倍速, 重采样到 48k; 10 秒伪随机噪声按扇区送进去,
+// 最后打印各环节的统计. 主机上 "周期" 是纳秒, 时限按 1GHz 算
+// the same graph as the transmit task's (i2s.c) with every stage on: 0.8x speed and resampling to
+// 48k; 10 seconds of pseudo random noise go in sector by sector and the per-stage statistics are
+// printed at the end. On a host the "cycles" are nanoseconds and the deadline assumes 1GHz
+
+#define BLOCK_FRAMES 588
+#define SECONDS 10
+#define SPEED (AUDIO_WSOLA_SPEED_UNITY * 4 / 5)
+#define OUT_RATE 48000
+#define STRETCH_OUT_FRAMES AUDIO_WSOLA_MAX_OUT(BLOCK_FRAMES)
+#define SRC_OUT_FRAMES AUDIO_SRC_MAX_OUT(BLOCK_FRAMES, 44100, OUT_RATE)
+
+static const char *TAG = "graph";
+
+static audio_biquad_t deemphasis;
+static audio_matrix_t matrix;
+static audio_crossfeed_t crossfeed;
+static audio_wsola_t wsola;
+static audio_src_t src;
+static audio_gain_t volume;
+static audio_dynamics_t dynamics;
+static audio_dither_t dither;
+static int32_t stretchOut[STRETCH_OUT_FRAMES * 2];
+static int32_t srcOut[SRC_OUT_FRAMES * 2];
+
+static uint32_t stage_deemphasis(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_biquad_processStereo((audio_biquad_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_eq(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_eq_process(samples, frames);
+    return frames;
+}
+
+static uint32_t stage_matrix(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_matrix_process((audio_matrix_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_crossfeed(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_crossfeed_process((audio_crossfeed_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_stretch(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    *out = stretchOut;
+    return audio_wsola_process((audio_wsola_t *)ctx, samples, frames, stretchOut, STRETCH_OUT_FRAMES);
+}
+
+static uint32_t stage_src(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    *out = srcOut;
+    return audio_src_process((audio_src_t *)ctx, samples, frames, srcOut, SRC_OUT_FRAMES);
+}
+
+static uint32_t stage_volume(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_gain_processS32((audio_gain_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_dynamics(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_dynamics_process((audio_dynamics_t *)ctx, samples, frames);
+    return frames;
+}
+
+static uint32_t stage_meter(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_meter_process(samples, frames, ((audio_graph_t *)ctx)->outRate, AUDIO_FORMAT_HEADROOM_BITS);
+    return frames;
+}
+
+static uint32_t stage_dither(void *ctx, int32_t *samples, uint32_t frames, int32_t **out)
+{
+    audio_dither_process((audio_dither_t *)ctx, samples, frames);
+    return frames;
+}
+
+static esp_err_t sink(void *ctx, int32_t *samples, uint32_t frames)
+{
+    *(uint64_t *)ctx += frames;
+    return ESP_OK;
+}
+
+int main()
+{
+    static audio_graph_t graph;
+    static int16_t in16[BLOCK_FRAMES * 2];
+    static int32_t in[BLOCK_FRAMES * 2];
+    uint64_t outFrames = 0;
+
+    audio_biquad_coef_t coef;
+    audio_biquad_designDeemphasis(&coef);
+    audio_biquad_init(&deemphasis, &coef);
+
+    audio_eq_band_t bands[AUDIO_EQ_BANDS];
+    audio_eq_init(44100);
+    audio_eq_getBands(bands);
+    for (int i = 0; i < AUDIO_EQ_BANDS; i++)
+        bands[i].gain = 30;
+    audio_eq_setBands(bands);
+
+    static const audio_matrix_config_t matrixCfg = {-30, 150, 0, 0, 0, {0}};
+    audio_matrix_init(&matrix, &matrixCfg, BLOCK_FRAMES);
+    audio_crossfeed_init(&crossfeed, 44100, AUDIO_CROSSFEED_MEDIUM);
+    if (audio_wsola_init(&wsola, AUDIO_WSOLA_MEDIUM, BLOCK_FRAMES) != ESP_OK ||
+        audio_src_init(&src, 44100, OUT_RATE, AUDIO_SRC_MEDIUM, BLOCK_FRAMES) != ESP_OK)
+    {
+        printf("%s: alloc fail\n", TAG);
+        return 1;
+    }
+    audio_wsola_setSpeed(&wsola, SPEED);
+    audio_gain_init(&volume, 20349, 882);
+    audio_dynamics_config_t dynCfg = {1, 1, -20, 40, 200, 6, 0};
+    audio_dynamics_init(&dynamics, OUT_RATE, &dynCfg);
+    audio_dither_init(&dither, AUDIO_DITHER_TPDF, 24);
+
+    audio_graph_init(&graph, OUT_RATE, 80, sink, &outFrames);
+    audio_graph_add(&graph, "deemph", stage_deemphasis, &deemphasis, false, 0);
+    audio_graph_add(&graph, "eq", stage_eq, NULL, false, 0);
+    audio_graph_add(&graph, "matrix", stage_matrix, &matrix, false, 0);
+    audio_graph_add(&graph, "crossfeed", stage_crossfeed, &crossfeed, false, 0);
+    audio_graph_add(&graph, "stretch", stage_stretch, &wsola, false, BLOCK_FRAMES);
+    audio_graph_add(&graph, "src", stage_src, &src, false, BLOCK_FRAMES);
+    audio_graph_add(&graph, "volume", stage_volume, &volume, false, 0);
+    audio_graph_add(&graph, "dynamics", stage_dynamics, &dynamics, false, 0);
+    audio_graph_add(&graph, "meter", stage_meter, &graph, true, 0);
+    audio_graph_add(&graph, "dither", stage_dither, &dither, true, 0);
+    for (int i = 0; i < graph.count; i++)
+        audio_graph_setBypass(&graph, i, false);
+    audio_graph_setLatency(&graph, 4, (AUDIO_WSOLA_HOP + wsola.search) * 1000000ull / 44100);
+    audio_graph_setLatency(&graph, 5, src.taps * 500000 / 44100);
+    audio_graph_setLatency(&graph, 7, AUDIO_DYNAMICS_LOOKAHEAD_US);
+
+    uint32_t seed = 0x12345678;
+    uint32_t blocks = SECONDS * 44100 / BLOCK_FRAMES;
+    for (uint32_t b = 0; b < blocks; b++)
+    {
+        for (int i = 0; i < BLOCK_FRAMES * 2; i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            in16[i] = (int16_t)(seed >> 16);
+        }
+        audio_format_s16ToS32(in16, in, BLOCK_FRAMES * 2);
+        audio_graph_process(&graph, in, BLOCK_FRAMES);
+    }
+    audio_graph_log(&graph, TAG);
+
+    // 0.8 倍速再到 48k, 输出应是输入的 1/0.8 * 48000/44100; 差的只是各环节还留在缓冲里的部分
+    // at 0.8x and then 48k the output should be 1/0.8 * 48000/44100 of the input, short only by
+    // what the stages still hold in their buffers
+    uint64_t expected = (uint64_t)blocks * BLOCK_FRAMES * AUDIO_WSOLA_SPEED_UNITY / SPEED * OUT_RATE / 44100;
+    printf("%s: %llu frames in, %llu out, %llu expected\n", TAG,
+           (unsigned long long)blocks * BLOCK_FRAMES, (unsigned long long)outFrames, (unsigned long long)expected);
+
+    audio_src_deinit(&src);
+    audio_wsola_deinit(&wsola);
+    return (outFrames + 2 * AUDIO_WSOLA_HOP * OUT_RATE / 44100 >= expected && outFrames <= expected) ? 0 : 1;
+}
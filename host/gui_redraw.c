@@ -0,0 +1,457 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "freertos/FreeRTOS.h"
+#include "lvgl.h"
+#include "cdPlayer.h"
+#include "audio_spectrum.h"
+#include "audio_scope.h"
+#include "gui_cdPlayer.h"
+#include "gui_refresh.h"
+#include "usbhost_driver.h"
+#include "i2s.h"
+
+// 界面线程按状态版本号刷新 (050) 前后的对比: 用真的 gui_cdPlayer.c 和 LVGL 在主机上画 240x240 的屏,
+// 按脚本改播放器的状态, 界面线程每 15ms 一轮, 统计 LVGL 重画的像素和一轮的耗时 (主机纳秒), 每段第一轮
+// 换状态两边都要画, 不算. "之前" 一轮是 050 之前 task_lvgl 的循环体和 gui_setProgress, "之后" 是 task_lvgl
+// 现在调用的 gui_refresh(); 主机上示波器和频谱没有新帧, 电平表不动. 之后的重画像素比之前多, 或者没碟空闲时
+// 还在重画, 就失败. 再跑一遍 "之后" 并打开夜间模式, 看增益衰减读数 (035) 多画多少; 不在播放时多画了也失败
+// the GUI task before and after refreshing by state version (050): the real gui_cdPlayer.c and
+// LVGL draw the 240x240 screen on a host while a script changes the player state, the GUI task
+// runs a round every 15ms, and the pixels LVGL redraws and the time per round (host ns) are
+// counted, except on each phase's first round, where the state changes and both sides draw. A
+// "before" round is task_lvgl's loop body and gui_setProgress from before 050, an "after" round
+// is the gui_refresh() task_lvgl calls now; on a host the scope and spectrum have no new frames
+// and the meter holds still. The test fails when after redraws more than before, or still
+// redraws while idle with no disc. "After" runs once more with night mode on to see what the
+// gain reduction readout (035) adds; the test also fails if it draws anything extra when not
+// playing
+
+#define ROUND_MS 15
+#define HOR_RES 240
+#define VER_RES 240
+#define DRAW_ROWS 40
+
+cdplayer_driveInfo_t cdplayer_driveInfo;
+cdplayer_playerInfo_t cdplayer_playerInfo;
+volatile uint32_t cdplayer_stateVersion[CDPLAYER_STATE_GROUPS];
+usbhost_driver_t usbhost_driverObj;
+
+extern lv_obj_t *bar_playProgress;
+extern lv_obj_t *lb_time;
+extern lv_obj_t *lb_duration;
+extern lv_obj_t *lb_gainReduction;
+
+// 脚本里的时间 script time, ms
+static uint32_t clockMs;
+
+// 夜间模式开着 (只有增益衰减那一种) 时压缩器按 3 秒一个来回压 0.5~3.5dB, 每 10 秒里有 1 秒限幅器也在压;
+// 关着时没有衰减
+// with night mode on (the gain reduction variant only) the compressor swings between 0.5 and
+// 3.5dB every 3 seconds, and for 1 second in every 10 the limiter acts as well; with it off there
+// is no reduction
+static bool nightMode;
+
+void i2s_takeGainReduction(uint16_t *comp, uint16_t *limit)
+{
+    if (!nightMode)
+    {
+        *comp = *limit = 0;
+        return;
+    }
+    uint32_t t = clockMs % 3000;
+    *comp = 5 + ((t < 1500) ? t : 3000 - t) * 30 / 1500;
+    *limit = (clockMs % 10000 < 1000) ? 8 + clockMs % 1000 / 100 : 0;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return clockMs;
+}
+
+// 频谱在主机上没有新帧
+// the spectrum has no new frames on a host
+bool audio_spectrum_read(audio_spectrum_frame_t *frame, uint32_t *seq)
+{
+    return false;
+}
+
+hmsf_t cdplay_frameToHmsf(uint32_t frame)
+{
+    int sec = frame / 75;
+    hmsf_t result = {
+        .hour = sec / 3600,
+        .minute = (sec % 3600) / 60,
+        .second = sec % 60,
+        .frame = frame % 75,
+    };
+    return result;
+}
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t redrawPixels;
+
+static void flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color)
+{
+    lv_disp_flush_ready(drv);
+}
+
+static void monitor(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    redrawPixels += px;
+}
+
+// 和 cdPlayer.c 里的 cdplayer_publishState() 一样比较, 只是字段少一些
+// compares the way cdplayer_publishState() in cdPlayer.c does, over fewer fields
+static void publishState()
+{
+    static uint8_t lastDrive[4], lastDisc, lastTransport[3];
+    static int8_t lastTrack = -1, lastVolume = -1;
+    static uint8_t lastCrossfeed = 0xff;
+    static int32_t lastFrame = -1;
+    uint8_t drive[4] = {usbhost_driverObj.deviceIsOpened, cdplayer_driveInfo.trayClosed, cdplayer_driveInfo.discInserted, cdplayer_driveInfo.discIsCD};
+    uint8_t transport[3] = {cdplayer_playerInfo.playing, cdplayer_playerInfo.fastForwarding, cdplayer_playerInfo.fastBackwarding};
+
+    if (memcmp(drive, lastDrive, sizeof(drive)) != 0)
+        cdplayer_stateVersion[CDPLAYER_STATE_DRIVE]++;
+    if (cdplayer_driveInfo.readyToPlay != lastDisc)
+        cdplayer_stateVersion[CDPLAYER_STATE_DISC]++;
+    if (cdplayer_playerInfo.playingTrackIndex != lastTrack)
+        cdplayer_stateVersion[CDPLAYER_STATE_TRACK]++;
+    if (memcmp(transport, lastTransport, sizeof(transport)) != 0)
+        cdplayer_stateVersion[CDPLAYER_STATE_TRANSPORT]++;
+    if (cdplayer_playerInfo.volume != lastVolume)
+        cdplayer_stateVersion[CDPLAYER_STATE_VOLUME]++;
+    if (cdplayer_playerInfo.crossfeed != lastCrossfeed)
+        cdplayer_stateVersion[CDPLAYER_STATE_CROSSFEED]++;
+    if (cdplayer_playerInfo.readFrameCount != lastFrame)
+        cdplayer_stateVersion[CDPLAYER_STATE_POSITION]++;
+
+    memcpy(lastDrive, drive, sizeof(drive));
+    lastDisc = cdplayer_driveInfo.readyToPlay;
+    lastTrack = cdplayer_playerInfo.playingTrackIndex;
+    memcpy(lastTransport, transport, sizeof(transport));
+    lastVolume = cdplayer_playerInfo.volume;
+    lastCrossfeed = cdplayer_playerInfo.crossfeed;
+    lastFrame = cdplayer_playerInfo.readFrameCount;
+}
+
+// ---- 之前 before ----
+
+static void setProgressBefore(uint32_t current, uint32_t total)
+{
+    static uint32_t oldCurrent = 0;
+    static uint32_t oldToal = 0;
+
+    if (oldCurrent == current && oldToal == total) return;
+    oldCurrent = current; oldToal = total;
+
+    if (total == 0) total = 1234; // avoid divide-by-zero
+
+    lv_bar_set_range(bar_playProgress, 0, total);
+    lv_bar_set_value(bar_playProgress, current, LV_ANIM_OFF);
+}
+
+static void roundBefore()
+{
+    char str[100];
+
+    sprintf(str, "%s-%s", cdplayer_driveInfo.vendor, cdplayer_driveInfo.product);
+    gui_setDriveModel(str);
+
+    if (usbhost_driverObj.deviceIsOpened == 0)
+        gui_setDriveState("No drive");
+    else if (cdplayer_driveInfo.trayClosed == 0)
+        gui_setDriveState("Tray open");
+    else if (cdplayer_driveInfo.discInserted == 0)
+        gui_setDriveState("No disc");
+    else if (cdplayer_driveInfo.discIsCD == 0)
+        gui_setDriveState("Not cdda");
+    else
+        gui_setDriveState("Ready");
+
+    gui_setVolume(cdplayer_playerInfo.volume);
+    gui_setCrossfeed(cdplayer_playerInfo.crossfeed);
+
+    if (cdplayer_driveInfo.readyToPlay)
+    {
+        int8_t trackI = cdplayer_playerInfo.playingTrackIndex;
+
+        if (cdplayer_playerInfo.fastForwarding)
+            gui_setPlayState(">>>");
+        else if (cdplayer_playerInfo.fastBackwarding)
+            gui_setPlayState("<<<");
+        else if (cdplayer_playerInfo.playing)
+            gui_setPlayState(LV_SYMBOL_PLAY);
+        else
+            gui_setPlayState(LV_SYMBOL_PAUSE);
+
+        if (cdplayer_driveInfo.cdTextAvalibale)
+        {
+            sprintf(str, "%s - %s", cdplayer_driveInfo.albumTitle, cdplayer_driveInfo.albumPerformer);
+            gui_setAlbumTitle(str);
+        }
+        else
+        {
+            gui_setAlbumTitle("");
+        }
+
+        gui_setEmphasis(cdplayer_driveInfo.trackList[trackI].preEmphasis);
+
+        if (cdplayer_driveInfo.cdTextAvalibale)
+        {
+            gui_setTrackTitle(cdplayer_driveInfo.trackList[trackI].title, cdplayer_driveInfo.trackList[trackI].performer);
+        }
+        else
+        {
+            sprintf(str, "Track %02d", cdplayer_driveInfo.trackList[trackI].trackNum);
+            gui_setTrackTitle(str, "");
+        }
+
+        gui_setTime(cdplay_frameToHmsf(cdplayer_playerInfo.readFrameCount),
+                    cdplay_frameToHmsf(cdplayer_driveInfo.trackList[trackI].trackDuration));
+        setProgressBefore(cdplayer_playerInfo.readFrameCount, cdplayer_driveInfo.trackList[trackI].trackDuration);
+        gui_setTrackNum(trackI + 1, cdplayer_driveInfo.trackCount);
+
+        if (!cdplayer_playerInfo.playing)
+        {
+            gui_setMeter(GUI_METER_FLOOR_DB, GUI_METER_FLOOR_DB);
+            gui_setClip(false, false);
+        }
+    }
+    else
+    {
+        gui_setPlayState(LV_SYMBOL_STOP);
+        gui_setAlbumTitle("");
+        gui_setEmphasis(false);
+        gui_setTrackTitle("(=^_^=)", "");
+        gui_setTime(cdplay_frameToHmsf(0), cdplay_frameToHmsf(0));
+        setProgressBefore(0, 0);
+        gui_setTrackNum(0, 0);
+        gui_setMeter(GUI_METER_FLOOR_DB, GUI_METER_FLOOR_DB);
+        gui_setClip(false, false);
+        lv_chart_set_all_value(chart_left, ser_left, 0);
+        lv_chart_set_all_value(chart_right, ser_right, 0);
+    }
+}
+
+// ---- 脚本 script ----
+
+typedef struct
+{
+    const char *name;
+    uint32_t seconds;
+    uint64_t pixels;
+    uint64_t ns;
+    uint32_t rounds;
+} phase_t;
+
+// 每一段先摆好状态, 再跑这么多秒; 播放时位置跟着时间走, 中间调一次音量
+// each phase sets the state up and then runs this many seconds; while playing the position
+// follows the time, with one volume change halfway
+enum
+{
+    PHASE_NO_DISC,
+    PHASE_PLAYING,
+    PHASE_PAUSED,
+    PHASES,
+};
+
+static void setPhase(int phase)
+{
+    switch (phase)
+    {
+    case PHASE_NO_DISC:
+        usbhost_driverObj.deviceIsOpened = 1;
+        cdplayer_driveInfo.trayClosed = 1;
+        cdplayer_driveInfo.discInserted = 0;
+        cdplayer_driveInfo.readyToPlay = 0;
+        break;
+
+    case PHASE_PLAYING:
+        cdplayer_driveInfo.discInserted = 1;
+        cdplayer_driveInfo.discIsCD = 1;
+        cdplayer_driveInfo.readyToPlay = 1;
+        cdplayer_driveInfo.trackCount = 12;
+        for (int i = 0; i < 12; i++)
+        {
+            cdplayer_driveInfo.trackList[i].trackNum = i + 1;
+            cdplayer_driveInfo.trackList[i].trackDuration = 4 * 60 * 75;
+        }
+        cdplayer_playerInfo.playingTrackIndex = 0;
+        cdplayer_playerInfo.readFrameCount = 0;
+        cdplayer_playerInfo.playing = 1;
+        break;
+
+    case PHASE_PAUSED:
+        cdplayer_playerInfo.playing = 0;
+        break;
+    }
+}
+
+// 之前, 之后, 之后再加上增益衰减的显示 (035)
+// before, after, and after with the gain reduction readout (035)
+enum
+{
+    VARIANT_BEFORE,
+    VARIANT_AFTER,
+    VARIANT_GAIN_REDUCTION,
+    VARIANTS,
+};
+
+static bool run(int variant, phase_t *phases)
+{
+    static lv_disp_draw_buf_t drawBuf;
+    static lv_color_t buf1[HOR_RES * DRAW_ROWS], buf2[HOR_RES * DRAW_ROWS];
+    static lv_disp_drv_t drv;
+
+    lv_init();
+    lv_disp_draw_buf_init(&drawBuf, buf1, buf2, HOR_RES * DRAW_ROWS);
+    lv_disp_drv_init(&drv);
+    drv.hor_res = HOR_RES;
+    drv.ver_res = VER_RES;
+    drv.flush_cb = flush;
+    drv.monitor_cb = monitor;
+    drv.draw_buf = &drawBuf;
+    lv_disp_drv_register(&drv);
+
+    memset(&cdplayer_driveInfo, 0, sizeof(cdplayer_driveInfo));
+    memset(&cdplayer_playerInfo, 0, sizeof(cdplayer_playerInfo));
+    strcpy(cdplayer_driveInfo.vendor, "HL-DT-ST");
+    strcpy(cdplayer_driveInfo.product, "DVDRAM GP57EB40");
+    cdplayer_playerInfo.volume = 20;
+    gui_player_init();
+    gui_refreshAll();
+    nightMode = variant == VARIANT_GAIN_REDUCTION;
+
+    // 启动画面先画完, 不算 the start-up screen is drawn first and not counted
+    lv_tick_inc(100);
+    lv_timer_handler();
+
+    for (int p = 0; p < PHASES; p++)
+    {
+        setPhase(p);
+        uint32_t start = cdplayer_playerInfo.readFrameCount;
+        redrawPixels = 0;
+        for (uint32_t ms = 0; ms < phases[p].seconds * 1000; ms += ROUND_MS)
+        {
+            if (cdplayer_playerInfo.playing)
+                cdplayer_playerInfo.readFrameCount = start + ms * 75 / 1000;
+            if (p == PHASE_PLAYING && ms == phases[p].seconds * 500)
+                cdplayer_playerInfo.volume--;
+            publishState();
+
+            uint64_t t0 = nowNs();
+            if (variant == VARIANT_BEFORE)
+                roundBefore();
+            else
+                gui_refresh();
+            lv_tick_inc(ROUND_MS);
+            lv_timer_handler();
+
+            // 换状态的那一轮两边都要画, 当场画完, 不算
+            // the round the state changes on draws on both sides; drawn there and then, not counted
+            if (ms == 0)
+            {
+                lv_refr_now(NULL);
+                redrawPixels = 0;
+            }
+            phases[p].ns += nowNs() - t0;
+            phases[p].rounds++;
+            clockMs += ROUND_MS;
+        }
+        phases[p].pixels = redrawPixels;
+    }
+
+    // 最宽的读数不能压到播放时间和总时长上
+    // the widest reading must not run into the played time or the duration
+    if (variant == VARIANT_GAIN_REDUCTION)
+    {
+        lv_area_t gr, time, duration, unused;
+        gui_setGainReduction(999, 999);
+        lv_obj_update_layout(lb_gainReduction);
+        lv_obj_get_coords(lb_gainReduction, &gr);
+        lv_obj_get_coords(lb_time, &time);
+        lv_obj_get_coords(lb_duration, &duration);
+        if (_lv_area_intersect(&unused, &gr, &time) || _lv_area_intersect(&unused, &gr, &duration))
+        {
+            printf("gain reduction %d..%d overlaps time %d..%d or duration %d..%d\n", gr.x1, gr.x2, time.x1,
+                   time.x2, duration.x1, duration.x2);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    static const char *names[PHASES] = {"no disc", "playing", "paused"};
+    static const uint32_t seconds[PHASES] = {10, 60, 10};
+    phase_t result[VARIANTS][PHASES];
+    int fds[VARIANTS][2];
+
+    // 界面的各个 set 函数用静态变量记上一次的值, 每种各用一个子进程从头跑
+    // the GUI setters remember the last value in statics, so each variant runs from scratch in a
+    // child process of its own
+    for (int v = 0; v < VARIANTS; v++)
+    {
+        if (pipe(fds[v]) != 0)
+            return 1;
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            phase_t phases[PHASES];
+            memset(phases, 0, sizeof(phases));
+            for (int p = 0; p < PHASES; p++)
+            {
+                phases[p].name = names[p];
+                phases[p].seconds = seconds[p];
+            }
+            bool ok = run(v, phases);
+            ssize_t n = write(fds[v][1], phases, sizeof(phases));
+            _exit(ok && n == sizeof(phases) ? 0 : 1);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+            read(fds[v][0], result[v], sizeof(result[v])) != sizeof(result[v]))
+            return 1;
+    }
+
+    int failed = 0;
+    for (int p = 0; p < PHASES; p++)
+    {
+        const phase_t *b = &result[VARIANT_BEFORE][p], *a = &result[VARIANT_AFTER][p];
+        bool ok = a->pixels <= b->pixels && (p != PHASE_NO_DISC || a->pixels == 0);
+        failed += !ok;
+        printf("gui %-8s %2lu s: redrawn %8llu -> %8llu px/s, round %6.1f -> %6.1f us %s\n", names[p],
+               (unsigned long)seconds[p], (unsigned long long)(b->pixels / seconds[p]),
+               (unsigned long long)(a->pixels / seconds[p]), b->ns / 1000.0 / b->rounds, a->ns / 1000.0 / a->rounds,
+               ok ? "ok" : "FAILED");
+    }
+
+    // 增益衰减的读数只在播放时变, 其他时候不能多画
+    // the gain reduction readout only changes while playing and must not draw anything otherwise
+    for (int p = 0; p < PHASES; p++)
+    {
+        const phase_t *b = &result[VARIANT_AFTER][p], *a = &result[VARIANT_GAIN_REDUCTION][p];
+        bool ok = p == PHASE_PLAYING || a->pixels == b->pixels;
+        failed += !ok;
+        printf("gui %-8s %2lu s: with gain reduction %8llu -> %8llu px/s, round %6.1f -> %6.1f us %s\n", names[p],
+               (unsigned long)seconds[p], (unsigned long long)(b->pixels / seconds[p]),
+               (unsigned long long)(a->pixels / seconds[p]), b->ns / 1000.0 / b->rounds, a->ns / 1000.0 / a->rounds,
+               ok ? "ok" : "FAILED");
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,15 @@
+#ifndef __ESP_ERR_H_SHIM_
+#define __ESP_ERR_H_SHIM_
+
+// 主机编译用: 只有音频处理头文件用到的那几个 ESP-IDF 错误码, 数值与 ESP-IDF 一致
+// for host builds: only the few ESP-IDF error codes the audio processing headers use, with the
+// same values as ESP-IDF
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+
+#endif
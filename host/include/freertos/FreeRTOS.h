@@ -0,0 +1,12 @@
+#ifndef __FREERTOS_H_SHIM_
+#define __FREERTOS_H_SHIM_
+
+#include <stdint.h>
+
+// 主机编译用: 只有界面刷新用到的节拍类型, 一个节拍 1ms
+// for host builds: only the tick type the GUI refresh uses, one tick per ms
+typedef uint32_t TickType_t;
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif
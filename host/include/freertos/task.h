@@ -0,0 +1,10 @@
+#ifndef __FREERTOS_TASK_H_SHIM_
+#define __FREERTOS_TASK_H_SHIM_
+
+#include "freertos/FreeRTOS.h"
+
+// 主机编译用: 由测试程序按它的脚本时间提供
+// for host builds: provided by the test from its script time
+TickType_t xTaskGetTickCount(void);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef __USBHOST_DRIVER_H_SHIM_
+#define __USBHOST_DRIVER_H_SHIM_
+
+#include <stdint.h>
+
+// 主机编译用: 界面只看光驱是否打开
+// for host builds: the GUI only looks at whether the drive is open
+typedef struct
+{
+    uint8_t deviceIsOpened;
+} usbhost_driver_t;
+
+extern usbhost_driver_t usbhost_driverObj;
+
+#endif
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "audio_format.h"
+#include "audio_dynamics.h"
+
+// 压缩器开着时开关限幅器: 信号低于上限时, 来回开关的输出要和一直不开逐位相同 (延迟不变, 不插静音也不丢帧);
+// 信号超过满幅时, 限幅器打开后的第一帧起输出就不能超过上限 (延迟线里还没出去的帧也要压住)
+// toggling the limiter with the compressor on: below the ceiling the output toggled back and forth
+// has to match the one never toggled bit for bit (same latency, no silence inserted, no frames
+// dropped); above full scale no output may exceed the ceiling from the first frame after the
+// limiter is turned on (the frames still in the delay line have to be held down too)
+
+#define RATE 44100
+#define BLOCK 256
+#define BLOCKS 64
+#define FULL_SCALE (1 << (31 - AUDIO_FORMAT_HEADROOM_BITS))
+
+static int32_t a[BLOCK * 2], b[BLOCK * 2];
+
+static void fill(int32_t *x, uint32_t block, float level)
+{
+    for (uint32_t i = 0; i < BLOCK; i++)
+    {
+        uint32_t n = block * BLOCK + i;
+        x[i * 2] = (int32_t)(level * FULL_SCALE * sinf(n * 0.0713f));
+        x[i * 2 + 1] = (int32_t)(level * FULL_SCALE * sinf(n * 0.0517f + 1.0f));
+    }
+}
+
+int main()
+{
+    static audio_dynamics_t steady, toggled;
+    audio_dynamics_config_t on = {1, 1, -20, 40, 200, 0, 0};
+    audio_dynamics_config_t off = on;
+    off.limiter = 0;
+
+    // -30dBFS, 压缩器不动作, 限幅器也不动作
+    // -30dBFS, neither the compressor nor the limiter acts
+    audio_dynamics_init(&steady, RATE, &off);
+    audio_dynamics_init(&toggled, RATE, &off);
+    uint32_t diff = 0;
+    for (uint32_t k = 0; k < BLOCKS; k++)
+    {
+        fill(a, k, 0.03f);
+        memcpy(b, a, sizeof(a));
+        audio_dynamics_setConfig(&toggled, (k & 1) ? &on : &off);
+        audio_dynamics_process(&steady, a, BLOCK);
+        audio_dynamics_process(&toggled, b, BLOCK);
+        for (uint32_t i = 0; i < BLOCK * 2; i++)
+            diff += a[i] != b[i];
+    }
+    printf("limiter toggled every block below the ceiling: %lu samples differ %s\n", (unsigned long)diff,
+           diff ? "FAILED" : "ok");
+
+    // 满幅的两倍, 压缩比 1:1 让压缩器不碰电平, 限幅器从第 8 块起打开
+    // twice full scale with a 1:1 ratio so the compressor leaves the level alone, the limiter
+    // turned on from block 8
+    on.ratio = off.ratio = 10;
+    audio_dynamics_init(&toggled, RATE, &off);
+    uint32_t maxOut = 0;
+    for (uint32_t k = 0; k < BLOCKS; k++)
+    {
+        fill(b, k, 2.0f);
+        if (k == 8)
+            audio_dynamics_setConfig(&toggled, &on);
+        audio_dynamics_process(&toggled, b, BLOCK);
+        if (k < 8)
+            continue;
+        for (uint32_t i = 0; i < BLOCK * 2; i++)
+        {
+            uint32_t m = (b[i] < 0) ? -(uint32_t)b[i] : (uint32_t)b[i];
+            if (m > maxOut)
+                maxOut = m;
+        }
+    }
+    bool capped = maxOut <= toggled.ceiling;
+    printf("limiter turned on at twice full scale: peak %.3f dBFS, ceiling %.3f dBFS %s\n",
+           20.0 * log10((double)maxOut / FULL_SCALE), 20.0 * log10((double)toggled.ceiling / FULL_SCALE),
+           capped ? "ok" : "FAILED");
+
+    return (diff == 0 && capped) ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "audio_matrix.h"
+
+// 声道矩阵的过渡不能溢出: 宽度 200 时系数是 ±1.5 (Q30), 反相一翻转, 两端相差 3.0, 超过 int32.
+// 左右输入各是一个常数, 过渡期间每路输出都应从旧值单调走到新值, 结束时正好是新矩阵的结果
+// the channel matrix slide must not overflow: at width 200 the coefficients are ±1.5 (Q30), and
+// flipping polarity makes the two ends 3.0 apart, beyond int32. With a constant on each input,
+// every output should move monotonically from the old value to the new one during the slide and
+// land exactly on the new matrix's result
+
+#define RAMP_FRAMES 588
+#define FRAMES (RAMP_FRAMES + 100)
+
+// 左 1/4 满幅, 右 -1/8 满幅, 两路都用到
+// left at 1/4 full scale and right at -1/8, so both inputs count
+#define IN_L (1 << 27)
+#define IN_R (-(1 << 26))
+
+static bool slide(const char *name, const audio_matrix_config_t *from, const audio_matrix_config_t *to, uint32_t rampFrames)
+{
+    static int32_t buf[FRAMES * 2];
+    audio_matrix_t m, end;
+    audio_matrix_init(&m, from, rampFrames);
+    audio_matrix_init(&end, to, 0);
+
+    int32_t first[2] = {IN_L, IN_R}, last[2] = {IN_L, IN_R};
+    audio_matrix_process(&m, first, 1);
+    audio_matrix_init(&m, from, rampFrames);
+    audio_matrix_process(&end, last, 1);
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        buf[i * 2] = IN_L;
+        buf[i * 2 + 1] = IN_R;
+    }
+    audio_matrix_setConfig(&m, to);
+    // 分成不整齐的几块, 过渡跨块也要对
+    // in uneven pieces, so the slide has to be right across blocks too
+    audio_matrix_process(&m, buf, 100);
+    audio_matrix_process(&m, buf + 200, 333);
+    audio_matrix_process(&m, buf + 866, FRAMES - 433);
+
+    bool ok = true;
+    for (int c = 0; c < 2; c++)
+    {
+        int dir = (last[c] > first[c]) - (last[c] < first[c]);
+        int32_t prev = first[c];
+        for (int i = 0; i < FRAMES; i++)
+        {
+            int32_t y = buf[i * 2 + c];
+            if ((dir > 0 && y < prev) || (dir < 0 && y > prev) || (dir == 0 && y != prev))
+                ok = false;
+            prev = y;
+        }
+        ok = ok && prev == last[c];
+    }
+    printf("matrix %-28s ramp %3lu: left %11ld -> %11ld, right %11ld -> %11ld, %s\n", name, (unsigned long)rampFrames,
+           (long)first[0], (long)last[0], (long)first[1], (long)last[1], ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    static const audio_matrix_config_t wide = {0, AUDIO_MATRIX_WIDTH_MAX, 0, 0, 0, {0}};
+    static const audio_matrix_config_t wideInvL = {0, AUDIO_MATRIX_WIDTH_MAX, 0, 0, 1, {0}};
+    static const audio_matrix_config_t wideInvBoth = {0, AUDIO_MATRIX_WIDTH_MAX, 0, 0, 3, {0}};
+    static const audio_matrix_config_t wideSwapInvR = {0, AUDIO_MATRIX_WIDTH_MAX, 0, 1, 2, {0}};
+    static const uint32_t ramps[] = {RAMP_FRAMES, 2, 1};
+    int failed = 0;
+
+    for (int r = 0; r < 3; r++)
+    {
+        failed += !slide("width 200, invert left on", &wide, &wideInvL, ramps[r]);
+        failed += !slide("width 200, invert left off", &wideInvL, &wide, ramps[r]);
+        failed += !slide("width 200, invert both", &wide, &wideInvBoth, ramps[r]);
+        failed += !slide("width 200, swap + invert", &wideInvBoth, &wideSwapInvR, ramps[r]);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "audio_seqlock.h"
+
+// 发布设置用的序号锁: 一个线程不停地发布, 每份里所有的字都是同一个序号; 另一个线程像发送线程那样每次只试一下,
+// 读成功的每一份都必须是完整的 (所有的字相同), 而且序号只增不减. 每份 16MB, 比实际的设置大得多, 即使只有一个核,
+// 线程切换也常常落在拷贝中间; 去掉拷贝之后的再检查, 这个测试就会报出拷坏的份数
+// the sequence lock the settings are published with: one thread keeps publishing, every word in
+// a copy holding the same serial; the other only tries once per go, as the transmit task does, and
+// every copy it does read must be whole (all words equal) with serials that never go back. The
+// copy is 16MB, far bigger than any real settings, so that even on a single core a thread switch
+// often lands in the middle of a copy; with the re-check after the copy taken out, this test does
+// report torn copies
+
+#define WORDS (4 << 20)
+#define PUBLISHES 100
+
+typedef struct
+{
+    uint32_t w[WORDS];
+} payload_t;
+
+static payload_t shared;
+static uint32_t seq = 0;
+static volatile bool done = false;
+
+static void *writer(void *arg)
+{
+    static payload_t p;
+    for (uint32_t n = 1; n <= PUBLISHES; n++)
+    {
+        for (int i = 0; i < WORDS; i++)
+            p.w[i] = n;
+        audio_seqlock_write(&seq, &shared, &p, sizeof(p));
+    }
+    done = true;
+    return NULL;
+}
+
+int main()
+{
+    pthread_t t;
+    static payload_t p;
+    uint32_t seen = 0, last = 0, reads = 0, misses = 0, torn = 0;
+
+    pthread_create(&t, NULL, writer, NULL);
+    while (!done)
+    {
+        if (!audio_seqlock_read(&seq, &seen, &p, &shared, sizeof(p)))
+        {
+            misses += audio_seqlock_pending(&seq, seen);
+            continue;
+        }
+        reads++;
+        bool whole = p.w[0] >= last;
+        for (int i = 1; i < WORDS; i++)
+            whole = whole && p.w[i] == p.w[0];
+        torn += !whole;
+        last = p.w[0];
+    }
+    pthread_join(t, NULL);
+
+    // 写完之后一定能取到最后一份
+    // once the writer is done the last copy must come through
+    if (audio_seqlock_read(&seq, &seen, &p, &shared, sizeof(p)))
+        last = p.w[0];
+    bool final = last == PUBLISHES;
+
+    printf("seqlock: %lu publishes, %lu copies taken, %lu retried, %lu torn, last %s\n",
+           (unsigned long)PUBLISHES, (unsigned long)reads, (unsigned long)misses, (unsigned long)torn,
+           final ? "taken" : "MISSING");
+    return (torn == 0 && final && reads > 0) ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "audio_src.h"
+
+// 重采样 44.1k -> 48k/96k 的质量: 1kHz -1dBFS 正弦 (先量化到 16 位, 和 CD 一样) 的 THD+N, 以及 20Hz 到
+// 各档通带上限的幅度波动; 任何一项超过该档的上限就失败
+// resampler quality 44.1k -> 48k/96k: THD+N of a 1kHz -1dBFS sine (quantized to 16 bits first, as
+// on a CD) and the amplitude ripple from 20Hz to each tier's passband edge; the test fails when
+// either goes over the tier's limit
+
+#define BLOCK_FRAMES 588
+#define OUT_MAX AUDIO_SRC_MAX_OUT(BLOCK_FRAMES, 44100, 96000)
+
+typedef struct
+{
+    const char *name;
+    double thdnMax;   // dB
+    double edge;      // Hz
+    double rippleMax; // dB
+} tier_t;
+
+// 16 位输入本身的量化噪声约 -98dB, HIGH 档的上限受它限制
+// the 16-bit input's own quantization noise is about -98dB, which bounds the HIGH tier
+static const tier_t tiers[] = {
+    [AUDIO_SRC_LOW] = {"low", -70.0, 16000, 0.02},
+    [AUDIO_SRC_MEDIUM] = {"medium", -90.0, 18000, 0.001},
+    [AUDIO_SRC_HIGH] = {"high", -95.0, 19500, 0.001},
+};
+
+static double y[400 * OUT_MAX];
+
+// 送 blocks 块正弦进去; 在后 3/4 上做最小二乘正弦拟合, 返回幅度 (dB, 相对输入) 和残差 (dB, 相对拟合的正弦)
+// feeds blocks of sine; a least squares sine fit over the last 3/4 gives the amplitude (dB,
+// relative to the input) and the residual (dB, relative to the fitted sine)
+static void measure(audio_src_quality_t q, uint32_t outRate, double f, int blocks, double *gainDb, double *thdnDb)
+{
+    static int32_t in[BLOCK_FRAMES * 2];
+    static int32_t out[OUT_MAX * 2];
+    const double amp = pow(10.0, -1.0 / 20.0) * 32767;
+    audio_src_t src;
+    uint32_t n = 0;
+
+    audio_src_init(&src, 44100, outRate, q, BLOCK_FRAMES);
+    for (int b = 0; b < blocks; b++)
+    {
+        for (int i = 0; i < BLOCK_FRAMES; i++)
+        {
+            int32_t s = (int32_t)lrint(amp * sin(2 * M_PI * f * (b * BLOCK_FRAMES + i) / 44100));
+            in[i * 2] = in[i * 2 + 1] = s << 14;
+        }
+        uint32_t got = audio_src_process(&src, in, BLOCK_FRAMES, out, OUT_MAX);
+        for (uint32_t i = 0; i < got; i++)
+            y[n++] = out[i * 2] / (double)(1 << 14);
+    }
+    audio_src_deinit(&src);
+
+    double w = 2 * M_PI * f / outRate;
+    double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0;
+    for (uint32_t i = n / 4; i < n; i++)
+    {
+        double s = sin(w * i), c = cos(w * i);
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        ys += y[i] * s;
+        yc += y[i] * c;
+    }
+    double det = ss * cc - sc * sc;
+    double ps = (ys * cc - yc * sc) / det, pc = (yc * ss - ys * sc) / det;
+    double e = 0, p = 0;
+    for (uint32_t i = n / 4; i < n; i++)
+    {
+        double fit = ps * sin(w * i) + pc * cos(w * i);
+        e += (y[i] - fit) * (y[i] - fit);
+        p += fit * fit;
+    }
+    *gainDb = 20 * log10(sqrt(ps * ps + pc * pc) / amp);
+    *thdnDb = 10 * log10(e / p);
+}
+
+int main()
+{
+    static const uint32_t rates[] = {48000, 96000};
+    int failed = 0;
+
+    for (int r = 0; r < 2; r++)
+    {
+        for (int q = AUDIO_SRC_LOW; q <= AUDIO_SRC_HIGH; q++)
+        {
+            const tier_t *t = &tiers[q];
+            double gain, thdn, lo = 1e9, hi = -1e9;
+            measure(q, rates[r], 1000, 300, &gain, &thdn);
+            for (double f = 20; f <= t->edge; f *= 1.25)
+            {
+                double g, unused;
+                measure(q, rates[r], f, 60, &g, &unused);
+                lo = fmin(lo, g);
+                hi = fmax(hi, g);
+            }
+            double g, unused;
+            measure(q, rates[r], t->edge, 60, &g, &unused);
+            lo = fmin(lo, g);
+            hi = fmax(hi, g);
+
+            bool ok = thdn <= t->thdnMax && hi - lo <= t->rippleMax;
+            failed += !ok;
+            printf("src %lu %-6s: THD+N %6.1f dB (limit %.0f), ripple 20Hz-%.0fHz %.4f dB (limit %.3f) %s\n",
+                   (unsigned long)rates[r], t->name, thdn, t->thdnMax, t->edge, hi - lo, t->rippleMax,
+                   ok ? "ok" : "FAILED");
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "esp_log.h"
+
+#include "usbhost_scsi_cmd.h"
+#include "cdPlayer.h"
+#include "cdLoudness.h"
+#include "i2s.h"
+#include "audio_loudness.h"
+
+// 按光盘缓存每个音轨的积分响度和真峰值. 扫描在后台做: 不播放时光驱空闲就读, 播放时只在环形缓冲区
+// 满 (读盘空闲) 时插进来读, 所以第一次播放时也会顺便测完
+// integrated loudness and true peak of every track, cached per disc. The scan runs in the
+// background: while not playing it reads whenever the drive is idle, and while playing it only
+// reads when the ring is full (the reader is idle), so a first playback measures the disc too
+
+static const char *TAG = "cdLoudness";
+
+static uint32_t discId = 0;
+static volatile uint32_t discGen = 0;
+static cdloudness_track_t cache[99];
+static volatile bool cacheHasChange = false;
+
+// 光盘 ID: 各音轨起始 LBA 和最后一轨结尾的 FNV-1a
+// disc ID: FNV-1a over the start LBA of each track and the end of the last one
+static uint32_t makeDiscId()
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i <= cdplayer_driveInfo.trackCount; i++)
+    {
+        uint32_t lba = (i < cdplayer_driveInfo.trackCount)
+                           ? cdplayer_driveInfo.trackList[i].lbaBegin
+                           : cdplayer_driveInfo.trackList[i - 1].lbaBegin + cdplayer_driveInfo.trackList[i - 1].trackDuration;
+        for (int b = 0; b < 4; b++)
+        {
+            h ^= (lba >> (b * 8)) & 0xff;
+            h *= 16777619u;
+        }
+    }
+    return h;
+}
+
+static void makeKey(char *key)
+{
+    sprintf(key, "d%08lx", (unsigned long)discId);
+}
+
+// 目录读出来以后调用, 读出这张光盘的缓存
+// called once the TOC is read; loads the cache of this disc
+void cdloudness_discLoaded()
+{
+    for (int i = 0; i < 99; i++)
+    {
+        cache[i].lufs = CDLOUDNESS_NONE;
+        cache[i].peak = 0;
+    }
+    discId = makeDiscId();
+    discGen++;
+    cacheHasChange = false;
+
+    char key[16];
+    makeKey(key);
+    nvs_handle_t h;
+    if (nvs_open("loudness", NVS_READONLY, &h) != ESP_OK)
+        return;
+    size_t size = cdplayer_driveInfo.trackCount * sizeof(cdloudness_track_t);
+    if (nvs_get_blob(h, key, cache, &size) == ESP_OK)
+        ESP_LOGI(TAG, "disc %s: cached loudness loaded", key);
+    nvs_close(h);
+}
+
+// 空间不够就清掉所有光盘的缓存再写
+// when flash space runs out, the cache of every disc is dropped and the write retried
+static void saveCache()
+{
+    char key[16];
+    makeKey(key);
+    nvs_handle_t h;
+    if (nvs_open("loudness", NVS_READWRITE, &h) != ESP_OK)
+        return;
+    size_t size = cdplayer_driveInfo.trackCount * sizeof(cdloudness_track_t);
+    esp_err_t err = nvs_set_blob(h, key, cache, size);
+    if (err == ESP_ERR_NVS_NOT_ENOUGH_SPACE)
+    {
+        ESP_LOGW(TAG, "cache full, cleared");
+        nvs_erase_all(h);
+        err = nvs_set_blob(h, key, cache, size);
+    }
+    if (err == ESP_OK)
+        nvs_commit(h);
+    nvs_close(h);
+    ESP_LOGI(TAG, "disc %s: loudness saved", key);
+}
+
+// 归一化关闭或还没测到时为 0dB
+// 0dB when normalization is off or the track has not been measured
+uint16_t cdloudness_getTrackGain(int8_t track)
+{
+    if (!cdplayer_playerInfo.loudnessNorm || track < 0 || track >= cdplayer_driveInfo.trackCount ||
+        cache[track].lufs == CDLOUDNESS_NONE)
+        return I2S_TRACK_GAIN_UNITY;
+
+    float gainDb = CDLOUDNESS_TARGET_LUFS - cache[track].lufs / 100.0f;
+    float peakRoom = CDLOUDNESS_PEAK_CEILING_DB - cache[track].peak / 100.0f;
+    if (gainDb > peakRoom)
+        gainDb = peakRoom;
+
+    int32_t gain = (int32_t)(I2S_TRACK_GAIN_UNITY * powf(10.0f, gainDb / 20.0f) + 0.5f);
+    if (gain > I2S_TRACK_GAIN_MAX)
+        gain = I2S_TRACK_GAIN_MAX;
+    if (gain < 1)
+        gain = 1;
+    return gain;
+}
+
+static int8_t nextUnscanned()
+{
+    for (int i = 0; i < cdplayer_driveInfo.trackCount; i++)
+        if (cache[i].lufs == CDLOUDNESS_NONE)
+            return i;
+    return -1;
+}
+
+static void cdloudness_task(void *arg)
+{
+    static audio_loudness_t meter;
+    static uint8_t scanBuf[I2S_TX_BUFFER_LEN];
+    int8_t track = -1;
+    uint32_t frame = 0;
+    uint32_t gen = 0;
+
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+
+        // 和其他设置一样, 停止播放后再写 flash
+        if (cacheHasChange && !cdplayer_playerInfo.playing)
+        {
+            cacheHasChange = false;
+            saveCache();
+        }
+
+        if (!cdplayer_playerInfo.loudnessNorm || cdplayer_driveInfo.readyToPlay != 1 || gen != discGen)
+        {
+            track = -1;
+            gen = discGen;
+            continue;
+        }
+
+        // 播放优先, 环形缓冲区没满时不占光驱
+        if (cdplayer_playerInfo.playing && !i2s_bufsFull)
+            continue;
+
+        if (track < 0)
+        {
+            track = nextUnscanned();
+            if (track < 0)
+                continue;
+            frame = 0;
+            audio_loudness_init(&meter, 44100);
+            ESP_LOGI(TAG, "scan track %02d", track + 1);
+        }
+
+        cdplayer_trackInfo_t *info = &cdplayer_driveInfo.trackList[track];
+        uint32_t readFrames = info->trackDuration - frame;
+        if (readFrames > I2S_TX_BUFFER_SIZE_FRAME)
+            readFrames = I2S_TX_BUFFER_SIZE_FRAME;
+        uint32_t readBytes = readFrames * 2352;
+
+        if (usbhost_scsi_readCD(info->lbaBegin + frame, scanBuf, &readFrames, &readBytes) != ESP_OK)
+        {
+            vTaskDelay(pdMS_TO_TICKS(500));
+            continue;
+        }
+        // 读的时候换了光盘
+        if (gen != discGen)
+            continue;
+
+        audio_loudness_process(&meter, (const int16_t *)scanBuf, readFrames * (2352 / 4));
+        frame += readFrames;
+        if (frame < info->trackDuration)
+            continue;
+
+        float lufs;
+        float peak = audio_loudness_truePeakDb(&meter);
+        if (!audio_loudness_integrated(&meter, &lufs))
+            lufs = CDLOUDNESS_TARGET_LUFS; // 静音轨不调 a silent track is left alone
+        cache[track].peak = (peak < -99.0f) ? -9900 : (int16_t)lrintf(peak * 100.0f);
+        cache[track].lufs = (int16_t)lrintf(lufs * 100.0f);
+        cacheHasChange = true;
+        ESP_LOGI(TAG, "track %02d: %.2f LUFS, %.2f dBTP", track + 1, lufs, peak);
+        track = -1;
+    }
+}
+
+void cdloudness_init()
+{
+    BaseType_t ret = xTaskCreatePinnedToCore(cdloudness_task,
+                                             "cdloudness_task",
+                                             4096, NULL, 1, NULL, 0);
+    if (ret != pdPASS) ESP_LOGE("cdloudness_init", "cdloudness_task create fail");
+}
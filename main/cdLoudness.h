@@ -0,0 +1,25 @@
+#ifndef __CD_LOUDNESS_H_
+#define __CD_LOUDNESS_H_
+
+#include <stdint.h>
+
+// 响度归一化的参考电平 (ReplayGain 2.0), 归一化后真峰值不超过 -1dBTP
+// reference level for loudness normalization (ReplayGain 2.0); the true peak stays below -1dBTP
+// after normalization
+#define CDLOUDNESS_TARGET_LUFS -18.0f
+#define CDLOUDNESS_PEAK_CEILING_DB -1.0f
+
+// 每个音轨的测量结果, 0.01dB, 存进 flash; lufs 为 CDLOUDNESS_NONE 表示还没测
+// per-track result in 0.01dB, stored in flash; lufs == CDLOUDNESS_NONE when not measured yet
+#define CDLOUDNESS_NONE INT16_MIN
+typedef struct
+{
+    int16_t lufs;
+    int16_t peak;
+} cdloudness_track_t;
+
+void cdloudness_init();
+void cdloudness_discLoaded();
+uint16_t cdloudness_getTrackGain(int8_t track);
+
+#endif
@@ -13,14 +13,110 @@
 #include "cdPlayer.h"
 #include "button.h"
 #include "i2s.h"
+#include "audio_src.h"
+#include "audio_dither.h"
+#include "audio_mix.h"
+#include "audio_crossfeed.h"
+#include "cdLoudness.h"
 #include "bt_a2dp.h"
 
 cdplayer_driveInfo_t cdplayer_driveInfo;
 cdplayer_playerInfo_t cdplayer_playerInfo;
+volatile uint32_t cdplayer_stateVersion[CDPLAYER_STATE_GROUPS];
 uint8_t readCdBuf[I2S_TX_BUFFER_LEN];
 
 static const char *TAG = "cdPlayer";
 
+static volatile bool eqHasChange = false;
+static volatile bool outputRateHasChange = false;
+static volatile bool ditherHasChange = false;
+static volatile bool crossfadeHasChange = false;
+static volatile bool loudnessNormHasChange = false;
+static volatile bool dynamicsHasChange = false;
+static volatile bool matrixHasChange = false;
+static volatile bool crossfeedHasChange = false;
+static volatile bool scanRatioHasChange = false;
+static volatile bool latencyHasChange = false;
+static volatile bool bitPerfectHasChange = false;
+
+// 读盘位置, 比播放位置超前整个环形缓冲区; 播放位置 (playingTrackIndex/readFrameCount) 跟着 I2S 实际送出的扇区走
+// read position, ahead of the play position by the whole ring; the play position
+// (playingTrackIndex/readFrameCount) follows the sectors I2S has actually sent
+static int8_t readTrack = 0;
+static uint32_t readFrame = 0;
+
+// 交叉淡化: 上面的读盘位置是渐入的一路, 这里是渐出的一路, 两路读出来混好再送进环形缓冲区
+// crossfade: the read position above is the stream fading in, this is the one fading out; both are
+// read and mixed before going into the ring
+#define CDPLAYER_CROSSFADE_MAX_SEC 10
+// 手动换曲时的淡化长度, 扇区
+// fade length on a manual skip, sectors
+#define CDPLAYER_SKIP_FADE_FRAMES 15
+static int8_t fadeTrack = -1; // -1 没有在淡化 -1 when not fading
+static uint32_t fadeFrame;
+static uint32_t fadeRemain;   // 渐出那一路还剩的扇区 sectors left in the stream fading out
+static uint32_t fadeDone;     // 已淡化的帧 frames faded so far
+static uint32_t fadeLen;      // 淡化总长, 帧 whole fade, frames
+
+// 渐出的一路一次读一长段放在自己的缓冲里, 每段驱动器只来回寻道两次, 而不是每个缓冲区两次.
+// 淡化时环形缓冲区要盖住一次 "寻道过去, 读一段, 寻道回来, 读一个缓冲区":
+//   2 x 寻道时间 + (CDPLAYER_FADE_RUN_FRAMES + 8) 个扇区的读盘时间,
+// 按 100ms 的寻道和 8 倍速读盘是 253ms; 长期来看每段 320ms 的音频要 200ms 寻道加 80ms 读盘, 也跟得上.
+// 环形缓冲区最深时不够 CDPLAYER_FADE_RING_MS 的档位 (LOW, 107ms) 不淡化, 照旧无缝接续/直接跳.
+// 淡化期间环形缓冲区保持最深, 按音轨结尾的淡化提前一个环形缓冲区开始保持. 寻道时间和读盘速度是设计假设,
+// 不是测量值
+// the stream fading out is read a long run at a time into a buffer of its own, so the drive seeks
+// there and back twice per run instead of twice per buffer. During a fade the ring has to cover
+// one "seek there, read a run, seek back, read a buffer":
+//   2 x seek time + reading (CDPLAYER_FADE_RUN_FRAMES + 8) sectors,
+// 253ms with 100ms seeks and 8x reads; in the long run each 320ms run of audio costs 200ms of
+// seeking plus 80ms of reading, which keeps up. Profiles whose deepest ring is short of
+// CDPLAYER_FADE_RING_MS (LOW, 107ms) do not fade and stay gapless or jump. The ring is held at its
+// deepest during a fade, from one ring ahead for a fade at a track's end. The seek time and read
+// speed are design assumptions, not measurements
+#define CDPLAYER_FADE_RUN_FRAMES (3 * I2S_TX_BUFFER_SIZE_FRAME)
+#define CDPLAYER_FADE_SEEK_MS 100
+#define CDPLAYER_FADE_READ_X 8
+#define CDPLAYER_FADE_RING_MS (2 * CDPLAYER_FADE_SEEK_MS + \
+                               (CDPLAYER_FADE_RUN_FRAMES + I2S_TX_BUFFER_SIZE_FRAME) * 1000 / (75 * CDPLAYER_FADE_READ_X))
+_Static_assert(CDPLAYER_FADE_RUN_FRAMES * 1000 / 75 >=
+                   2 * CDPLAYER_FADE_SEEK_MS + 2 * CDPLAYER_FADE_RUN_FRAMES * 1000 / (75 * CDPLAYER_FADE_READ_X),
+               "a fade run must play longer than it takes to fetch");
+static uint8_t readCdBufFade[CDPLAYER_FADE_RUN_FRAMES * 2352];
+static uint32_t fadeRunPos;    // 渐出缓冲里已经混掉的扇区 sectors of the fade buffer mixed so far
+static uint32_t fadeRunFrames; // 渐出缓冲里读到的扇区 sectors read into the fade buffer
+// 淡化换曲后读盘已经到了新音轨, 但环形缓冲区里的旧音轨还没播完; 这期间再换曲以新音轨为准
+// after a fading skip reading is already on the new track while the ring still plays the old
+// one; another skip in the meantime counts from the new track
+static int8_t skipPending = -1;
+
+// 搜索试听: 播放中按住上/下一曲时每次播一小段, 再按倍率跳到下一段, 每段两头淡入淡出; 环形缓冲区照常读满,
+// 驱动器寻道的时间由缓冲区盖住
+// audible scan: holding NEXT/PREV while playing plays short fragments and jumps by the skip ratio
+// between them, fading each fragment in and out; the ring is kept full as usual so it covers the
+// drive's seek time
+#define CDPLAYER_SCAN_FRAGMENT_FRAMES I2S_TX_BUFFER_SIZE_FRAME // 一段一个缓冲区 one buffer per fragment
+#define CDPLAYER_SCAN_FADE_FRAMES 256                          // 约 6ms about 6ms
+#define CDPLAYER_SCAN_RATIO_MIN 2
+#define CDPLAYER_SCAN_RATIO_MAX 30
+static int8_t scanDir = 0;        // 1 向前, -1 向后, 0 没有在搜索 1 forward, -1 backward, 0 not scanning
+static bool scanAtStart = false;  // 向后退到了光盘开头, 从那里正常播放 reached the disc start going back, plays on normally from there
+
+// 音轨的响度增益在开始读这个音轨时取一次, 后台扫描在播放中途测完也不会突然改变音量
+// the loudness gain of a track is taken once when reading of that track starts, so a background
+// scan finishing halfway through does not change the level suddenly
+static int8_t gainTrack = -1;
+static uint16_t gainValue = I2S_TRACK_GAIN_UNITY;
+
+static uint16_t trackGain(int8_t track)
+{
+    if (track != gainTrack) {
+        gainTrack = track;
+        gainValue = cdloudness_getTrackGain(track);
+    }
+    return gainValue;
+}
+
 static void printMem(uint8_t *dat, uint16_t size)
 {
     for (int i = 0; i < size; i++) printf("%02x ", dat[i]);
@@ -338,12 +434,225 @@ static esp_err_t cpplayer_getCdText(char **albumTitle, char **albumPerformer,
     return ESP_OK;
 }
 
+// 界面用到的字段, 按组放, 每组整体比较; 两份都整个拷贝, 填充字节也一致
+// the fields the GUI uses, grouped so each group compares as a whole; both copies are always
+// copied whole, so the padding matches too
+typedef struct
+{
+    struct {
+        uint8_t opened;
+        uint8_t trayClosed;
+        uint8_t discInserted;
+        uint8_t discIsCD;
+        char vendor[9];
+        char product[17];
+    } drive;
+    struct {
+        uint8_t readyToPlay;
+        uint8_t cdText;
+        uint8_t trackCount;
+        const char *albumTitle;
+    } disc;
+    int8_t track;
+    struct {
+        uint8_t playing;
+        uint8_t fastForwarding;
+        uint8_t fastBackwarding;
+    } transport;
+    int8_t volume;
+    uint8_t crossfeed;
+    int32_t frame;
+} guiState_t;
+
+// 写这些字段的有好几个线程 (还有 USB 驱动), 在这一个地方比较比在每个写的地方通知更不容易漏;
+// 只有这里写版本号
+// several tasks write these fields (the USB driver too), and comparing in one place misses less
+// than notifying at every write; only this writes the versions
+static void cdplayer_publishState()
+{
+    static guiState_t last;
+    guiState_t now;
+    memset(&now, 0, sizeof(now));
+
+    now.drive.opened       = usbhost_driverObj.deviceIsOpened;
+    now.drive.trayClosed   = cdplayer_driveInfo.trayClosed;
+    now.drive.discInserted = cdplayer_driveInfo.discInserted;
+    now.drive.discIsCD     = cdplayer_driveInfo.discIsCD;
+    memcpy(now.drive.vendor,  cdplayer_driveInfo.vendor,  sizeof(now.drive.vendor));
+    memcpy(now.drive.product, cdplayer_driveInfo.product, sizeof(now.drive.product));
+    now.disc.readyToPlay = cdplayer_driveInfo.readyToPlay;
+    now.disc.cdText      = cdplayer_driveInfo.cdTextAvalibale;
+    now.disc.trackCount  = cdplayer_driveInfo.trackCount;
+    now.disc.albumTitle  = cdplayer_driveInfo.albumTitle;
+    now.track = cdplayer_playerInfo.playingTrackIndex;
+    now.transport.playing         = cdplayer_playerInfo.playing;
+    now.transport.fastForwarding  = cdplayer_playerInfo.fastForwarding;
+    now.transport.fastBackwarding = cdplayer_playerInfo.fastBackwarding;
+    now.volume    = cdplayer_playerInfo.volume;
+    now.crossfeed = cdplayer_playerInfo.crossfeed;
+    now.frame     = cdplayer_playerInfo.readFrameCount;
+
+    if (memcmp(&now.drive, &last.drive, sizeof(now.drive)) != 0)             cdplayer_stateVersion[CDPLAYER_STATE_DRIVE]++;
+    if (memcmp(&now.disc, &last.disc, sizeof(now.disc)) != 0)                cdplayer_stateVersion[CDPLAYER_STATE_DISC]++;
+    if (now.track != last.track)                                             cdplayer_stateVersion[CDPLAYER_STATE_TRACK]++;
+    if (memcmp(&now.transport, &last.transport, sizeof(now.transport)) != 0) cdplayer_stateVersion[CDPLAYER_STATE_TRANSPORT]++;
+    if (now.volume != last.volume)                                           cdplayer_stateVersion[CDPLAYER_STATE_VOLUME]++;
+    if (now.crossfeed != last.crossfeed)                                     cdplayer_stateVersion[CDPLAYER_STATE_CROSSFEED]++;
+    if (now.frame != last.frame)                                             cdplayer_stateVersion[CDPLAYER_STATE_POSITION]++;
+    last = now;
+}
+
 static void volumeStep(int upDown)
 {
     cdplayer_playerInfo.volume += upDown;
     if (cdplayer_playerInfo.volume > 30) cdplayer_playerInfo.volume = 30;
     if (cdplayer_playerInfo.volume < 0)  cdplayer_playerInfo.volume = 0;
     ESP_LOGI("volumeStep", "Volume: %d", cdplayer_playerInfo.volume);
+    if (cdplayer_playerInfo.playing) i2s_probeLatency(I2S_PROBE_NEXT_BLOCK);
+}
+
+// 跳到某音轨某扇区, 读盘从那里重新开始, 还没播的缓冲区丢掉
+// jump to a sector of a track: reading restarts there and buffers not played yet are dropped
+static void cdplayer_seek(int8_t track, uint32_t frame)
+{
+    cdplayer_playerInfo.playingTrackIndex = track;
+    cdplayer_playerInfo.readFrameCount = frame;
+    readTrack = track;
+    readFrame = frame;
+    fadeTrack = -1;
+    skipPending = -1;
+    i2s_flush();
+}
+
+// 从某音轨某扇区开始渐出 frames 个扇区
+// start fading out frames sectors from a sector of a track
+static void cdplayer_startFade(int8_t track, uint32_t frame, uint32_t frames)
+{
+    uint32_t remain = cdplayer_driveInfo.trackList[track].trackDuration - frame;
+    if (frames > remain)
+        frames = remain;
+    if (frames == 0)
+        return;
+
+    fadeTrack = track;
+    fadeFrame = frame;
+    fadeRemain = frames;
+    fadeDone = 0;
+    fadeLen = frames * (2352 / 4);
+    fadeRunPos = 0;
+    fadeRunFrames = 0;
+}
+
+// 当前档位的环形缓冲区能不能盖住淡化时的寻道
+// whether the ring of the current profile covers the seeking a fade does
+static bool cdplayer_canFade(void)
+{
+    return cdplayer_playerInfo.crossfadeSec > 0 && i2s_getRingMaxMs() >= CDPLAYER_FADE_RING_MS;
+}
+
+// 渐出的一路读下一段, 读失败就直接切掉
+// read the next run of the stream fading out; on failure it is just cut
+static bool cdplayer_readFadeRun(void)
+{
+    uint32_t runFrames = (fadeRemain < CDPLAYER_FADE_RUN_FRAMES) ? fadeRemain : CDPLAYER_FADE_RUN_FRAMES;
+    uint32_t runBytes  = runFrames * 2352;
+    uint32_t runLba    = cdplayer_driveInfo.trackList[fadeTrack].lbaBegin + fadeFrame;
+    if (usbhost_scsi_readCD(runLba, readCdBufFade, &runFrames, &runBytes) != ESP_OK) {
+        log_sense_once("ReadCD fade");
+        fadeTrack = -1;
+        return false;
+    }
+    fadeFrame += runFrames;
+    fadeRunPos = 0;
+    fadeRunFrames = runFrames;
+    return true;
+}
+
+// 把渐出的一路混进刚读到的 frames 个扇区
+// mix the stream fading out into the frames sectors just read
+static void cdplayer_mixFade(uint8_t *buf, uint32_t frames)
+{
+    uint32_t want = (fadeRemain < frames) ? fadeRemain : frames;
+    uint32_t mixed = 0;
+    while (mixed < want) {
+        if (fadeRunPos == fadeRunFrames && !cdplayer_readFadeRun())
+            return;
+        uint32_t n = want - mixed;
+        if (n > fadeRunFrames - fadeRunPos)
+            n = fadeRunFrames - fadeRunPos;
+        audio_mix_crossfadeS16((int16_t *)(buf + mixed * 2352), (const int16_t *)(readCdBufFade + fadeRunPos * 2352),
+                               n * (2352 / 4), fadeDone, fadeLen);
+        fadeDone   += n * (2352 / 4);
+        fadeRunPos += n;
+        fadeRemain -= n;
+        mixed      += n;
+    }
+    if (fadeRemain == 0) fadeTrack = -1;
+}
+
+// 换曲从哪个音轨算起
+// the track a skip counts from
+static int8_t cdplayer_skipBase(void)
+{
+    return (skipPending >= 0) ? skipPending : cdplayer_playerInfo.playingTrackIndex;
+}
+
+// 交叉淡化模式下手动换曲: 不清环形缓冲区, 里面的旧音轨照常播完; 旧音轨从读盘位置接着渐出, 读盘换到新音轨
+// 渐入, 中间没有空白也不丢扇区. 已经在淡化, 或读盘已经越过了正在播的音轨时直接跳
+// a manual skip in crossfade mode: the ring is not flushed and the old track in it plays out; the
+// old track fades out from the read position on while reading moves to the new track, which fades
+// in, with no gap and no sector lost. When already fading, or when reading has gone past the
+// track being played, it just jumps
+static void cdplayer_skipTo(int8_t track)
+{
+    bool fade = cdplayer_canFade() && cdplayer_playerInfo.playing && fadeTrack < 0 &&
+                scanDir == 0 && readTrack == cdplayer_skipBase();
+    if (!fade) {
+        cdplayer_seek(track, 0);
+        return;
+    }
+
+    cdplayer_startFade(readTrack, readFrame, CDPLAYER_SKIP_FADE_FRAMES);
+    readTrack = track;
+    readFrame = 0;
+    skipPending = track;
+}
+
+// 从正在听到的位置开始搜索, 还没播的缓冲区丢掉
+// start scanning from the position being heard; buffers not played yet are dropped
+static void cdplayer_startScan(int8_t dir)
+{
+    scanDir = dir;
+    scanAtStart = false;
+    cdplayer_seek(cdplayer_playerInfo.playingTrackIndex, cdplayer_playerInfo.readFrameCount);
+}
+
+// 一段读完后跳到下一段: 向前再跳过 (倍率 - 1) 段, 向后退回 (倍率 + 1) 段, 都可以跨过音轨
+// after reading a fragment jump to the next one: forward skips another (ratio - 1) fragments,
+// backward goes back (ratio + 1), both across track boundaries
+static void cdplayer_scanJump(void)
+{
+    if (scanDir > 0) {
+        readFrame += CDPLAYER_SCAN_FRAGMENT_FRAMES * (cdplayer_playerInfo.scanRatio - 1);
+        while (readTrack < cdplayer_driveInfo.trackCount &&
+               readFrame >= cdplayer_driveInfo.trackList[readTrack].trackDuration) {
+            readFrame -= cdplayer_driveInfo.trackList[readTrack].trackDuration;
+            readTrack++;
+        }
+    } else if (scanDir < 0 && !scanAtStart) {
+        uint32_t back = CDPLAYER_SCAN_FRAGMENT_FRAMES * (cdplayer_playerInfo.scanRatio + 1);
+        while (back > readFrame) {
+            if (readTrack == 0) {
+                readFrame = 0;
+                scanAtStart = true;
+                return;
+            }
+            back -= readFrame;
+            readTrack--;
+            readFrame = cdplayer_driveInfo.trackList[readTrack].trackDuration;
+        }
+        readFrame -= back;
+    }
 }
 
 static void cdplayer_task_deviceAndDiscMonitor(void *arg)
@@ -365,8 +674,7 @@ static void cdplayer_task_deviceAndDiscMonitor(void *arg)
         cdplayer_driveInfo.strBuf_performers = NULL;
 
         cdplayer_playerInfo.playing            = 0;
-        cdplayer_playerInfo.playingTrackIndex  = 0;
-        cdplayer_playerInfo.readFrameCount     = 0;
+        cdplayer_seek(0, 0);
 
         strcpy(cdplayer_driveInfo.vendor, "");
         strcpy(cdplayer_driveInfo.product, "");
@@ -469,6 +777,7 @@ static void cdplayer_task_deviceAndDiscMonitor(void *arg)
                 printf("\n");
         }
 
+        cdloudness_discLoaded();
         cdplayer_driveInfo.readyToPlay = 1;
         vTaskDelay(pdMS_TO_TICKS(2000));
 
@@ -504,8 +813,18 @@ static void cdplayer_task_playControl(void *arg)
         vTaskDelay(pdMS_TO_TICKS(10));
         btn_renew(0);
 
+        // 长按弹出键切换耳机交叉馈送强度, 松开时不再弹出
+        static bool ejectHeld = false;
+        if (btn_getLongPress(BTN_EJECT, 0) && !ejectHeld) {
+            ejectHeld = true;
+            cdplayer_setCrossfeed((cdplayer_playerInfo.crossfeed + 1) % AUDIO_CROSSFEED_LEVELS);
+            ESP_LOGI("cdplayer_task_playControl", "Crossfeed: %d", cdplayer_playerInfo.crossfeed);
+        }
+
         // 弹出碟片：loej=1,start=0
-        if (btn_getPosedge(BTN_EJECT)) {
+        if (btn_getPosedge(BTN_EJECT) && ejectHeld) {
+            ejectHeld = false;
+        } else if (btn_getPosedge(BTN_EJECT)) {
             if (usbhost_driverObj.deviceIsOpened == 1) {
                 ESP_LOGI("cdplayer_task_playControl", "Eject disc");
                 cdplayer_playerInfo.playing = 0;
@@ -547,42 +866,222 @@ static void cdplayer_task_playControl(void *arg)
             ESP_LOGI("cdplayer_task_playControl", "volume saved.");
         }
 
-        // 快进快退
+        // 保存均衡器（非播放时）
+        if (eqHasChange && !cdplayer_playerInfo.playing) {
+            eqHasChange = false;
+            audio_eq_band_t bands[AUDIO_EQ_BANDS];
+            audio_eq_getBands(bands);
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_blob(h, "eq", bands, sizeof(bands));
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "eq saved.");
+        }
+
+        // 重采样超出 CPU 预算, 降一档（不保存）
+        if (i2s_takeSrcOverBudget() && cdplayer_playerInfo.srcQuality > AUDIO_SRC_LOW) {
+            cdplayer_playerInfo.srcQuality--;
+            ESP_LOGW("cdplayer_task_playControl", "resampler quality -> %d", cdplayer_playerInfo.srcQuality);
+            i2s_setOutputRate(cdplayer_playerInfo.outputRate, cdplayer_playerInfo.srcQuality);
+        }
+
+        // 音频处理连续超出时限, 打印各环节耗时
+        if (i2s_takeDeadlineMiss()) {
+            i2s_logGraph();
+        }
+
+        // 从模式下外部时钟不在设置的输出采样率上, 改成跟它一致（停止后保存）
+        uint32_t clockRate = i2s_takeClockMismatch();
+        if (clockRate) {
+            cdplayer_setOutputRate(clockRate, cdplayer_playerInfo.srcQuality);
+        }
+
+        // 保存输出采样率（非播放时）
+        if (outputRateHasChange && !cdplayer_playerInfo.playing) {
+            outputRateHasChange = false;
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_u32(h, "rate", cdplayer_playerInfo.outputRate);
+            nvs_set_u8(h, "srcq", cdplayer_playerInfo.srcQuality);
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "output rate saved.");
+        }
+
+        // 保存抖动方式（非播放时）
+        if (ditherHasChange && !cdplayer_playerInfo.playing) {
+            ditherHasChange = false;
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_u8(h, "dith", cdplayer_playerInfo.ditherMode);
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "dither saved.");
+        }
+
+        // 保存交叉淡化长度（非播放时）
+        if (crossfadeHasChange && !cdplayer_playerInfo.playing) {
+            crossfadeHasChange = false;
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_u8(h, "xfade", cdplayer_playerInfo.crossfadeSec);
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "crossfade saved.");
+        }
+
+        // 保存响度归一化开关（非播放时）
+        if (loudnessNormHasChange && !cdplayer_playerInfo.playing) {
+            loudnessNormHasChange = false;
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_u8(h, "lnorm", cdplayer_playerInfo.loudnessNorm);
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "loudness normalization saved.");
+        }
+
+        // 保存压缩/限幅设置（非播放时）
+        if (dynamicsHasChange && !cdplayer_playerInfo.playing) {
+            dynamicsHasChange = false;
+            audio_dynamics_config_t dyn;
+            i2s_getDynamics(&dyn);
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_blob(h, "dyn", &dyn, sizeof(dyn));
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "dynamics saved.");
+        }
+
+        // 保存声道矩阵设置（非播放时）
+        if (matrixHasChange && !cdplayer_playerInfo.playing) {
+            matrixHasChange = false;
+            audio_matrix_config_t matrix;
+            i2s_getChannelMatrix(&matrix);
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_blob(h, "chmx", &matrix, sizeof(matrix));
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "channel matrix saved.");
+        }
+
+        // 保存交叉馈送强度（非播放时）
+        if (crossfeedHasChange && !cdplayer_playerInfo.playing) {
+            crossfeedHasChange = false;
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_u8(h, "xfeed", cdplayer_playerInfo.crossfeed);
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "crossfeed saved.");
+        }
+
+        // 保存搜索倍率（非播放时）
+        if (scanRatioHasChange && !cdplayer_playerInfo.playing) {
+            scanRatioHasChange = false;
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_u8(h, "scan", cdplayer_playerInfo.scanRatio);
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "scan ratio saved.");
+        }
+
+        // 保存延迟档位（非播放时）
+        if (latencyHasChange && !cdplayer_playerInfo.playing) {
+            latencyHasChange = false;
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_u8(h, "lat", cdplayer_playerInfo.latencyProfile);
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "latency profile saved.");
+        }
+
+        // 保存逐位直通开关（非播放时）
+        if (bitPerfectHasChange && !cdplayer_playerInfo.playing) {
+            bitPerfectHasChange = false;
+            nvs_handle_t h;
+            nvs_open("storage", NVS_READWRITE, &h);
+            nvs_set_u8(h, "bitp", cdplayer_playerInfo.bitPerfect);
+            nvs_commit(h);
+            nvs_close(h);
+            ESP_LOGI("cdplayer_task_playControl", "bit-perfect saved.");
+        }
+
+        // 逐位直通时, 每次停止播放打印一次校验结果, 然后重新统计
+        static bool verifyLogged = true;
+        if (cdplayer_playerInfo.playing) {
+            verifyLogged = false;
+        } else if (cdplayer_playerInfo.bitPerfect && !verifyLogged) {
+            verifyLogged = true;
+            i2s_verify_t v;
+            i2s_getVerify(&v);
+            if (v.sectors || v.processed) {
+                ESP_LOGI("cdplayer_task_playControl", "bit-perfect check: %lu sectors, %lu mismatched, %lu processed, %lu cycles/sector",
+                         v.sectors, v.mismatched, v.processed, v.cycles);
+                i2s_verifyStart();
+            }
+        }
+
+        // 快进快退: 播放中边跳边听, 暂停时不出声只移动位置
         if (btn_getLongPress(BTN_NEXT, 0)) {
             if (cdplayer_driveInfo.readyToPlay == 1) {
+                if (!cdplayer_playerInfo.fastForwarding && cdplayer_playerInfo.playing)
+                    cdplayer_startScan(1);
                 cdplayer_playerInfo.fastForwarding = 1;
-                cdplayer_playerInfo.readFrameCount += 5;
-                if (cdplayer_playerInfo.readFrameCount >
-                    cdplayer_driveInfo.trackList[cdplayer_playerInfo.playingTrackIndex].trackDuration)
-                    cdplayer_playerInfo.readFrameCount =
-                        cdplayer_driveInfo.trackList[cdplayer_playerInfo.playingTrackIndex].trackDuration;
+                if (scanDir == 0) {
+                    cdplayer_playerInfo.readFrameCount += 5;
+                    if (cdplayer_playerInfo.readFrameCount >
+                        cdplayer_driveInfo.trackList[cdplayer_playerInfo.playingTrackIndex].trackDuration)
+                        cdplayer_playerInfo.readFrameCount =
+                            cdplayer_driveInfo.trackList[cdplayer_playerInfo.playingTrackIndex].trackDuration;
+                }
             }
         } else if (btn_getLongPress(BTN_PREVIOUS, 0)) {
             if (cdplayer_driveInfo.readyToPlay == 1) {
+                if (!cdplayer_playerInfo.fastBackwarding && cdplayer_playerInfo.playing)
+                    cdplayer_startScan(-1);
                 cdplayer_playerInfo.fastBackwarding = 1;
-                if (cdplayer_playerInfo.readFrameCount >= 5) cdplayer_playerInfo.readFrameCount -= 5;
-                else cdplayer_playerInfo.readFrameCount = 0;
+                if (scanDir == 0) {
+                    if (cdplayer_playerInfo.readFrameCount >= 5) cdplayer_playerInfo.readFrameCount -= 5;
+                    else cdplayer_playerInfo.readFrameCount = 0;
+                }
             }
         }
 
-        // 上/下一曲
+        // 上/下一曲, 快进快退松开时从听到的位置接着读; 退到光盘开头后已经在正常播放, 不用再跳
         if (btn_getPosedge(BTN_NEXT)) {
-            if (cdplayer_playerInfo.fastForwarding) cdplayer_playerInfo.fastForwarding = 0;
+            if (cdplayer_playerInfo.fastForwarding) {
+                cdplayer_playerInfo.fastForwarding = 0;
+                scanDir = 0;
+                cdplayer_seek(cdplayer_playerInfo.playingTrackIndex, cdplayer_playerInfo.readFrameCount);
+            }
             else if (cdplayer_driveInfo.readyToPlay == 1) {
-                cdplayer_playerInfo.readFrameCount = 0;
-                cdplayer_playerInfo.playingTrackIndex++;
-                if (cdplayer_playerInfo.playingTrackIndex >= cdplayer_driveInfo.trackCount)
-                    cdplayer_playerInfo.playingTrackIndex = 0;
-                ESP_LOGI("cdplayer_task_playControl", "Next, track: %d", cdplayer_playerInfo.playingTrackIndex);
+                int8_t track = cdplayer_skipBase() + 1;
+                if (track >= cdplayer_driveInfo.trackCount)
+                    track = 0;
+                cdplayer_skipTo(track);
+                if (cdplayer_playerInfo.playing) i2s_probeLatency(I2S_PROBE_NEXT_BLOCK);
+                ESP_LOGI("cdplayer_task_playControl", "Next, track: %d", track);
             }
         } else if (btn_getPosedge(BTN_PREVIOUS)) {
-            if (cdplayer_playerInfo.fastBackwarding) cdplayer_playerInfo.fastBackwarding = 0;
+            if (cdplayer_playerInfo.fastBackwarding) {
+                cdplayer_playerInfo.fastBackwarding = 0;
+                if (!(scanDir != 0 && scanAtStart && cdplayer_playerInfo.playing))
+                    cdplayer_seek(cdplayer_playerInfo.playingTrackIndex, cdplayer_playerInfo.readFrameCount);
+                scanDir = 0;
+            }
             else if (cdplayer_driveInfo.readyToPlay == 1) {
-                cdplayer_playerInfo.readFrameCount = 0;
-                cdplayer_playerInfo.playingTrackIndex--;
-                if (cdplayer_playerInfo.playingTrackIndex < 0)
-                    cdplayer_playerInfo.playingTrackIndex = cdplayer_driveInfo.trackCount - 1;
-                ESP_LOGI("cdplayer_task_playControl", "Previous, play: %d", cdplayer_playerInfo.playingTrackIndex);
+                int8_t track = cdplayer_skipBase() - 1;
+                if (track < 0)
+                    track = cdplayer_driveInfo.trackCount - 1;
+                cdplayer_skipTo(track);
+                if (cdplayer_playerInfo.playing) i2s_probeLatency(I2S_PROBE_NEXT_BLOCK);
+                ESP_LOGI("cdplayer_task_playControl", "Previous, play: %d", track);
             }
         }
 
@@ -591,6 +1090,8 @@ static void cdplayer_task_playControl(void *arg)
             if (cdplayer_driveInfo.readyToPlay == 1) {
                 cdplayer_playerInfo.playing = !cdplayer_playerInfo.playing;
                 ESP_LOGI("cdplayer_task_playControl", "Play: %d", cdplayer_playerInfo.playing);
+                // 量一下从按键到听到开始/停下要多久
+                i2s_probeLatency(cdplayer_playerInfo.playing ? I2S_PROBE_NEXT_BLOCK : I2S_PROBE_DRAIN);
                 if (cdplayer_playerInfo.playing) {
                     esp_err_t err = usbhost_scsi_setCDSpeed(65535);
                     if (err != ESP_OK) log_sense_once("Set speed");
@@ -598,42 +1099,123 @@ static void cdplayer_task_playControl(void *arg)
             }
         }
 
-        // 读盘送 I2S
+        // 不出声地快进快退时不读盘, 位置由按键直接移动
+        bool silentSeek = (cdplayer_playerInfo.fastForwarding || cdplayer_playerInfo.fastBackwarding) && scanDir == 0;
+
+        // 播放位置跟着 I2S 实际送出的扇区走, 音轨切换也从这里得知; 搜索时就是正在听的那一段
+        if (cdplayer_playerInfo.playing && !silentSeek) {
+            int8_t track;
+            uint32_t frame;
+            if (i2s_getPlayPosition(&track, &frame)) {
+                if (track != cdplayer_playerInfo.playingTrackIndex)
+                    ESP_LOGI("cdplayer_task_playControl", "Play next track: %02d", track + 1);
+                cdplayer_playerInfo.playingTrackIndex = track;
+                cdplayer_playerInfo.readFrameCount = frame;
+                if (track == skipPending)
+                    skipPending = -1;
+            }
+        }
+
+        // 快进到音轨末尾时从下一音轨开头读
+        if (readTrack < cdplayer_driveInfo.trackCount &&
+            readFrame >= cdplayer_driveInfo.trackList[readTrack].trackDuration) {
+            readFrame = 0;
+            readTrack++;
+        }
+
+        // 交叉淡化模式下音轨快结束时, 读盘跳到下一音轨开头, 剩下的部分作为渐出的一路;
+        // 音轨比两倍淡化时长还短时只淡化后一半
+        // 淡化期间和快到音轨结尾的淡化时, 环形缓冲区保持最深
+        bool fadeSoon = false;
         if (cdplayer_driveInfo.readyToPlay == 1 && cdplayer_playerInfo.playing &&
-            !cdplayer_playerInfo.fastForwarding && !cdplayer_playerInfo.fastBackwarding &&
-            !i2s_bufsFull)
+            cdplayer_canFade() && fadeTrack < 0 && scanDir == 0 &&
+            readTrack + 1 < cdplayer_driveInfo.trackCount) {
+            uint32_t remainFrame = cdplayer_driveInfo.trackList[readTrack].trackDuration - readFrame;
+            if (remainFrame <= cdplayer_playerInfo.crossfadeSec * 75u && remainFrame <= readFrame) {
+                cdplayer_startFade(readTrack, readFrame, remainFrame);
+                readTrack++;
+                readFrame = 0;
+            } else if (remainFrame <= cdplayer_playerInfo.crossfadeSec * 75u + I2S_BUF_NUM * I2S_TX_BUFFER_SIZE_FRAME) {
+                fadeSoon = true;
+            }
+        }
+        i2s_holdDepth(fadeTrack >= 0 || fadeSoon);
+
+        // 告诉 I2S 还要不要送数据, 不送时缓冲区排空不算断流
+        i2s_setStreaming(cdplayer_driveInfo.readyToPlay == 1 && cdplayer_playerInfo.playing && !silentSeek &&
+                         readTrack < cdplayer_driveInfo.trackCount && !bt_is_active());
+
+        // 读盘送 I2S; 下一音轨紧接着本音轨时一次读过边界, 不停顿
+        if (cdplayer_driveInfo.readyToPlay == 1 && cdplayer_playerInfo.playing && !silentSeek &&
+            !i2s_bufsFull && readTrack < cdplayer_driveInfo.trackCount)
         {
-            int8_t *trackNo = &cdplayer_playerInfo.playingTrackIndex;
-            uint32_t trackDuration = cdplayer_driveInfo.trackList[*trackNo].trackDuration;
-            int32_t *readFrameCount = &cdplayer_playerInfo.readFrameCount;
-            uint32_t remainFrame = trackDuration - *readFrameCount;
+            cdplayer_trackInfo_t *track = &cdplayer_driveInfo.trackList[readTrack];
+            cdplayer_trackInfo_t *next = (readTrack + 1 < cdplayer_driveInfo.trackCount) ? track + 1 : NULL;
+            uint32_t remainFrame = track->trackDuration - readFrame;
+
+            i2s_bufPos_t pos = {
+                .track = readTrack,
+                .frame = readFrame,
+                .preEmphasis = track->preEmphasis,
+                .gain = {trackGain(readTrack), I2S_TRACK_GAIN_UNITY},
+            };
+
+            // 每次读多少扇区由延迟档位决定, 搜索时一段固定一个缓冲区
+            uint32_t readFrames = (scanDir != 0) ? CDPLAYER_SCAN_FRAGMENT_FRAMES : i2s_getReadSectors();
+            if (remainFrame < readFrames) {
+                if (next != NULL && next->lbaBegin == track->lbaBegin + track->trackDuration) {
+                    if (remainFrame + next->trackDuration < readFrames)
+                        readFrames = remainFrame + next->trackDuration;
+                    pos.preEmphasis |= next->preEmphasis << 1;
+                    pos.gain[1] = trackGain(readTrack + 1);
+                } else {
+                    // 光盘末尾或下一音轨不连续 (中间隔着数据轨), 只读剩下的
+                    readFrames = remainFrame;
+                }
+            }
+            pos.frames = readFrames;
+            pos.nextAt = (remainFrame < readFrames) ? remainFrame : readFrames;
 
-            uint32_t readFrames = (remainFrame > I2S_TX_BUFFER_SIZE_FRAME) ? I2S_TX_BUFFER_SIZE_FRAME : remainFrame;
-            uint32_t readBytes  = readFrames * 2352;
-            uint32_t readLba    = cdplayer_driveInfo.trackList[*trackNo].lbaBegin + *readFrameCount;
+            uint32_t readBytes = readFrames * 2352;
+            uint32_t readLba   = track->lbaBegin + readFrame;
 
+            i2s_readBegin();
+            // 渐出的一路先读下一段: 手动换曲时驱动器正好停在那里, 不用寻道
+            if (fadeTrack >= 0 && fadeRunPos == fadeRunFrames)
+                cdplayer_readFadeRun();
             esp_err_t err = usbhost_scsi_readCD(readLba, readCdBuf, &readFrames, &readBytes);
+
+            // 渐出的一路从自己的缓冲里混进来, 用完了再读一段
+            if (err == ESP_OK && fadeTrack >= 0)
+                cdplayer_mixFade(readCdBuf, readFrames);
+
+            // 搜索时每段两头淡入淡出, 段与段之间不会有咔嗒声
+            if (err == ESP_OK && scanDir != 0 && !scanAtStart)
+                audio_mix_fadeEdgesS16((int16_t *)readCdBuf, readFrames * (2352 / 4), CDPLAYER_SCAN_FADE_FRAMES);
+
             if (err == ESP_OK) {
-                if (!bt_is_active()) { i2s_fillBuffer(readCdBuf); }
-                *readFrameCount += readFrames;
+                if (!bt_is_active()) { i2s_fillBuffer(readCdBuf, &pos); }
+                readFrame += readFrames;
+                if (readFrame >= track->trackDuration) {
+                    readFrame -= track->trackDuration;
+                    readTrack++;
+                }
+                cdplayer_scanJump();
             } else {
                 printf("Read fail, lba: %ld len(bytes): %ld\n", readLba, readBytes);
                 log_sense_once("ReadCD");
             }
+        }
 
-            // 当前曲目结束
-            if (*readFrameCount >= trackDuration) {
-                *readFrameCount = 0;
-                (*trackNo)++;
-                if (*trackNo >= cdplayer_driveInfo.trackCount) {
-                    cdplayer_playerInfo.playing = 0;
-                    *trackNo = 0;
-                    ESP_LOGI("cdplayer_task_playControl", "Finish");
-                } else {
-                    ESP_LOGI("cdplayer_task_playControl", "Play next track: %02d", (*trackNo) + 1);
-                }
-            }
+        // 读到光盘末尾, 等缓冲区播完再停
+        if (cdplayer_playerInfo.playing && readTrack >= cdplayer_driveInfo.trackCount && i2s_bufsEmpty) {
+            cdplayer_playerInfo.playing = 0;
+            cdplayer_seek(0, 0);
+            ESP_LOGI("cdplayer_task_playControl", "Finish");
         }
+
+        // 告诉界面这一轮哪些状态变了
+        cdplayer_publishState();
     }
 }
 
@@ -645,7 +1227,65 @@ void cdplay_init(void)
     nvs_open("storage", NVS_READWRITE, &my_handle);
     err = nvs_get_i8(my_handle, "vol", &cdplayer_playerInfo.volume);
     if (err != ESP_OK) cdplayer_playerInfo.volume = 10;
+
+    // 读均衡器
+    audio_eq_band_t bands[AUDIO_EQ_BANDS];
+    size_t bandsSize = sizeof(bands);
+    err = nvs_get_blob(my_handle, "eq", bands, &bandsSize);
+    if (err == ESP_OK && bandsSize == sizeof(bands)) audio_eq_setBands(bands);
+
+    // 读输出采样率
+    if (nvs_get_u32(my_handle, "rate", &cdplayer_playerInfo.outputRate) != ESP_OK) cdplayer_playerInfo.outputRate = 44100;
+    if (nvs_get_u8(my_handle, "srcq", &cdplayer_playerInfo.srcQuality) != ESP_OK) cdplayer_playerInfo.srcQuality = AUDIO_SRC_HIGH;
+
+    // 读交叉淡化长度, 0 为无缝播放
+    if (nvs_get_u8(my_handle, "xfade", &cdplayer_playerInfo.crossfadeSec) != ESP_OK) cdplayer_playerInfo.crossfadeSec = 0;
+
+    // 读响度归一化开关
+    if (nvs_get_u8(my_handle, "lnorm", &cdplayer_playerInfo.loudnessNorm) != ESP_OK) cdplayer_playerInfo.loudnessNorm = 0;
+
+    // 读交叉馈送强度
+    if (nvs_get_u8(my_handle, "xfeed", &cdplayer_playerInfo.crossfeed) != ESP_OK) cdplayer_playerInfo.crossfeed = AUDIO_CROSSFEED_OFF;
+
+    // 读搜索倍率
+    if (nvs_get_u8(my_handle, "scan", &cdplayer_playerInfo.scanRatio) != ESP_OK) cdplayer_playerInfo.scanRatio = 8;
+    if (cdplayer_playerInfo.scanRatio < CDPLAYER_SCAN_RATIO_MIN || cdplayer_playerInfo.scanRatio > CDPLAYER_SCAN_RATIO_MAX)
+        cdplayer_playerInfo.scanRatio = 8;
+
+    // 读延迟档位
+    if (nvs_get_u8(my_handle, "lat", &cdplayer_playerInfo.latencyProfile) != ESP_OK ||
+        cdplayer_playerInfo.latencyProfile >= I2S_LATENCY_PROFILES)
+        cdplayer_playerInfo.latencyProfile = I2S_LATENCY_BALANCED;
+
+    // 读逐位直通开关
+    if (nvs_get_u8(my_handle, "bitp", &cdplayer_playerInfo.bitPerfect) != ESP_OK) cdplayer_playerInfo.bitPerfect = 0;
+
+    // 读压缩/限幅设置
+    audio_dynamics_config_t dyn;
+    size_t dynSize = sizeof(dyn);
+    err = nvs_get_blob(my_handle, "dyn", &dyn, &dynSize);
+    if (err == ESP_OK && dynSize == sizeof(dyn)) i2s_setDynamics(&dyn);
+
+    // 读声道矩阵设置
+    audio_matrix_config_t matrix;
+    size_t matrixSize = sizeof(matrix);
+    err = nvs_get_blob(my_handle, "chmx", &matrix, &matrixSize);
+    if (err == ESP_OK && matrixSize == sizeof(matrix)) i2s_setChannelMatrix(&matrix);
+
+    // 读抖动方式
+    if (nvs_get_u8(my_handle, "dith", &cdplayer_playerInfo.ditherMode) != ESP_OK) cdplayer_playerInfo.ditherMode = AUDIO_DITHER_TPDF;
     nvs_close(my_handle);
+    i2s_setOutputRate(cdplayer_playerInfo.outputRate, cdplayer_playerInfo.srcQuality);
+    if (cdplayer_playerInfo.bitPerfect) {
+        i2s_setBitPerfect(true);
+        i2s_verifyStart();
+    }
+    i2s_setDither(cdplayer_playerInfo.ditherMode);
+    i2s_setCrossfeed(cdplayer_playerInfo.crossfeed);
+    i2s_setLatencyProfile(cdplayer_playerInfo.latencyProfile);
+    cdplayer_playerInfo.speed = 100;
+
+    cdloudness_init();
 
     BaseType_t ret;
     ret = xTaskCreatePinnedToCore(cdplayer_task_deviceAndDiscMonitor,
@@ -659,6 +1299,141 @@ void cdplay_init(void)
     if (ret != pdPASS) ESP_LOGE("cdplay_init", "playControl create fail");
 }
 
+// 系数在调用线程里算好, 音频线程下一块开始交叉淡化过去; 停止播放后再写 flash
+// coefficients are computed on the caller's thread and the audio thread crossfades to them on
+// its next block; flash is written once playback stops
+void cdplayer_setEqBand(int index, const audio_eq_band_t *band)
+{
+    audio_eq_setBand(index, band);
+    eqHasChange = true;
+}
+
+// 44100 直通, 48000/96000 经过重采样; 停止播放后再写 flash
+// 44100 passes through, 48000/96000 go through the resampler; flash is written once playback stops
+void cdplayer_setOutputRate(uint32_t rate, uint8_t quality)
+{
+    cdplayer_playerInfo.outputRate = rate;
+    cdplayer_playerInfo.srcQuality = quality;
+    i2s_setOutputRate(rate, quality);
+    outputRateHasChange = true;
+}
+
+// 处理过的信号量化到 DAC 字长时用的抖动方式; 停止播放后再写 flash
+// dither used when processed audio is quantized to the DAC word length; flash is written once
+// playback stops
+void cdplayer_setDither(uint8_t mode)
+{
+    cdplayer_playerInfo.ditherMode = mode;
+    i2s_setDither(mode);
+    ditherHasChange = true;
+}
+
+// 音轨之间交叉淡化的秒数, 0 为无缝播放; 打开时手动换曲也会短暂淡化; 停止播放后再写 flash
+// seconds of crossfade between tracks, 0 for gapless; when on, manual skips get a short fade too;
+// flash is written once playback stops
+void cdplayer_setCrossfade(uint8_t sec)
+{
+    if (sec > CDPLAYER_CROSSFADE_MAX_SEC)
+        sec = CDPLAYER_CROSSFADE_MAX_SEC;
+    cdplayer_playerInfo.crossfadeSec = sec;
+    crossfadeHasChange = true;
+}
+
+// 按缓存的响度把每个音轨调到同一电平, 还没测的音轨在后台扫描; 下一个音轨开始生效; 停止播放后再写 flash
+// brings every track to the same level using the cached loudness; tracks not measured yet are
+// scanned in the background. Takes effect from the next track; flash is written once playback stops
+void cdplayer_setLoudnessNorm(uint8_t on)
+{
+    cdplayer_playerInfo.loudnessNorm = on ? 1 : 0;
+    gainTrack = -1;
+    loudnessNormHasChange = true;
+}
+
+// 耳机交叉馈送强度, 0 关闭; 立即生效, 停止播放后再写 flash
+// headphone crossfeed strength, 0 is off; takes effect at once, flash is written once playback stops
+void cdplayer_setCrossfeed(uint8_t level)
+{
+    if (level >= AUDIO_CROSSFEED_LEVELS)
+        level = AUDIO_CROSSFEED_OFF;
+    cdplayer_playerInfo.crossfeed = level;
+    i2s_setCrossfeed(level);
+    crossfeedHasChange = true;
+}
+
+// 夜间模式: 压缩器把响的段落压下来, 限幅器保证提高音量后也不会削波; 立即生效, 停止播放后再写 flash
+// night mode: the compressor brings loud passages down and the limiter keeps a raised volume
+// from clipping; takes effect at once, flash is written once playback stops
+void cdplayer_setDynamics(const audio_dynamics_config_t *cfg)
+{
+    i2s_setDynamics(cfg);
+    dynamicsHasChange = true;
+}
+
+// 平衡, 单声道合并, 左右互换, 反相和立体声宽度; 立即生效, 停止播放后再写 flash
+// balance, mono fold-down, channel swap, polarity and stereo width; takes effect at once, flash is
+// written once playback stops
+void cdplayer_setChannelMatrix(const audio_matrix_config_t *cfg)
+{
+    i2s_setChannelMatrix(cfg);
+    matrixHasChange = true;
+}
+
+// 快进快退时播一段跳几段, 即搜索速度是正常播放的几倍; 停止播放后再写 flash
+// how many fragments a scan moves per fragment played, i.e. scan speed as a multiple of normal
+// playback; flash is written once playback stops
+void cdplayer_setScanRatio(uint8_t ratio)
+{
+    if (ratio < CDPLAYER_SCAN_RATIO_MIN)
+        ratio = CDPLAYER_SCAN_RATIO_MIN;
+    if (ratio > CDPLAYER_SCAN_RATIO_MAX)
+        ratio = CDPLAYER_SCAN_RATIO_MAX;
+    cdplayer_playerInfo.scanRatio = ratio;
+    scanRatioHasChange = true;
+}
+
+// 练习/扒谱用的变速, 50% ~ 200%; keepPitch 时音高不变, quality 为 audio_wsola_quality_t. 立即生效, 不保存,
+// 开机总是原速
+// varispeed for practice and transcription, 50% ~ 200%; keepPitch keeps the pitch, quality is an
+// audio_wsola_quality_t. Takes effect at once and is not saved, so power-up is always normal speed
+void cdplayer_setSpeed(uint8_t percent, uint8_t keepPitch, uint8_t quality)
+{
+    if (percent < I2S_SPEED_MIN)
+        percent = I2S_SPEED_MIN;
+    if (percent > I2S_SPEED_MAX)
+        percent = I2S_SPEED_MAX;
+    cdplayer_playerInfo.speed = percent;
+    cdplayer_playerInfo.keepPitch = keepPitch ? 1 : 0;
+    i2s_setSpeed(percent, cdplayer_playerInfo.keepPitch, quality);
+}
+
+// 延迟档位 (i2s_latencyProfile_t): 用 DMA 和缓冲区的长度换按键生效的快慢, 缓冲越短读盘不稳时越容易断流;
+// 在两个缓冲区之间生效, 停止播放后再写 flash
+// latency profile (i2s_latencyProfile_t): trades the DMA and ring lengths, which set how soon a
+// button takes effect, against how easily an uneven drive causes an underrun; takes effect between
+// buffers, flash is written once playback stops
+void cdplayer_setLatencyProfile(uint8_t profile)
+{
+    if (profile >= I2S_LATENCY_PROFILES)
+        profile = I2S_LATENCY_BALANCED;
+    cdplayer_playerInfo.latencyProfile = profile;
+    i2s_setLatencyProfile(profile);
+    latencyHasChange = true;
+}
+
+// 逐位直通: 所有处理都不做, 光盘数据原样输出, 同时校验交给 I2S 的数据和光盘数据一致; 停止播放后再写 flash
+// bit-perfect pass-through: no processing at all and the disc data goes out untouched, while the
+// data handed to I2S is checked against the disc data; flash is written once playback stops
+void cdplayer_setBitPerfect(uint8_t on)
+{
+    cdplayer_playerInfo.bitPerfect = on ? 1 : 0;
+    i2s_setBitPerfect(on);
+    if (on)
+        i2s_verifyStart();
+    else
+        i2s_verifyStop();
+    bitPerfectHasChange = true;
+}
+
 hmsf_t cdplay_frameToHmsf(uint32_t frame)
 {
     int sec = frame / 75;
@@ -1,6 +1,10 @@
 #ifndef __CD_PLAYER_H_
 #define __CD_PLAYER_H_
 
+#include "audio_eq.h"
+#include "audio_dynamics.h"
+#include "audio_matrix.h"
+
 typedef struct
 {
     uint8_t trackNum;
@@ -36,6 +40,17 @@ typedef struct cdPlayer
     uint8_t fastBackwarding;
     int8_t playingTrackIndex;
     int32_t readFrameCount;
+    uint32_t outputRate;
+    uint8_t srcQuality;
+    uint8_t ditherMode;
+    uint8_t crossfadeSec;
+    uint8_t loudnessNorm;
+    uint8_t crossfeed;
+    uint8_t scanRatio;
+    uint8_t speed;      // 百分比 percent
+    uint8_t keepPitch;
+    uint8_t latencyProfile;
+    uint8_t bitPerfect;
 
 } cdplayer_playerInfo_t;
 
@@ -47,10 +62,40 @@ typedef struct
     uint8_t frame;
 } hmsf_t;
 
+// 界面用到的字段分组. 播放控制线程每轮把这些字段和上一轮比一次, 哪组变了就把那组的版本号加一;
+// 界面只在版本号变了时重新读那组字段, 刷新对应的部件
+// the fields the GUI shows, in groups. Every round the play control task compares them with the
+// previous round and bumps the version of each group that changed; the GUI rereads a group and
+// refreshes its widgets only when its version has moved
+typedef enum
+{
+    CDPLAYER_STATE_DRIVE = 0, // 光驱型号, 连接, 托盘, 有无光盘, 是否 CD drive model, connection, tray, disc present, is CD
+    CDPLAYER_STATE_DISC,      // 可以播放, 音轨数, CD-Text ready to play, track count, CD-Text
+    CDPLAYER_STATE_TRACK,     // 正在播放的音轨 track playing
+    CDPLAYER_STATE_TRANSPORT, // 播放, 快进, 快退 playing, fast forward, fast backward
+    CDPLAYER_STATE_VOLUME,
+    CDPLAYER_STATE_CROSSFEED,
+    CDPLAYER_STATE_POSITION,  // 音轨内的扇区 sector within the track
+    CDPLAYER_STATE_GROUPS,
+} cdplayer_stateGroup_t;
+
 extern cdplayer_driveInfo_t cdplayer_driveInfo;
 extern cdplayer_playerInfo_t cdplayer_playerInfo;
+extern volatile uint32_t cdplayer_stateVersion[CDPLAYER_STATE_GROUPS];
 
 void cdplay_init();
 hmsf_t cdplay_frameToHmsf(uint32_t frame);
+void cdplayer_setEqBand(int index, const audio_eq_band_t *band);
+void cdplayer_setOutputRate(uint32_t rate, uint8_t quality);
+void cdplayer_setDither(uint8_t mode);
+void cdplayer_setCrossfade(uint8_t sec);
+void cdplayer_setLoudnessNorm(uint8_t on);
+void cdplayer_setCrossfeed(uint8_t level);
+void cdplayer_setDynamics(const audio_dynamics_config_t *cfg);
+void cdplayer_setChannelMatrix(const audio_matrix_config_t *cfg);
+void cdplayer_setScanRatio(uint8_t ratio);
+void cdplayer_setSpeed(uint8_t percent, uint8_t keepPitch, uint8_t quality);
+void cdplayer_setLatencyProfile(uint8_t profile);
+void cdplayer_setBitPerfect(uint8_t on);
 
 #endif
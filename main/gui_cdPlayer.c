@@ -5,6 +5,8 @@
 #include <stdbool.h>
 
 #include "cdPlayer.h"
+#include "audio_spectrum.h"
+#include "audio_scope.h"
 #include "gui_cdPlayer.h"
 
 #define AREA_STATUS_BAR_HEIGHT 25
@@ -26,11 +28,17 @@ lv_obj_t *lb_trackPerformer;
 lv_obj_t *lb_preEmphasized;
 lv_obj_t *lb_time;
 lv_obj_t *lb_duration;
+lv_obj_t *lb_gainReduction;
 
 lv_obj_t *bar_playProgress;
 lv_obj_t *bar_meterLeft;
 lv_obj_t *bar_meterRight;
 
+lv_obj_t *chart_specPeak[2];
+lv_chart_series_t *ser_specPeak[2];
+lv_obj_t *chart_specLevel[2];
+lv_chart_series_t *ser_specLevel[2];
+
 lv_obj_t *chart_left;
 lv_chart_series_t *ser_left;
 lv_obj_t *chart_right;
@@ -38,6 +46,7 @@ lv_chart_series_t *ser_right;
 
 lv_obj_t *lb_playState;
 lv_obj_t *lb_volume;
+lv_obj_t *lb_crossfeed;
 
 void gui_player_init()
 {
@@ -213,6 +222,13 @@ void gui_player_init()
     hmsf_t b = (hmsf_t){4, 5, 6, 7};
     gui_setTime(a, b);
 
+    /***********************
+     * Gain reduction
+     */
+    lb_gainReduction = lv_label_create(area_player);
+    lv_obj_set_style_text_font(lb_gainReduction, LV_FONT_DEFAULT, LV_PART_MAIN);
+    gui_setGainReduction(0, 0);
+
     /***********************
      * Progress bar
      */
@@ -235,6 +251,13 @@ void gui_player_init()
     lv_obj_add_style(lb_volume, &style1, 0);
     gui_setVolume(99);
 
+    /***********************
+     * Crossfeed
+     */
+    lb_crossfeed = lv_label_create(area_bottomBar);
+    lv_obj_add_style(lb_crossfeed, &style1, 0);
+    gui_setCrossfeed(0);
+
     /***********************
      * Track number
      */
@@ -264,18 +287,18 @@ void gui_player_init()
     bar_meterLeft = lv_bar_create(area_left);
     lv_obj_add_style(bar_meterLeft, &style_bg, 0);
     lv_obj_add_style(bar_meterLeft, &style_indic, LV_PART_INDICATOR);
-    lv_bar_set_range(bar_meterLeft, 35, 90);
+    lv_bar_set_range(bar_meterLeft, GUI_METER_FLOOR_DB, 0);
     lv_obj_set_size(bar_meterLeft, size_meterWidth, AREA_OSCILLOSCOPE_HEIGHT);
     lv_obj_align_to(bar_meterLeft, area_left, LV_ALIGN_RIGHT_MID, 0, 0);
 
     bar_meterRight = lv_bar_create(area_right);
     lv_obj_add_style(bar_meterRight, &style_bg, 0);
     lv_obj_add_style(bar_meterRight, &style_indic, LV_PART_INDICATOR);
-    lv_bar_set_range(bar_meterRight, 35, 90);
+    lv_bar_set_range(bar_meterRight, GUI_METER_FLOOR_DB, 0);
     lv_obj_set_size(bar_meterRight, size_meterWidth, AREA_OSCILLOSCOPE_HEIGHT);
     lv_obj_align_to(bar_meterRight, area_right, LV_ALIGN_LEFT_MID, 0, 0);
 
-    gui_setMeter(56, 78);
+    gui_setMeter(-20, -10);
 
     /***********************
      * Oscilloscope
@@ -301,6 +324,59 @@ void gui_player_init()
     lv_color_t lineColor = lv_color_make(0x43, 0xd9, 0x96);
     int32_t maxPoint = 29000;
 
+    /***********************
+     * Spectrum
+     * 画在示波器下面: 峰值保持在最底层, 电平叠在上面, 示波器背景透明
+     * drawn under the oscilloscope: peak hold at the bottom, levels on top of it, and the
+     * oscilloscope background made transparent
+     */
+    lv_style_set_bg_opa(&style_oscilloscope, LV_OPA_TRANSP);
+
+    static lv_style_t style_spectrum;
+    lv_style_init(&style_spectrum);
+    lv_style_set_radius(&style_spectrum, 0);
+    lv_style_set_pad_all(&style_spectrum, 1);
+    lv_style_set_pad_column(&style_spectrum, 1);
+    lv_style_set_border_width(&style_spectrum, 0);
+    lv_style_set_bg_color(&style_spectrum, color_background);
+
+    lv_obj_t *specArea[2] = {area_left, area_right};
+    lv_align_t specAlign[2] = {LV_ALIGN_LEFT_MID, LV_ALIGN_RIGHT_MID};
+    for (int ch = 0; ch < 2; ch++)
+    {
+        for (int layer = 0; layer < 2; layer++)
+        {
+            lv_obj_t *chart = lv_chart_create(specArea[ch]);
+            lv_obj_add_style(chart, &style_spectrum, LV_PART_MAIN);
+            if (layer == 1)
+                lv_obj_set_style_bg_opa(chart, LV_OPA_TRANSP, LV_PART_MAIN);
+            lv_obj_set_size(chart, size_oscilloscopeWidth, size_oscilloscopeHeight);
+            lv_obj_align_to(chart, specArea[ch], specAlign[ch], (ch == 0) ? -1 : 1, 0);
+            lv_chart_set_type(chart, LV_CHART_TYPE_BAR);
+            lv_chart_set_div_line_count(chart, 0, 0);
+            lv_chart_set_point_count(chart, AUDIO_SPECTRUM_BANDS);
+            lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, AUDIO_SPECTRUM_RANGE_DB);
+
+            lv_color_t color = (layer == 0) ? lv_color_make(0x3a, 0x3a, 0x50) : lv_color_make(0x26, 0x4f, 0x78);
+            lv_chart_series_t *ser = lv_chart_add_series(chart, color, LV_CHART_AXIS_PRIMARY_Y);
+            lv_chart_set_all_value(chart, ser, 0);
+
+            if (layer == 0)
+            {
+                chart_specPeak[ch] = chart;
+                ser_specPeak[ch] = ser;
+            }
+            else
+            {
+                chart_specLevel[ch] = chart;
+                ser_specLevel[ch] = ser;
+            }
+        }
+    }
+
+    // 每个像素一列, 最大值和最小值交替成两个点, 连线就是这一列的竖线
+    // one column per pixel as alternating max and min points, so the line through them draws the
+    // column's vertical stroke
     chart_left = lv_chart_create(area_left);
     lv_obj_add_style(chart_left, &style_oscilloscope, LV_PART_MAIN);
     lv_obj_add_style(chart_left, &style_oscilloscopeLine, LV_PART_ITEMS);
@@ -308,8 +384,7 @@ void gui_player_init()
     lv_obj_set_size(chart_left, size_oscilloscopeWidth, size_oscilloscopeHeight);
     lv_obj_align_to(chart_left, area_left, LV_ALIGN_LEFT_MID, -1, 0);
     lv_chart_set_div_line_count(chart_left, 3, 6);
-    lv_chart_set_update_mode(chart_left, LV_CHART_UPDATE_MODE_SHIFT);
-    lv_chart_set_point_count(chart_left, size_oscilloscopeWidth);
+    lv_chart_set_point_count(chart_left, AUDIO_SCOPE_COLUMNS * 2);
     lv_chart_set_range(chart_left, LV_CHART_AXIS_PRIMARY_Y, -maxPoint, maxPoint);
 
     chart_right = lv_chart_create(area_right);
@@ -319,8 +394,7 @@ void gui_player_init()
     lv_obj_set_size(chart_right, size_oscilloscopeWidth, size_oscilloscopeHeight);
     lv_obj_align_to(chart_right, area_right, LV_ALIGN_RIGHT_MID, 1, 0);
     lv_chart_set_div_line_count(chart_right, 3, 6);
-    lv_chart_set_update_mode(chart_right, LV_CHART_UPDATE_MODE_SHIFT);
-    lv_chart_set_point_count(chart_right, size_oscilloscopeWidth);
+    lv_chart_set_point_count(chart_right, AUDIO_SCOPE_COLUMNS * 2);
     lv_chart_set_range(chart_right, LV_CHART_AXIS_PRIMARY_Y, -maxPoint, maxPoint);
 
     ser_left = lv_chart_add_series(chart_left, lineColor, LV_CHART_AXIS_PRIMARY_Y);
@@ -415,18 +489,44 @@ void gui_setTime(hmsf_t current, hmsf_t total)
     }
 }
 
-void gui_setProgress(uint32_t current, uint32_t total)
+// 压缩器/限幅器的增益衰减 (0.1dB), 显示两者中大的, 放在播放时间和总时长中间; 没有衰减时不显示,
+// 限幅器动作时变红
+// compressor/limiter gain reduction (0.1dB), the larger of the two, between the played time and
+// the duration; hidden with no reduction, red while the limiter acts
+void gui_setGainReduction(int comp, int limit)
 {
-    static uint32_t oldCurrent = 0;
-    static uint32_t oldToal    = 0;
+    static int oldReduction = -1;
+    static int oldLimiting = -1;
+    int reduction = (comp > limit) ? comp : limit;
+    int limiting = (limit > 0);
+
+    if (oldReduction == reduction && oldLimiting == limiting) return;
+    oldReduction = reduction; oldLimiting = limiting;
+
+    if (reduction == 0)
+        lv_label_set_text(lb_gainReduction, "");
+    else
+        lv_label_set_text_fmt(lb_gainReduction, "GR %d.%d", reduction / 10, reduction % 10);
+    if (limiting)
+        lv_obj_set_style_text_color(lb_gainReduction, lv_color_make(0xf5, 0x4d, 0x46), LV_PART_MAIN);
+    else
+        lv_obj_set_style_text_color(lb_gainReduction, lv_color_make(0x9c, 0xdc, 0xfe), LV_PART_MAIN);
+    lv_obj_align_to(lb_gainReduction, area_player, LV_ALIGN_BOTTOM_MID, 0, -20);
+}
 
-    if (oldCurrent == current && oldToal == total) return;
-    oldCurrent = current; oldToal = total;
+// 按像素比较, 位置每个扇区都在变, 进度条要好几秒才走一个像素
+// compared in pixels: the position moves every sector, the bar only a pixel every few seconds
+void gui_setProgress(uint32_t current, uint32_t total)
+{
+    static int32_t oldPixel = -1;
 
-    if (total == 0) total = 1234; // avoid divide-by-zero
+    lv_coord_t width = lv_obj_get_width(bar_playProgress);
+    int32_t pixel = (total == 0) ? 0 : (int32_t)((uint64_t)current * width / total); // avoid divide-by-zero
+    if (oldPixel == pixel) return;
+    oldPixel = pixel;
 
-    lv_bar_set_range(bar_playProgress, 0, total);
-    lv_bar_set_value(bar_playProgress, current, LV_ANIM_OFF);
+    lv_bar_set_range(bar_playProgress, 0, width);
+    lv_bar_set_value(bar_playProgress, pixel, LV_ANIM_OFF);
 }
 
 void gui_setPlayState(const char *str)
@@ -447,6 +547,21 @@ void gui_setVolume(int vol)
     lv_obj_align_to(lb_volume, area_bottomBar, LV_ALIGN_RIGHT_MID, -5, 0);
 }
 
+// 交叉馈送强度, 关闭时不显示, 放在音量左边
+// crossfeed strength, hidden when off, left of the volume
+void gui_setCrossfeed(int level)
+{
+    static int oldLevel = -1;
+    if (oldLevel == level) return;
+
+    oldLevel = level;
+    if (level == 0)
+        lv_label_set_text(lb_crossfeed, "");
+    else
+        lv_label_set_text_fmt(lb_crossfeed, "XF%d", level);
+    lv_obj_align_to(lb_crossfeed, lb_volume, LV_ALIGN_OUT_LEFT_MID, -8, 0);
+}
+
 void gui_setTrackNum(int current, int total)
 {
     static int oldCurrent = -1;
@@ -463,6 +578,37 @@ void gui_setTrackNum(int current, int total)
     lv_obj_align_to(lb_trackNumber, area_bottomBar, LV_ALIGN_CENTER, 0, 0);
 }
 
+void gui_setSpectrum(const audio_spectrum_frame_t *frame)
+{
+    for (int ch = 0; ch < 2; ch++)
+    {
+        for (int b = 0; b < AUDIO_SPECTRUM_BANDS; b++)
+        {
+            ser_specPeak[ch]->y_points[b] = frame->peak[ch][b];
+            ser_specLevel[ch]->y_points[b] = frame->level[ch][b];
+        }
+        lv_chart_refresh(chart_specPeak[ch]);
+        lv_chart_refresh(chart_specLevel[ch]);
+    }
+}
+
+void gui_setScope(const audio_scope_frame_t *frame)
+{
+    lv_chart_series_t *ser[2] = {ser_left, ser_right};
+    for (int ch = 0; ch < 2; ch++)
+    {
+        for (int i = 0; i < AUDIO_SCOPE_COLUMNS; i++)
+        {
+            ser[ch]->y_points[i * 2] = frame->max[ch][i];
+            ser[ch]->y_points[i * 2 + 1] = frame->min[ch][i];
+        }
+    }
+    lv_chart_refresh(chart_left);
+    lv_chart_refresh(chart_right);
+}
+
+// 峰值 dBFS
+// peak in dBFS
 void gui_setMeter(int l, int r)
 {
     static int oldL = -1;
@@ -471,3 +617,24 @@ void gui_setMeter(int l, int r)
     if (oldL != l) { oldL = l; lv_bar_set_value(bar_meterLeft,  l, LV_ANIM_OFF); }
     if (oldR != r) { oldR = r; lv_bar_set_value(bar_meterRight, r, LV_ANIM_OFF); }
 }
+
+// 削波时电平表底色变红
+// the meter background turns red on a clip
+void gui_setClip(bool l, bool r)
+{
+    static int oldL = -1;
+    static int oldR = -1;
+    lv_obj_t *bars[2] = {bar_meterLeft, bar_meterRight};
+    int *old[2] = {&oldL, &oldR};
+    bool now[2] = {l, r};
+
+    for (int ch = 0; ch < 2; ch++)
+    {
+        if (*old[ch] == now[ch]) continue;
+        *old[ch] = now[ch];
+        if (now[ch])
+            lv_obj_set_style_bg_color(bars[ch], lv_color_make(0xd0, 0x20, 0x20), LV_PART_MAIN);
+        else
+            lv_obj_remove_local_style_prop(bars[ch], LV_STYLE_BG_COLOR, LV_PART_MAIN);
+    }
+}
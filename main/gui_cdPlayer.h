@@ -1,6 +1,10 @@
 ﻿#ifndef __GUI_CD_PLAYER_H_
 #define __GUI_CD_PLAYER_H_
 
+// 电平表下限 dBFS
+// bottom of the level meter in dBFS
+#define GUI_METER_FLOOR_DB (-55)
+
 extern lv_obj_t *chart_left;
 extern lv_chart_series_t *ser_left;
 extern lv_obj_t *chart_right;
@@ -20,7 +24,12 @@ void gui_setTime(hmsf_t current, hmsf_t total);
 void gui_setProgress(uint32_t current, uint32_t total);
 void gui_setPlayState(const char *str);
 void gui_setVolume(int vol);
+void gui_setCrossfeed(int level);
 void gui_setTrackNum(int current, int total);
 void gui_setMeter(int l, int r);
+void gui_setClip(bool l, bool r);
+void gui_setGainReduction(int comp, int limit);
+void gui_setSpectrum(const audio_spectrum_frame_t *frame);
+void gui_setScope(const audio_scope_frame_t *frame);
 
 #endif
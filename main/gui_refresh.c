@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "lvgl.h"
+#include "usbhost_driver.h"
+#include "cdPlayer.h"
+#include "i2s.h"
+#include "audio_spectrum.h"
+#include "audio_meter.h"
+#include "audio_scope.h"
+#include "gui_cdPlayer.h"
+#include "gui_refresh.h"
+
+// 削波指示保持时间
+// how long the clip indicator stays lit
+#define CLIP_HOLD_MS 1000
+// 增益衰减每隔这么久取一次, 显示的是这段时间里的最大值
+// how often the gain reduction is taken; what shows is the largest in that time
+#define GR_PERIOD_MS 250
+
+// 界面只刷新状态版本号变了的部件; 示波器, 电平表和频谱是连续的数据, 有新帧就取
+// the GUI only refreshes widgets whose state version moved; scope, meter and spectrum are
+// streams and are taken whenever there is a new frame
+static uint32_t guiSeen[CDPLAYER_STATE_GROUPS];
+static uint32_t spectrumSeq = 0;
+static audio_spectrum_frame_t spectrum;
+static audio_meter_snapshot_t meter;
+static uint32_t clipSeen[2] = {0, 0};
+static TickType_t clipUntil[2] = {0, 0};
+static TickType_t grTaken = 0;
+
+static bool stateChanged(cdplayer_stateGroup_t group)
+{
+    uint32_t v = cdplayer_stateVersion[group];
+    if (v == guiSeen[group])
+        return false;
+    guiSeen[group] = v;
+    return true;
+}
+
+void gui_refreshAll()
+{
+    for (int i = 0; i < CDPLAYER_STATE_GROUPS; i++)
+        guiSeen[i] = cdplayer_stateVersion[i] - 1;
+}
+
+void gui_refresh()
+{
+    char str[100];
+
+    bool drive = stateChanged(CDPLAYER_STATE_DRIVE);
+    bool disc = stateChanged(CDPLAYER_STATE_DISC);
+    // 换了碟, 音轨相关的全部重来; 换了音轨, 总时长跟着变
+    // a new disc redoes everything about the track; a new track changes the duration
+    bool track = stateChanged(CDPLAYER_STATE_TRACK) || disc;
+    bool transport = stateChanged(CDPLAYER_STATE_TRANSPORT) || disc;
+    bool position = stateChanged(CDPLAYER_STATE_POSITION) || track;
+
+    if (drive)
+    {
+        // 光驱型号
+        // cd drive model
+        sprintf(str, "%s-%s", cdplayer_driveInfo.vendor, cdplayer_driveInfo.product);
+        gui_setDriveModel(str);
+
+        // 碟状态
+        // disc state
+        if (usbhost_driverObj.deviceIsOpened == 0)
+            gui_setDriveState("No drive");
+        else if (cdplayer_driveInfo.trayClosed == 0)
+            gui_setDriveState("Tray open");
+        else if (cdplayer_driveInfo.discInserted == 0)
+            gui_setDriveState("No disc");
+        else if (cdplayer_driveInfo.discIsCD == 0)
+            gui_setDriveState("Not cdda");
+        else
+            gui_setDriveState("Ready");
+    }
+
+    // 音量
+    // volume
+    if (stateChanged(CDPLAYER_STATE_VOLUME))
+        gui_setVolume(cdplayer_playerInfo.volume);
+
+    // 交叉馈送
+    // crossfeed
+    if (stateChanged(CDPLAYER_STATE_CROSSFEED))
+        gui_setCrossfeed(cdplayer_playerInfo.crossfeed);
+
+    if (cdplayer_driveInfo.readyToPlay)
+    {
+        int8_t trackI = cdplayer_playerInfo.playingTrackIndex;
+
+        // 播放状态
+        // play state
+        if (transport)
+        {
+            if (cdplayer_playerInfo.fastForwarding)
+                gui_setPlayState(">>>");
+            else if (cdplayer_playerInfo.fastBackwarding)
+                gui_setPlayState("<<<");
+            else if (cdplayer_playerInfo.playing)
+                gui_setPlayState(LV_SYMBOL_PLAY);
+            else
+                gui_setPlayState(LV_SYMBOL_PAUSE);
+        }
+
+        // 碟名
+        // album title and performer
+        if (disc)
+        {
+            if (cdplayer_driveInfo.cdTextAvalibale)
+            {
+                sprintf(str, "%s - %s", cdplayer_driveInfo.albumTitle, cdplayer_driveInfo.albumPerformer);
+                gui_setAlbumTitle(str);
+            }
+            else
+            {
+                gui_setAlbumTitle("");
+            }
+        }
+
+        if (track)
+        {
+            // 预加重
+            // pre-emphasis
+            if (cdplayer_driveInfo.trackList[trackI].preEmphasis)
+                gui_setEmphasis(true);
+            else
+                gui_setEmphasis(false);
+
+            // 轨名 歌手
+            // track title and performer
+            if (cdplayer_driveInfo.cdTextAvalibale)
+            {
+                gui_setTrackTitle(
+                    cdplayer_driveInfo.trackList[trackI].title,
+                    cdplayer_driveInfo.trackList[trackI].performer);
+            }
+            else
+            {
+                sprintf(str, "Track %02d", cdplayer_driveInfo.trackList[trackI].trackNum);
+                gui_setTrackTitle(str, "");
+            }
+
+            // 轨号
+            // track number
+            gui_setTrackNum(trackI + 1, cdplayer_driveInfo.trackCount);
+        }
+
+        if (position)
+        {
+            // 播放时长
+            // played time
+            gui_setTime(
+                cdplay_frameToHmsf(cdplayer_playerInfo.readFrameCount),
+                cdplay_frameToHmsf(cdplayer_driveInfo.trackList[trackI].trackDuration));
+
+            // 播放进度
+            // play progress bar
+            gui_setProgress(
+                cdplayer_playerInfo.readFrameCount,
+                cdplayer_driveInfo.trackList[trackI].trackDuration);
+        }
+
+        // 示波器, 音频线程攒满一屏才有新的, 每帧最多取一次
+        // oscilloscope; a new screen only appears once the audio thread has filled one, taken
+        // at most once per frame
+        const audio_scope_frame_t *scope = audio_scope_read();
+        if (scope)
+            gui_setScope(scope);
+
+        // 电平表, 音频线程算好的峰值; 暂停时落到底
+        // level meter from the peaks computed on the audio thread; drops to the floor when paused
+        if (cdplayer_playerInfo.playing)
+        {
+            if (audio_meter_read(&meter))
+            {
+                gui_setMeter(lroundf(meter.peak[0]), lroundf(meter.peak[1]));
+
+                // 有新的削波时亮 1 秒
+                // lights up for a second on a new clip
+                TickType_t now = xTaskGetTickCount();
+                for (int ch = 0; ch < 2; ch++)
+                {
+                    if (meter.clips[ch] != clipSeen[ch])
+                    {
+                        clipSeen[ch] = meter.clips[ch];
+                        clipUntil[ch] = now + pdMS_TO_TICKS(CLIP_HOLD_MS);
+                    }
+                }
+                gui_setClip((int32_t)(clipUntil[0] - now) > 0, (int32_t)(clipUntil[1] - now) > 0);
+            }
+
+            // 压缩器/限幅器的增益衰减
+            // compressor/limiter gain reduction
+            TickType_t now = xTaskGetTickCount();
+            if (now - grTaken >= pdMS_TO_TICKS(GR_PERIOD_MS))
+            {
+                uint16_t comp, limit;
+                i2s_takeGainReduction(&comp, &limit);
+                gui_setGainReduction(comp, limit);
+                grTaken = now;
+            }
+        }
+        else
+        {
+            gui_setMeter(GUI_METER_FLOOR_DB, GUI_METER_FLOOR_DB);
+            gui_setClip(false, false);
+            gui_setGainReduction(0, 0);
+        }
+    }
+    else if (disc)
+    {
+        // 没有可播的碟, 只在变成这样的那一轮清一次
+        // nothing to play; cleared once, on the round it became so
+        gui_setPlayState(LV_SYMBOL_STOP);
+        gui_setAlbumTitle("");
+        gui_setEmphasis(false);
+        gui_setTrackTitle("(=^_^=)", "");
+        gui_setTime(cdplay_frameToHmsf(0), cdplay_frameToHmsf(0));
+        gui_setProgress(0, 0);
+        gui_setTrackNum(0, 0);
+        gui_setMeter(GUI_METER_FLOOR_DB, GUI_METER_FLOOR_DB);
+        gui_setClip(false, false);
+        gui_setGainReduction(0, 0);
+        lv_chart_set_all_value(chart_left, ser_left, 0);
+        lv_chart_set_all_value(chart_right, ser_right, 0);
+    }
+
+    // 频谱, 停止后没有新数据, 自己落到底
+    // spectrum; with no new data after stopping it falls to the floor on its own
+    if (audio_spectrum_read(&spectrum, &spectrumSeq))
+        gui_setSpectrum(&spectrum);
+}
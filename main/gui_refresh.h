@@ -0,0 +1,14 @@
+#ifndef __GUI_REFRESH_H_
+#define __GUI_REFRESH_H_
+
+// 界面线程的一轮: 按状态版本号刷新变了的部件, 再取示波器, 电平表, 增益衰减和频谱的新数据; 之后由调用者跑
+// lv_timer_handler(). 主机上的重画测试也调用它
+// one round of the GUI task: refreshes the widgets whose state version moved, then takes new
+// scope, meter, gain reduction and spectrum data; the caller runs lv_timer_handler() afterwards.
+// The host redraw test calls it as well
+void gui_refresh();
+// 下一轮全部刷新
+// the next round refreshes everything
+void gui_refreshAll();
+
+#endif
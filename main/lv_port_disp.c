@@ -11,6 +11,8 @@
  *********************/
 #include "lv_port_disp.h"
 #include <stdbool.h>
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "st7789.h"
 
 #include <stdio.h>
@@ -32,12 +34,16 @@
 static void disp_init(void);
 
 static void disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
+static void disp_monitor(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px);
+static void disp_wait(lv_disp_drv_t *disp_drv);
 // static void gpu_fill(lv_disp_drv_t * disp_drv, lv_color_t * dest_buf, lv_coord_t dest_width,
 //         const lv_area_t * fill_area, lv_color_t color);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static uint32_t disp_redrawPixels = 0;
+static int64_t disp_waitUs = 0;
 
 /**********************
  *      MACROS
@@ -79,16 +85,17 @@ void lv_port_disp_init(void)
      *      and you only need to change the frame buffer's address.
      */
 
-    /* Example for 1) */
-    static lv_disp_draw_buf_t draw_buf_dsc_1;
-    static lv_color_t buf_1[MY_DISP_HOR_RES * 80];                             /*A buffer for 10 rows*/
-    lv_disp_draw_buf_init(&draw_buf_dsc_1, buf_1, NULL, MY_DISP_HOR_RES * 80); /*Initialize the display buffer*/
+    // /* Example for 1) */
+    // static lv_disp_draw_buf_t draw_buf_dsc_1;
+    // static lv_color_t buf_1[MY_DISP_HOR_RES * 10];                             /*A buffer for 10 rows*/
+    // lv_disp_draw_buf_init(&draw_buf_dsc_1, buf_1, NULL, MY_DISP_HOR_RES * 10); /*Initialize the display buffer*/
 
-    // /* Example for 2) */
-    // static lv_disp_draw_buf_t draw_buf_dsc_2;
-    // static lv_color_t buf_2_1[MY_DISP_HOR_RES * 10];                                /*A buffer for 10 rows*/
-    // static lv_color_t buf_2_2[MY_DISP_HOR_RES * 10];                                /*An other buffer for 10 rows*/
-    // lv_disp_draw_buf_init(&draw_buf_dsc_2, buf_2_1, buf_2_2, MY_DISP_HOR_RES * 10); /*Initialize the display buffer*/
+    /* Example for 2)
+     * LVGL draws into one buffer while DMA sends the other, same memory as the old single 80-row buffer */
+    static lv_disp_draw_buf_t draw_buf_dsc_2;
+    static DMA_ATTR lv_color_t buf_2_1[MY_DISP_HOR_RES * LCD_DRAW_ROWS];                      /*A buffer for 40 rows*/
+    static DMA_ATTR lv_color_t buf_2_2[MY_DISP_HOR_RES * LCD_DRAW_ROWS];                      /*An other buffer for 40 rows*/
+    lv_disp_draw_buf_init(&draw_buf_dsc_2, buf_2_1, buf_2_2, MY_DISP_HOR_RES * LCD_DRAW_ROWS); /*Initialize the display buffer*/
 
     // /* Example for 3) also set disp_drv.full_refresh = 1 below*/
     // static lv_disp_draw_buf_t draw_buf_dsc_3;
@@ -113,8 +120,14 @@ void lv_port_disp_init(void)
     /*Used to copy the buffer's content to the display*/
     disp_drv.flush_cb = disp_flush;
 
+    /*Count the redrawn area for profiling*/
+    disp_drv.monitor_cb = disp_monitor;
+
+    /*Block while LVGL waits for a buffer to be flushed, instead of spinning on 'flushing'*/
+    disp_drv.wait_cb = disp_wait;
+
     /*Set a display buffer*/
-    disp_drv.draw_buf = &draw_buf_dsc_1;
+    disp_drv.draw_buf = &draw_buf_dsc_2;
 
     /*Required for Example 3)*/
     // disp_drv.full_refresh = 1;
@@ -154,34 +167,63 @@ void disp_disable_update(void)
     disp_flush_enabled = false;
 }
 
-/*Flush the content of the internal buffer the specific area on the display
- *You can use DMA or any hardware acceleration to do this operation in the background but
- *'lv_disp_flush_ready()' has to be called when finished.*/
-static void disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
+/* Pixels redrawn since the last call, for profiling; call from the LVGL task
+ */
+uint32_t disp_takeRedrawPixels(void)
 {
-    if (disp_flush_enabled)
-    {
-        /*The most simple case (but also the slowest) to put all pixels to the screen one-by-one*/
-        lcd_set_window(area->x1, area->y1, area->x2, area->y2);
-
-        uint32_t windowPixCount = (area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1);
+    uint32_t px = disp_redrawPixels;
+    disp_redrawPixels = 0;
+    return px;
+}
 
-        for (int i = 0; i < windowPixCount; i++)
-            (color_p + i)->full = __builtin_bswap16((color_p + i)->full);
+/* Time blocked in disp_wait() since the last call in us, for profiling; call from the LVGL task
+ */
+uint32_t disp_takeWaitUs(void)
+{
+    uint32_t us = (uint32_t)disp_waitUs;
+    disp_waitUs = 0;
+    return us;
+}
 
-        while (windowPixCount > 0)
-        {
-            uint32_t tranPix = windowPixCount > 2000 ? 2000 : windowPixCount; // spi dma max 4092
-            lcd_write_data_batch((uint8_t *)color_p, tranPix * 2);
+/*Called by LVGL after every refresh with the time it took and the pixels it redrew*/
+static void disp_monitor(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px)
+{
+    disp_redrawPixels += px;
+}
 
-            windowPixCount -= tranPix;
-            color_p += tranPix;
-        }
-    }
+/*Called by LVGL while both buffers are in use and it has to wait for a flush to finish.
+ *lcd_waitFlush() sleeps on the SPI result queue until the last transaction is back; its post
+ *callback has called lv_disp_flush_ready() by then, so 'flushing' is already clear on return*/
+static void disp_wait(lv_disp_drv_t *disp_drv)
+{
+    int64_t t0 = esp_timer_get_time();
+    lcd_waitFlush();
+    disp_waitUs += esp_timer_get_time() - t0;
+}
 
+/*Called from the SPI interrupt once the last pixel is out*/
+static void disp_flush_done(void *arg)
+{
     /*IMPORTANT!!!
      *Inform the graphics library that you are ready with the flushing*/
-    lv_disp_flush_ready(disp_drv);
+    lv_disp_flush_ready((lv_disp_drv_t *)arg);
+}
+
+/*Flush the content of the internal buffer the specific area on the display
+ *The pixels go out by DMA in the background and 'lv_disp_flush_ready()' is called from the SPI
+ *interrupt when finished. LV_COLOR_16_SWAP makes LVGL render in the panel's big-endian order,
+ *so the buffer is sent as it is*/
+static void disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    if (!disp_flush_enabled)
+    {
+        lv_disp_flush_ready(disp_drv);
+        return;
+    }
+
+    uint32_t windowPixCount = (area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1);
+    lcd_flushAsync(area->x1, area->y1, area->x2, area->y2, color_p, windowPixCount * sizeof(lv_color_t),
+                   disp_flush_done, disp_drv);
 }
 
 #else /*Enable this file at the top*/
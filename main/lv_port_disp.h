@@ -44,6 +44,14 @@ void disp_enable_update(void);
  */
 void disp_disable_update(void);
 
+/* Pixels redrawn since the last call, for profiling; call from the LVGL task
+ */
+uint32_t disp_takeRedrawPixels(void);
+
+/* Time blocked waiting for a flush since the last call in us, for profiling; call from the LVGL task
+ */
+uint32_t disp_takeWaitUs(void);
+
 /**********************
  *      MACROS
  **********************/
@@ -19,6 +19,7 @@
 #include "i2s.h"
 #include "usbhost_driver.h"
 #include "cdPlayer.h"
+#include "audio_bench.h"
 
 void app_main(void)
 {
@@ -82,6 +83,10 @@ void app_main(void)
     iic_init();
     ESP_LOGI("app_main", "Init i2s");
     i2s_init();
+#if AUDIO_BENCH_ENABLE
+    ESP_LOGI("app_main", "Run audio benchmark");
+    audio_bench_run();
+#endif
     ESP_LOGI("app_main", "Init BT A2DP");
     bt_a2dp_init();
     ESP_LOGI("app_main", "Init button");
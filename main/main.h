@@ -28,14 +28,8 @@
 #define LEDC_CHANNEL   LEDC_CHANNEL_0
 #define LEDC_DUTY_RES  LEDC_TIMER_12_BIT
 
-typedef struct {
-    int16_t l;
-    int16_t r;
-} ChannelValue_t;
-
 /* 在 main.c（或别处）里定义；这里做 extern 声明即可 */
 extern QueueHandle_t queue_meter;
-extern QueueHandle_t queue_oscilloscope;
 
 void task_oled(void *args);
 void task_lvgl(void *args);
@@ -1,5 +1,4 @@
 #include <stdio.h>
-#include <math.h>
 #include <inttypes.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
@@ -11,16 +10,17 @@
 #include "esp_flash.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "main.h"
 #include "lvgl.h"
 #include "lv_port_disp.h"
 #include "st7789.h"
-#include "usbhost_driver.h"
 #include "cdPlayer.h"
+#include "audio_spectrum.h"
+#include "audio_scope.h"
 #include "gui_cdPlayer.h"
-
-QueueHandle_t queue_oscilloscope = NULL;
+#include "gui_refresh.h"
 
 // 定时器回调
 // timer interrupt handler
@@ -30,10 +30,29 @@ static bool IRAM_ATTR gpTimer_alarm_cb(gptimer_handle_t timer, const gptimer_ala
     return false;
 }
 
-void task_lvgl(void *args)
+// 频谱分析按显示帧率跑在 core 0, 和界面分开, 界面只取最新一帧
+// the spectrum analyzer runs at display rate on core 0, apart from the GUI, which only takes the
+// newest frame
+#define SPECTRUM_PERIOD_MS 33
+// 置 1 后定期打印界面线程的忙碌占比 (循环体的墙上时间减去等屏幕刷完的时间, 含被抢占), 等屏幕的占比和每秒重画的像素
+// set to 1 to log the GUI task's busy share (wall time in the loop body less the time blocked on
+// the panel flush, preemption included), the share blocked on the panel and the pixels redrawn
+// per second periodically
+#define GUI_PROFILE 0
+#define GUI_PROFILE_PERIOD_US 10000000
+
+static void task_spectrum(void *args)
 {
-    queue_oscilloscope = xQueueCreate(500, sizeof(ChannelValue_t));
+    TickType_t lastWake = xTaskGetTickCount();
+    while (1)
+    {
+        audio_spectrum_analyze();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SPECTRUM_PERIOD_MS));
+    }
+}
 
+void task_lvgl(void *args)
+{
     ESP_LOGI("task_lvgl", "lcd_init");
     lcd_init();
 
@@ -73,151 +92,51 @@ void task_lvgl(void *args)
     ESP_LOGI("task_lvgl", "gui_player_init.");
     gui_player_init();
 
-    char str[100];
+    BaseType_t taskCreatRet = xTaskCreatePinnedToCore(task_spectrum,
+                                                      "spectrum",
+                                                      3072,
+                                                      NULL,
+                                                      1,
+                                                      NULL,
+                                                      0);
+    if (taskCreatRet != pdPASS)
+        ESP_LOGE("task_lvgl", "TaskCreate task_spectrum -> fail");
+
+    // 第一轮全部刷新
+    // everything refreshes on the first round
+    gui_refreshAll();
+#if GUI_PROFILE
+    int64_t profileStart = esp_timer_get_time();
+    int64_t profileBusy = 0;
+    disp_takeRedrawPixels();
+    disp_takeWaitUs();
+#endif
+
     while (1)
     {
-        // 光驱型号
-        // cd drive model
-        sprintf(str, "%s-%s", cdplayer_driveInfo.vendor, cdplayer_driveInfo.product);
-        gui_setDriveModel(str);
-
-        // 碟状态
-        // disc state
-        if (usbhost_driverObj.deviceIsOpened == 0)
-            gui_setDriveState("No drive");
-        else if (cdplayer_driveInfo.trayClosed == 0)
-            gui_setDriveState("Tray open");
-        else if (cdplayer_driveInfo.discInserted == 0)
-            gui_setDriveState("No disc");
-        else if (cdplayer_driveInfo.discIsCD == 0)
-            gui_setDriveState("Not cdda");
-        else
-            gui_setDriveState("Ready");
-
-        // 音量
-        // volume
-        gui_setVolume(cdplayer_playerInfo.volume);
-
-        if (cdplayer_driveInfo.readyToPlay)
-        {
-            int8_t trackI = cdplayer_playerInfo.playingTrackIndex;
-
-            // 播放状态
-            // play state
-            if (cdplayer_playerInfo.fastForwarding)
-                gui_setPlayState(">>>");
-            else if (cdplayer_playerInfo.fastBackwarding)
-                gui_setPlayState("<<<");
-            else if (cdplayer_playerInfo.playing)
-                gui_setPlayState(LV_SYMBOL_PLAY);
-            else
-                gui_setPlayState(LV_SYMBOL_PAUSE);
+#if GUI_PROFILE
+        int64_t t0 = esp_timer_get_time();
+#endif
+        gui_refresh();
 
-            // 碟名
-            // album title and performer
-            if (cdplayer_driveInfo.cdTextAvalibale)
-            {
-                sprintf(str, "%s - %s", cdplayer_driveInfo.albumTitle, cdplayer_driveInfo.albumPerformer);
-                gui_setAlbumTitle(str);
-            }
-            else
-            {
-                gui_setAlbumTitle("");
-            }
-
-            // 预加重
-            // pre-emphasis
-            if (cdplayer_driveInfo.trackList[trackI].preEmphasis)
-                gui_setEmphasis(true);
-            else
-                gui_setEmphasis(false);
-
-            // 轨名 歌手
-            // track title and performer
-            if (cdplayer_driveInfo.cdTextAvalibale)
-            {
-                gui_setTrackTitle(
-                    cdplayer_driveInfo.trackList[trackI].title,
-                    cdplayer_driveInfo.trackList[trackI].performer);
-            }
-            else
-            {
-                sprintf(str, "Track %02d", cdplayer_driveInfo.trackList[trackI].trackNum);
-                gui_setTrackTitle(str, "");
-            }
-
-            // 播放时长
-            // played time
-            gui_setTime(
-                cdplay_frameToHmsf(cdplayer_playerInfo.readFrameCount),
-                cdplay_frameToHmsf(cdplayer_driveInfo.trackList[trackI].trackDuration));
-
-            // 播放进度
-            // play progress bar
-            gui_setProgress(
-                cdplayer_playerInfo.readFrameCount,
-                cdplayer_driveInfo.trackList[trackI].trackDuration);
-
-            // 轨号
-            // track number
-            gui_setTrackNum(trackI + 1, cdplayer_driveInfo.trackCount);
-
-            // 示波器 电平表
-            // oscilloscope and level meter
-            static int count = 0;
-            static int32_t maxL = 0;
-            static int32_t maxR = 0;
-            ChannelValue_t oscilloscopePoint;
-            while (xQueueReceive(queue_oscilloscope, &oscilloscopePoint, 0) == pdTRUE)
-            {
-                // lv_chart_set_next_value(chart_left, ser_left, oscilloscopePoint.l);
-                // lv_chart_set_next_value(chart_right, ser_right, oscilloscopePoint.r);
-                int pointCount = ((lv_chart_t *)chart_left)->point_cnt;
-                for (int i = 0; i < pointCount - 1; i++)
-                {
-                    ser_left->y_points[i] = ser_left->y_points[i + 1];
-                    ser_right->y_points[i] = ser_right->y_points[i + 1];
-                }
-                ser_left->y_points[pointCount - 1] = oscilloscopePoint.l;
-                ser_right->y_points[pointCount - 1] = oscilloscopePoint.r;
-
-                if (oscilloscopePoint.l > maxL)
-                    maxL = oscilloscopePoint.l;
-                if (oscilloscopePoint.r > maxR)
-                    maxR = oscilloscopePoint.r;
-
-                if ((++count) == 100)
-                {
-                    count = 0;
-                    lv_chart_refresh(chart_left);
-                    lv_chart_refresh(chart_right);
-
-                    double dbL = 20 * log10(maxL);
-                    double dbR = 20 * log10(maxR);
-                    maxL = 0;
-                    maxR = 0;
+        lv_timer_handler();
 
-                    gui_setMeter(dbL, dbR);
-                    // gui_setMeter(maxR, maxL);
-                    break;
-                }
-            }
-        }
-        else
+#if GUI_PROFILE
+        int64_t t1 = esp_timer_get_time();
+        profileBusy += t1 - t0;
+        if (t1 - profileStart >= GUI_PROFILE_PERIOD_US)
         {
-            gui_setPlayState(LV_SYMBOL_STOP);
-            gui_setAlbumTitle("");
-            gui_setEmphasis(false);
-            gui_setTrackTitle("(=^_^=)", "");
-            gui_setTime(cdplay_frameToHmsf(0), cdplay_frameToHmsf(0));
-            gui_setProgress(0, 0);
-            gui_setTrackNum(0, 0);
-            gui_setMeter(0, 0);
-            lv_chart_set_all_value(chart_left, ser_left, 0);
-            lv_chart_set_all_value(chart_right, ser_right, 0);
+            int64_t wait = disp_takeWaitUs();
+            uint32_t permille = (uint32_t)((profileBusy - wait) * 1000 / (t1 - profileStart));
+            uint32_t waitPermille = (uint32_t)(wait * 1000 / (t1 - profileStart));
+            uint32_t px = disp_takeRedrawPixels();
+            ESP_LOGI("task_lvgl", "busy %lu.%lu%%, waiting on the panel %lu.%lu%%, redrawn %lu px/s", permille / 10,
+                     permille % 10, waitPermille / 10, waitPermille % 10,
+                     (uint32_t)((int64_t)px * 1000000 / (t1 - profileStart)));
+            profileStart = t1;
+            profileBusy = 0;
         }
-
-        lv_timer_handler();
+#endif
         vTaskDelay(pdMS_TO_TICKS(15));
     }
 }
\ No newline at end of file